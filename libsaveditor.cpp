@@ -0,0 +1,2927 @@
+/*
+	Notes:
+		 -> libsaveditor, see saveditor.h for the interface
+*/
+
+#include <algorithm>
+#include <bit>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "saveditor.h"
+#include "saveditor_internal.h"
+
+using namespace std;
+
+// - - - Game Data Tables - - - //
+
+/* Notes:
+	-> Names are stored once, in ID order, so looking up a name from an ID is a plain array access
+	-> Looking up an ID from a name goes through a perfect hash built at compile time (hash and displace):
+		- every name falls into a bucket by its hash with seed 0
+		- each bucket stores the seed that sends all of its names to distinct free slots
+		- a lookup hashes the name twice and does one string comparison, without allocating
+*/
+
+struct MoveData {
+	string_view name;
+	int pp;
+};
+
+// Species names in national dex order, the species ID is the index + 1
+constexpr string_view speciesNames[] = {
+	"Bulbasaur", "Ivysaur", "Venusaur", "Charmander", "Charmeleon", "Charizard", "Squirtle", "Wartortle", "Blastoise", "Caterpie", // 1 - 10
+	"Metapod", "Butterfree", "Weedle", "Kakuna", "Beedrill", "Pidgey", "Pidgeotto", "Pidgeot", "Rattata", "Raticate", // 11 - 20
+	"Spearow", "Fearow", "Ekans", "Arbok", "Pikachu", "Raichu", "Sandshrew", "Sandslash", "NidoranF", "Nidorina", // 21 - 30
+	"Nidoqueen", "NidoranM", "Nidorino", "Nidoking", "Clefairy", "Clefable", "Vulpix", "Ninetales", "Jigglypuff", "Wigglytuff", // 31 - 40
+	"Zubat", "Golbat", "Oddish", "Gloom", "Vileplume", "Paras", "Parasect", "Venonat", "Venomoth", "Diglett", // 41 - 50
+	"Dugtrio", "Meowth", "Persian", "Psyduck", "Golduck", "Mankey", "Primeape", "Growlithe", "Arcanine", "Poliwag", // 51 - 60
+	"Poliwhirl", "Poliwrath", "Abra", "Kadabra", "Alakazam", "Machop", "Machoke", "Machamp", "Bellsprout", "Weepinbell", // 61 - 70
+	"Victreebel", "Tentacool", "Tentacruel", "Geodude", "Graveler", "Golem", "Ponyta", "Rapidash", "Slowpoke", "Slowbro", // 71 - 80
+	"Magnemite", "Magneton", "Farfetch'd", "Doduo", "Dodrio", "Seel", "Dewgong", "Grimer", "Muk", "Shellder", // 81 - 90
+	"Cloyster", "Gastly", "Haunter", "Gengar", "Onix", "Drowzee", "Hypno", "Krabby", "Kingler", "Voltorb", // 91 - 100
+	"Electrode", "Exeggcute", "Exeggutor", "Cubone", "Marowak", "Hitmonlee", "Hitmonchan", "Lickitung", "Koffing", "Weezing", // 101 - 110
+	"Rhyhorn", "Rhydon", "Chansey", "Tangela", "Kangaskhan", "Horsea", "Seadra", "Goldeen", "Seaking", "Staryu", // 111 - 120
+	"Starmie", "Mr. Mime", "Scyther", "Jynx", "Electabuzz", "Magmar", "Pinsir", "Tauros", "Magikarp", "Gyarados", // 121 - 130
+	"Lapras", "Ditto", "Eevee", "Vaporeon", "Jolteon", "Flareon", "Porygon", "Omanyte", "Omastar", "Kabuto", // 131 - 140
+	"Kabutops", "Aerodactyl", "Snorlax", "Articuno", "Zapdos", "Moltres", "Dratini", "Dragonair", "Dragonite", "Mewtwo", // 141 - 150
+	"Mew", "Chikorita", "Bayleef", "Meganium", "Cyndaquil", "Quilava", "Typhlosion", "Totodile", "Croconaw", "Feraligatr", // 151 - 160
+	"Sentret", "Furret", "Hoothoot", "Noctowl", "Ledyba", "Ledian", "Spinarak", "Ariados", "Crobat", "Chinchou", // 161 - 170
+	"Lanturn", "Pichu", "Cleffa", "Igglybuff", "Togepi", "Togetic", "Natu", "Xatu", "Mareep", "Flaaffy", // 171 - 180
+	"Ampharos", "Bellossom", "Marill", "Azumarill", "Sudowoodo", "Politoed", "Hoppip", "Skiploom", "Jumpluff", "Aipom", // 181 - 190
+	"Sunkern", "Sunflora", "Yanma", "Wooper", "Quagsire", "Espeon", "Umbreon", "Murkrow", "Slowking", "Misdreavus", // 191 - 200
+	"Unown", "Wobbuffet", "Girafarig", "Pineco", "Forretress", "Dunsparce", "Gligar", "Steelix", "Snubbull", "Granbull", // 201 - 210
+	"Qwilfish", "Scizor", "Shuckle", "Heracross", "Sneasel", "Teddiursa", "Ursaring", "Slugma", "Magcargo", "Swinub", // 211 - 220
+	"Piloswine", "Corsola", "Remoraid", "Octillery", "Delibird", "Mantine", "Skarmory", "Houndour", "Houndoom", "Kingdra", // 221 - 230
+	"Phanpy", "Donphan", "Porygon2", "Stantler", "Smeargle", "Tyrogue", "Hitmontop", "Smoochum", "Elekid", "Magby", // 231 - 240
+	"Miltank", "Blissey", "Raikou", "Entei", "Suicune", "Larvitar", "Pupitar", "Tyranitar", "Lugia", "Ho-Oh", // 241 - 250
+	"Celebi", "Treecko", "Grovyle", "Sceptile", "Torchic", "Combusken", "Blaziken", "Mudkip", "Marshtomp", "Swampert", // 251 - 260
+	"Poochyena", "Mightyena", "Zigzagoon", "Linoone", "Wurmple", "Silcoon", "Beautifly", "Cascoon", "Dustox", "Lotad", // 261 - 270
+	"Lombre", "Ludicolo", "Seedot", "Nuzleaf", "Shiftry", "Taillow", "Swellow", "Wingull", "Pelipper", "Ralts", // 271 - 280
+	"Kirlia", "Gardevoir", "Surskit", "Masquerain", "Shroomish", "Breloom", "Slakoth", "Vigoroth", "Slaking", "Nincada", // 281 - 290
+	"Ninjask", "Shedinja", "Whismur", "Loudred", "Exploud", "Makuhita", "Hariyama", "Azurill", "Nosepass", "Skitty", // 291 - 300
+	"Delcatty", "Sableye", "Mawile", "Aron", "Lairon", "Aggron", "Meditite", "Medicham", "Electrike", "Manectric", // 301 - 310
+	"Plusle", "Minun", "Volbeat", "Illumise", "Roselia", "Gulpin", "Swalot", "Carvanha", "Sharpedo", "Wailmer", // 311 - 320
+	"Wailord", "Numel", "Camerupt", "Torkoal", "Spoink", "Grumpig", "Spinda", "Trapinch", "Vibrava", "Flygon", // 321 - 330
+	"Cacnea", "Cacturne", "Swablu", "Altaria", "Zangoose", "Seviper", "Lunatone", "Solrock", "Barboach", "Whiscash", // 331 - 340
+	"Corphish", "Crawdaunt", "Baltoy", "Claydol", "Lileep", "Cradily", "Anorith", "Armaldo", "Feebas", "Milotic", // 341 - 350
+	"Castform", "Kecleon", "Shuppet", "Banette", "Duskull", "Dusclops", "Tropius", "Chimecho", "Absol", "Wynaut", // 351 - 360
+	"Snorunt", "Glalie", "Spheal", "Sealeo", "Walrein", "Clamperl", "Huntail", "Gorebyss", "Relicanth", "Luvdisc", // 361 - 370
+	"Bagon", "Shelgon", "Salamence", "Beldum", "Metang", "Metagross", "Regirock", "Regice", "Registeel", "Latias", // 371 - 380
+	"Latios", "Kyogre", "Groudon", "Rayquaza", "Jirachi", "Deoxys", "Turtwig", "Grotle", "Torterra", "Chimchar", // 381 - 390
+	"Monferno", "Infernape", "Piplup", "Prinplup", "Empoleon", "Starly", "Staravia", "Staraptor", "Bidoof", "Bibarel", // 391 - 400
+	"Kricketot", "Kricketune", "Shinx", "Luxio", "Luxray", "Budew", "Roserade", "Cranidos", "Rampardos", "Shieldon", // 401 - 410
+	"Bastiodon", "Burmy", "Wormadam", "Mothim", "Combee", "Vespiquen", "Pachirisu", "Buizel", "Floatzel", "Cherubi", // 411 - 420
+	"Cherrim", "Shellos", "Gastrodon", "Ambipom", "Drifloon", "Drifblim", "Buneary", "Lopunny", "Mismagius", "Honchkrow", // 421 - 430
+	"Glameow", "Purugly", "Chingling", "Stunky", "Skuntank", "Bronzor", "Bronzong", "Bonsly", "Mime Jr.", "Happiny", // 431 - 440
+	"Chatot", "Spiritomb", "Gible", "Gabite", "Garchomp", "Munchlax", "Riolu", "Lucario", "Hippopotas", "Hippowdon", // 441 - 450
+	"Skorupi", "Drapion", "Croagunk", "Toxicroak", "Carnivine", "Finneon", "Lumineon", "Mantyke", "Snover", "Abomasnow", // 451 - 460
+	"Weavile", "Magnezone", "Lickilicky", "Rhyperior", "Tangrowth", "Electivire", "Magmortar", "Togekiss", "Yanmega", "Leafeon", // 461 - 470
+	"Glaceon", "Gliscor", "Mamoswine", "Porygon-Z", "Gallade", "Probopass", "Dusknoir", "Froslass", "Rotom", "Uxie", // 471 - 480
+	"Mesprit", "Azelf", "Dialga", "Palkia", "Heatran", "Regigigas", "Giratina", "Cresselia", "Phione", "Manaphy", // 481 - 490
+	"Darkrai", "Shaymin", "Arceus", // 491 - 493
+};
+
+// Ability names in ID order, the ability ID is the index + 1
+constexpr string_view abilityNames[] = {
+	"Stench", "Drizzle", "Speed Boost", "Battle Armor", "Sturdy", "Damp", "Limber", "Sand Veil", // 1 - 8
+	"Static", "Volt Absorb", "Water Absorb", "Oblivious", "Cloud Nine", "Compound Eyes", "Insomnia", "Color Change", // 9 - 16
+	"Immunity", "Flash Fire", "Shield Dust", "Own Tempo", "Suction Cups", "Intimidate", "Shadow Tag", "Rough Skin", // 17 - 24
+	"Wonder Guard", "Levitate", "Effect Spore", "Synchronize", "Clear Body", "Natural Cure", "Lightning Rod", "Serene Grace", // 25 - 32
+	"Swift Swim", "Chlorophyll", "Illuminate", "Trace", "Huge Power", "Poison Point", "Inner Focus", "Magma Armor", // 33 - 40
+	"Water Veil", "Magnet Pull", "Soundproof", "Rain Dish", "Sand Stream", "Pressure", "Thick Fat", "Early Bird", // 41 - 48
+	"Flame Body", "Run Away", "Keen Eye", "Hyper Cutter", "Pickup", "Truant", "Hustle", "Cute Charm", // 49 - 56
+	"Plus", "Minus", "Forecast", "Sticky Hold", "Shed Skin", "Guts", "Marvel Scale", "Liquid Ooze", // 57 - 64
+	"Overgrow", "Blaze", "Torrent", "Swarm", "Rock Head", "Drought", "Arena Trap", "Vital Spirit", // 65 - 72
+	"White Smoke", "Pure Power", "Shell Armor", "Air Lock", "Tangled Feet", "Motor Drive", "Rivalry", "Steadfast", // 73 - 80
+	"Snow Cloak", "Gluttony", "Anger Point", "Unburden", "Heatproof", "Simple", "Dry Skin", "Download", // 81 - 88
+	"Iron Fist", "Poison Heal", "Adaptability", "Skill Link", "Hydration", "Solar Power", "Quick Feet", "Normalize", // 89 - 96
+	"Sniper", "Magic Guard", "No Guard", "Stall", "Technician", "Leaf Guard", "Klutz", "Mold Breaker", // 97 - 104
+	"Super Luck", "Aftermath", "Anticipation", "Forewarn", "Unaware", "Tinted Lens", "Filter", "Slow Start", // 105 - 112
+	"Scrappy", "Storm Drain", "Ice Body", "Solid Rock", "Snow Warning", "Honey Gather", "Frisk", "Reckless", // 113 - 120
+	"Multitype", "Flower Gift", "Bad Dreams", // 121 - 123
+};
+
+// Move names and base PP in ID order, the move ID is the index + 1
+constexpr MoveData moveTable[] = {
+	{"Pound", 35}, {"Karate Chop", 25}, {"Double Slap", 10}, {"Comet Punch", 15}, {"Mega Punch", 20}, {"Pay Day", 20}, // 1 - 6
+	{"Fire Punch", 15}, {"Ice Punch", 15}, {"Thunder Punch", 15}, {"Scratch", 35}, {"Vise Grip", 30}, {"Guillotine", 5}, // 7 - 12
+	{"Razor Wind", 10}, {"Swords Dance", 20}, {"Cut", 30}, {"Gust", 35}, {"Wing Attack", 35}, {"Whirlwind", 20}, // 13 - 18
+	{"Fly", 15}, {"Bind", 20}, {"Slam", 20}, {"Vine Whip", 25}, {"Stomp", 20}, {"Double Kick", 30}, // 19 - 24
+	{"Mega Kick", 5}, {"Jump Kick", 10}, {"Rolling Kick", 15}, {"Sand Attack", 15}, {"Headbutt", 15}, {"Horn Attack", 25}, // 25 - 30
+	{"Fury Attack", 20}, {"Horn Drill", 5}, {"Tackle", 35}, {"Body Slam", 15}, {"Wrap", 20}, {"Take Down", 20}, // 31 - 36
+	{"Thrash", 10}, {"Double-Edge", 15}, {"Tail Whip", 30}, {"Poison Sting", 35}, {"Twineedle", 20}, {"Pin Missile", 20}, // 37 - 42
+	{"Leer", 30}, {"Bite", 25}, {"Growl", 40}, {"Roar", 20}, {"Sing", 15}, {"Supersonic", 20}, // 43 - 48
+	{"Sonic Boom", 20}, {"Disable", 20}, {"Acid", 30}, {"Ember", 25}, {"Flamethrower", 15}, {"Mist", 30}, // 49 - 54
+	{"Water Gun", 25}, {"Hydro Pump", 5}, {"Surf", 15}, {"Ice Beam", 10}, {"Blizzard", 5}, {"Psybeam", 20}, // 55 - 60
+	{"Bubble Beam", 20}, {"Aurora Beam", 20}, {"Hyper Beam", 5}, {"Peck", 35}, {"Drill Peck", 20}, {"Submission", 20}, // 61 - 66
+	{"Low Kick", 20}, {"Counter", 20}, {"Seismic Toss", 20}, {"Strength", 15}, {"Absorb", 5}, {"Mega Drain", 15}, // 67 - 72
+	{"Leech Seed", 10}, {"Growth", 20}, {"Razor Leaf", 25}, {"Solar Beam", 10}, {"Poison Powder", 35}, {"Stun Spore", 30}, // 73 - 78
+	{"Sleep Powder", 15}, {"Petal Dance", 10}, {"String Shot", 40}, {"Dragon Rage", 10}, {"Fire Spin", 15}, {"Thunder Shock", 30}, // 79 - 84
+	{"Thunderbolt", 15}, {"Thunder Wave", 20}, {"Thunder", 10}, {"Rock Throw", 15}, {"Earthquake", 10}, {"Fissure", 5}, // 85 - 90
+	{"Dig", 10}, {"Toxic", 10}, {"Confusion", 25}, {"Psychic", 10}, {"Hypnosis", 20}, {"Meditate", 40}, // 91 - 96
+	{"Agility", 30}, {"Quick Attack", 30}, {"Rage", 20}, {"Teleport", 20}, {"Night Shade", 15}, {"Mimic", 10}, // 97 - 102
+	{"Screech", 40}, {"Double Team", 15}, {"Recover", 10}, {"Harden", 30}, {"Minimize", 10}, {"Smokescreen", 20}, // 103 - 108
+	{"Confuse Ray", 10}, {"Withdraw", 40}, {"Defense Curl", 40}, {"Barrier", 20}, {"Light Screen", 30}, {"Haze", 30}, // 109 - 114
+	{"Reflect", 20}, {"Focus Energy", 30}, {"Bide", 10}, {"Metronome", 10}, {"Mirror Move", 20}, {"Self-Destruct", 5}, // 115 - 120
+	{"Egg Bomb", 10}, {"Lick", 30}, {"Smog", 20}, {"Sludge", 20}, {"Bone Club", 20}, {"Fire Blast", 5}, // 121 - 126
+	{"Waterfall", 15}, {"Clamp", 15}, {"Swift", 20}, {"Skull Bash", 10}, {"Spike Cannon", 15}, {"Constrict", 35}, // 127 - 132
+	{"Amnesia", 20}, {"Kinesis", 15}, {"Soft-Boiled", 10}, {"High Jump Kick", 10}, {"Glare", 30}, {"Dream Eater", 15}, // 133 - 138
+	{"Poison Gas", 40}, {"Barrage", 20}, {"Leech Life", 10}, {"Lovely Kiss", 10}, {"Sky Attack", 5}, {"Transform", 10}, // 139 - 144
+	{"Bubble", 30}, {"Dizzy Punch", 10}, {"Spore", 15}, {"Flash", 20}, {"Psywave", 15}, {"Splash", 40}, // 145 - 150
+	{"Acid Armor", 20}, {"Crabhammer", 10}, {"Explosion", 5}, {"Fury Swipes", 15}, {"Bonemerang", 10}, {"Rest", 10}, // 151 - 156
+	{"Rock Slide", 10}, {"Hyper Fang", 15}, {"Sharpen", 30}, {"Conversion", 30}, {"Tri Attack", 10}, {"Super Fang", 10}, // 157 - 162
+	{"Slash", 20}, {"Substitute", 10}, {"Struggle", 1}, {"Sketch", 1}, {"Triple Kick", 10}, {"Thief", 25}, // 163 - 168
+	{"Spider Web", 10}, {"Mind Reader", 5}, {"Nightmare", 15}, {"Flame Wheel", 25}, {"Snore", 15}, {"Curse", 10}, // 169 - 174
+	{"Flail", 15}, {"Conversion 2", 30}, {"Aeroblast", 5}, {"Cotton Spore", 40}, {"Reversal", 15}, {"Spite", 10}, // 175 - 180
+	{"Powder Snow", 25}, {"Protect", 10}, {"Mach Punch", 30}, {"Scary Face", 10}, {"Feint Attack", 20}, {"Sweet Kiss", 10}, // 181 - 186
+	{"Belly Drum", 10}, {"Sludge Bomb", 10}, {"Mud-Slap", 10}, {"Octazooka", 10}, {"Spikes", 20}, {"Zap Cannon", 5}, // 187 - 192
+	{"Foresight", 40}, {"Destiny Bond", 5}, {"Perish Song", 5}, {"Icy Wind", 15}, {"Detect", 5}, {"Bone Rush", 10}, // 193 - 198
+	{"Lock-On", 5}, {"Outrage", 10}, {"Sandstorm", 10}, {"Giga Drain", 10}, {"Endure", 10}, {"Charm", 20}, // 199 - 204
+	{"Rollout", 20}, {"False Swipe", 40}, {"Swagger", 15}, {"Milk Drink", 10}, {"Spark", 20}, {"Fury Cutter", 20}, // 205 - 210
+	{"Steel Wing", 25}, {"Mean Look", 5}, {"Attract", 15}, {"Sleep Talk", 10}, {"Heal Bell", 5}, {"Return", 20}, // 211 - 216
+	{"Present", 15}, {"Frustration", 20}, {"Safeguard", 25}, {"Pain Split", 20}, {"Sacred Fire", 5}, {"Magnitude", 30}, // 217 - 222
+	{"Dynamic Punch", 5}, {"Megahorn", 10}, {"Dragon Breath", 20}, {"Baton Pass", 40}, {"Encore", 5}, {"Pursuit", 20}, // 223 - 228
+	{"Rapid Spin", 40}, {"Sweet Scent", 20}, {"Iron Tail", 15}, {"Metal Claw", 35}, {"Vital Throw", 10}, {"Morning Sun", 5}, // 229 - 234
+	{"Synthesis", 5}, {"Moonlight", 5}, {"Hidden Power", 15}, {"Cross Chop", 5}, {"Twister", 20}, {"Rain Dance", 5}, // 235 - 240
+	{"Sunny Day", 5}, {"Crunch", 15}, {"Mirror Coat", 20}, {"Psych Up", 10}, {"Extreme Speed", 5}, {"Ancient Power", 5}, // 241 - 246
+	{"Shadow Ball", 15}, {"Future Sight", 10}, {"Rock Smash", 15}, {"Whirlpool", 15}, {"Beat Up", 10}, {"Fake Out", 10}, // 247 - 252
+	{"Uproar", 10}, {"Stockpile", 20}, {"Spit Up", 10}, {"Swallow", 10}, {"Heat Wave", 10}, {"Hail", 10}, // 253 - 258
+	{"Torment", 15}, {"Flatter", 15}, {"Will-O-Wisp", 15}, {"Memento", 10}, {"Facade", 20}, {"Focus Punch", 20}, // 259 - 264
+	{"Smelling Salts", 10}, {"Follow Me", 20}, {"Nature Power", 20}, {"Charge", 20}, {"Taunt", 20}, {"Helping Hand", 20}, // 265 - 270
+	{"Trick", 10}, {"Role Play", 10}, {"Wish", 10}, {"Assist", 20}, {"Ingrain", 20}, {"Superpower", 5}, // 271 - 276
+	{"Magic Coat", 15}, {"Recycle", 10}, {"Revenge", 10}, {"Brick Break", 15}, {"Yawn", 10}, {"Knock Off", 20}, // 277 - 282
+	{"Endeavor", 5}, {"Eruption", 5}, {"Skill Swap", 10}, {"Imprison", 10}, {"Refresh", 20}, {"Grudge", 5}, // 283 - 288
+	{"Snatch", 10}, {"Secret Power", 20}, {"Dive", 10}, {"Arm Thrust", 20}, {"Camouflage", 20}, {"Tail Glow", 20}, // 289 - 294
+	{"Luster Purge", 5}, {"Mist Ball", 5}, {"Feather Dance", 15}, {"Teeter Dance", 20}, {"Blaze Kick", 10}, {"Mud Sport", 15}, // 295 - 300
+	{"Ice Ball", 20}, {"Needle Arm", 15}, {"Slack Off", 10}, {"Hyper Voice", 10}, {"Poison Fang", 15}, {"Crush Claw", 10}, // 301 - 306
+	{"Blast Burn", 5}, {"Hydro Cannon", 5}, {"Meteor Mash", 10}, {"Astonish", 15}, {"Weather Ball", 10}, {"Aromatherapy", 5}, // 307 - 312
+	{"Fake Tears", 20}, {"Air Cutter", 25}, {"Overheat", 5}, {"Odor Sleuth", 40}, {"Rock Tomb", 15}, {"Silver Wind", 5}, // 313 - 318
+	{"Metal Sound", 40}, {"Grass Whistle", 15}, {"Tickle", 20}, {"Cosmic Power", 20}, {"Water Spout", 5}, {"Signal Beam", 15}, // 319 - 324
+	{"Shadow Punch", 20}, {"Extrasensory", 20}, {"Sky Uppercut", 15}, {"Sand Tomb", 15}, {"Sheer Cold", 5}, {"Muddy Water", 10}, // 325 - 330
+	{"Bullet Seed", 30}, {"Aerial Ace", 20}, {"Icicle Spear", 30}, {"Iron Defense", 15}, {"Block", 5}, {"Howl", 40}, // 331 - 336
+	{"Dragon Claw", 15}, {"Frenzy Plant", 5}, {"Bulk Up", 20}, {"Bounce", 5}, {"Mud Shot", 15}, {"Poison Tail", 25}, // 337 - 342
+	{"Covet", 25}, {"Volt Tackle", 15}, {"Magical Leaf", 20}, {"Water Sport", 15}, {"Calm Mind", 20}, {"Leaf Blade", 15}, // 343 - 348
+	{"Dragon Dance", 20}, {"Rock Blast", 10}, {"Shock Wave", 20}, {"Water Pulse", 20}, {"Doom Desire", 5}, {"Psycho Boost", 5}, // 349 - 354
+	{"Roost", 10}, {"Gravity", 5}, {"Miracle Eye", 40}, {"Wake-Up Slap", 10}, {"Hammer Arm", 10}, {"Gyro Ball", 5}, // 355 - 360
+	{"Healing Wish", 10}, {"Brine", 10}, {"Natural Gift", 15}, {"Feint", 10}, {"Pluck", 20}, {"Tailwind", 15}, // 361 - 366
+	{"Acupressure", 30}, {"Metal Burst", 10}, {"U-turn", 20}, {"Close Combat", 5}, {"Payback", 10}, {"Assurance", 10}, // 367 - 372
+	{"Embargo", 15}, {"Fling", 10}, {"Psycho Shift", 10}, {"Trump Card", 5}, {"Heal Block", 15}, {"Wring Out", 5}, // 373 - 378
+	{"Power Trick", 10}, {"Gastro Acid", 10}, {"Lucky Chant", 30}, {"Me First", 20}, {"Copycat", 20}, {"Power Swap", 10}, // 379 - 384
+	{"Guard Swap", 10}, {"Punishment", 5}, {"Last Resort", 5}, {"Worry Seed", 10}, {"Sucker Punch", 5}, {"Toxic Spikes", 20}, // 385 - 390
+	{"Heart Swap", 10}, {"Aqua Ring", 20}, {"Magnet Rise", 10}, {"Flare Blitz", 15}, {"Force Palm", 10}, {"Aura Sphere", 20}, // 391 - 396
+	{"Rock Polish", 20}, {"Poison Jab", 20}, {"Dark Pulse", 15}, {"Night Slash", 15}, {"Aqua Tail", 10}, {"Seed Bomb", 15}, // 397 - 402
+	{"Air Slash", 15}, {"X-Scissor", 15}, {"Bug Buzz", 10}, {"Dragon Pulse", 10}, {"Dragon Rush", 10}, {"Power Gem", 20}, // 403 - 408
+	{"Drain Punch", 10}, {"Vacuum Wave", 30}, {"Focus Blast", 5}, {"Energy Ball", 10}, {"Brave Bird", 15}, {"Earth Power", 10}, // 409 - 414
+	{"Switcheroo", 10}, {"Giga Impact", 5}, {"Nasty Plot", 20}, {"Bullet Punch", 30}, {"Avalanche", 10}, {"Ice Shard", 30}, // 415 - 420
+	{"Shadow Claw", 15}, {"Thunder Fang", 15}, {"Ice Fang", 15}, {"Fire Fang", 15}, {"Shadow Sneak", 30}, {"Mud Bomb", 10}, // 421 - 426
+	{"Psycho Cut", 20}, {"Zen Headbutt", 15}, {"Mirror Shot", 10}, {"Flash Cannon", 10}, {"Rock Climb", 20}, {"Defog", 15}, // 427 - 432
+	{"Trick Room", 5}, {"Draco Meteor", 5}, {"Discharge", 15}, {"Lava Plume", 15}, {"Leaf Storm", 5}, {"Power Whip", 10}, // 433 - 438
+	{"Rock Wrecker", 5}, {"Cross Poison", 20}, {"Gunk Shot", 5}, {"Iron Head", 15}, {"Magnet Bomb", 20}, {"Stone Edge", 5}, // 439 - 444
+	{"Captivate", 20}, {"Stealth Rock", 20}, {"Grass Knot", 20}, {"Chatter", 20}, {"Judgment", 10}, {"Bug Bite", 20}, // 445 - 450
+	{"Charge Beam", 10}, {"Wood Hammer", 15}, {"Aqua Jet", 20}, {"Attack Order", 15}, {"Defend Order", 10}, {"Heal Order", 10}, // 451 - 456
+	{"Head Smash", 5}, {"Double Hit", 10}, {"Roar of Time", 5}, {"Spacial Rend", 5}, {"Lunar Dance", 10}, {"Crush Grip", 5}, // 457 - 462
+	{"Magma Storm", 5}, {"Dark Void", 10}, {"Seed Flare", 5}, {"Ominous Wind", 5}, {"Shadow Force", 5}, // 463 - 467
+};
+
+// FNV-1a hash of 'name' mixed with 'seed'
+constexpr uint32_t nameHash(string_view name, uint32_t seed){
+	uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+	for(char c : name){
+		h ^= (unsigned char)c;
+		h *= 16777619u;
+	}
+	return h ^ (h >> 16);
+}
+
+// Compile time perfect hash over N names, slot values are name index + 1 (0 marks a free slot)
+template<size_t N>
+struct PerfectHash {
+	static constexpr size_t bucketCount = N / 2 + 1;
+	static constexpr size_t slotCount = bit_ceil(N * 2);
+
+	array<uint16_t, bucketCount> seeds = {};
+	array<uint16_t, slotCount> slots = {};
+	bool complete = false;
+
+	// Index of 'name' in 'names' or -1
+	constexpr int find(string_view name, const string_view* names) const {
+		uint32_t seed = seeds[nameHash(name, 0) % bucketCount];
+		int entry = slots[nameHash(name, seed) % slotCount];
+		return (entry && names[entry - 1] == name) ? entry - 1 : -1;
+	}
+};
+
+template<size_t N>
+constexpr PerfectHash<N> buildPerfectHash(const array<string_view, N>& names){
+	using Hash = PerfectHash<N>;
+	Hash hash;
+
+	// Group the names by bucket
+	array<size_t, Hash::bucketCount + 1> bucketStart = {};
+	array<uint16_t, N> members = {};
+	for(size_t i = 0; i < N; i++){ bucketStart[nameHash(names[i], 0) % Hash::bucketCount + 1]++; }
+	for(size_t b = 0; b < Hash::bucketCount; b++){ bucketStart[b+1] += bucketStart[b]; }
+	array<size_t, Hash::bucketCount> fill = {};
+	for(size_t i = 0; i < N; i++){
+		size_t b = nameHash(names[i], 0) % Hash::bucketCount;
+		members[bucketStart[b] + fill[b]++] = i;
+	}
+
+	// Place the largest buckets first while the table is still empty
+	array<uint16_t, Hash::bucketCount> order = {};
+	for(size_t b = 0; b < Hash::bucketCount; b++){ order[b] = b; }
+	sort(order.begin(), order.end(), [&](uint16_t a, uint16_t b){ return fill[a] > fill[b]; });
+
+	for(uint16_t b : order){
+		if(fill[b] == 0){ break; }
+		bool placed = false;
+		for(uint32_t seed = 1; seed < 0xffff && !placed; seed++){
+			array<size_t, 16> taken = {};
+			size_t count = 0;
+			placed = fill[b] <= taken.size();
+			for(size_t m = 0; m < fill[b] && placed; m++){
+				size_t slot = nameHash(names[members[bucketStart[b] + m]], seed) % Hash::slotCount;
+				if(hash.slots[slot]){ placed = false; }
+				for(size_t t = 0; t < count && placed; t++){ if(taken[t] == slot){ placed = false; } }
+				taken[count++] = slot;
+			}
+			if(placed){
+				hash.seeds[b] = seed;
+				for(size_t m = 0; m < fill[b]; m++){ hash.slots[taken[m]] = members[bucketStart[b] + m] + 1; }
+			}
+		}
+		if(!placed){ return hash; }
+	}
+	hash.complete = true;
+	return hash;
+}
+
+template<size_t N>
+constexpr array<string_view, N> toNameArray(const string_view (&names)[N]){
+	array<string_view, N> ret = {};
+	for(size_t i = 0; i < N; i++){ ret[i] = names[i]; }
+	return ret;
+}
+
+template<size_t N>
+constexpr array<string_view, N> toNameArray(const MoveData (&moves)[N]){
+	array<string_view, N> ret = {};
+	for(size_t i = 0; i < N; i++){ ret[i] = moves[i].name; }
+	return ret;
+}
+
+// Every name has to come back out of its own perfect hash
+template<size_t N>
+constexpr bool perfectHashValid(const PerfectHash<N>& hash, const array<string_view, N>& names){
+	if(!hash.complete){ return false; }
+	for(size_t i = 0; i < N; i++){
+		if(hash.find(names[i], names.data()) != (int)i){ return false; }
+	}
+	return true;
+}
+
+// Names are matched exactly, a stray space would make one impossible to type
+template<size_t N>
+constexpr bool namesTrimmed(const array<string_view, N>& names){
+	for(string_view name : names){
+		if(name.empty() || string_view(" \t\n\r").find(name.front()) != string_view::npos || string_view(" \t\n\r").find(name.back()) != string_view::npos){
+			return false;
+		}
+	}
+	return true;
+}
+
+constexpr auto speciesKeys = toNameArray(speciesNames);
+constexpr auto abilityKeys = toNameArray(abilityNames);
+constexpr auto moveKeys = toNameArray(moveTable);
+constexpr auto speciesHash = buildPerfectHash(speciesKeys);
+constexpr auto abilityHash = buildPerfectHash(abilityKeys);
+constexpr auto moveHash = buildPerfectHash(moveKeys);
+static_assert(perfectHashValid(speciesHash, speciesKeys), "species perfect hash could not be built");
+static_assert(perfectHashValid(abilityHash, abilityKeys), "ability perfect hash could not be built");
+static_assert(perfectHashValid(moveHash, moveKeys), "move perfect hash could not be built");
+static_assert(namesTrimmed(speciesKeys) && namesTrimmed(abilityKeys) && namesTrimmed(moveKeys), "name with leading or trailing whitespace");
+
+// Name -> ID lookups, 0 if the name is unknown
+int getSpeciesID(string_view name){
+	PhaseTimer<> timer(statNameLookup);
+	return speciesHash.find(name, speciesKeys.data()) + 1;
+}
+
+int getAbilityID(string_view name){
+	PhaseTimer<> timer(statNameLookup);
+	return abilityHash.find(name, abilityKeys.data()) + 1;
+}
+
+int getMoveID(string_view name){
+	PhaseTimer<> timer(statNameLookup);
+	return moveHash.find(name, moveKeys.data()) + 1;
+}
+
+// ID -> name lookups, empty if the ID is out of range
+string_view getSpeciesName(int id){ return (id >= 1 && id <= (int)speciesKeys.size()) ? speciesKeys[id - 1] : string_view(); }
+string_view getAbilityName(int id){ return (id >= 1 && id <= (int)abilityKeys.size()) ? abilityKeys[id - 1] : string_view(); }
+string_view getMoveName(int id){ return (id >= 1 && id <= (int)moveKeys.size()) ? moveKeys[id - 1] : string_view(); }
+
+// Number of species, abilities and moves
+int getSpeciesCount(){ return speciesKeys.size(); }
+int getAbilityCount(){ return abilityKeys.size(); }
+int getMoveCount(){ return moveKeys.size(); }
+
+// Base PP of move 'id', 0 if the ID is out of range
+int getMovePP(int id){ return (id >= 1 && id <= (int)moveKeys.size()) ? moveTable[id - 1].pp : 0; }
+
+// Nature name -> nature (0 - 24), -1 if the name is unknown
+int getNatureID(string_view name){
+	for(int i = 0; i < 25; i++){
+		if(natureNames[i] == name){ return i; }
+	}
+	return -1;
+}
+
+
+// - - - Handle data from savefile - - - //
+
+/* Notes:
+	-> See saveditor.h for the SaveBuffer overview, the rollback file is:
+	   magic, file size, range count, (offset, length, original bytes) per range, end magic
+*/
+
+#define rollbackMagic "PSEROLL1"
+#define rollbackEndMagic "PSEROLLE"
+
+static uint32_t readLE32(const vector<unsigned char>& v, size_t pos){
+	if(pos + 4 > v.size()){ throw SaveError(SaveErrorCode::fileError, "could not roll back interrupted write"); }
+	return v[pos] | (v[pos+1] << 8) | (v[pos+2] << 16) | ((uint32_t)v[pos+3] << 24);
+}
+
+static void appendLE32(vector<unsigned char>& v, uint32_t value){
+	for(int i = 0; i < 4; i++){ v.push_back((value >> (8*i)) & 0xff); }
+}
+
+static bool writeAll(int out, const unsigned char* src, size_t count, size_t offset){
+	while(count > 0){
+		ssize_t n = pwrite(out, src, count, offset);
+		if(n < 0 && errno == EINTR){ continue; }
+		if(n <= 0){ return false; }
+		src += n; count -= n; offset += n;
+	}
+	return true;
+}
+
+static void syncDirectory(const string& path){
+	string dir = filesystem::path(path).parent_path().string();
+	int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+	if(dirFd >= 0){
+		fsync(dirFd);
+		::close(dirFd);
+	}
+}
+
+SaveBuffer& SaveBuffer::operator=(SaveBuffer&& other) noexcept {
+	if(this != &other){
+		close();
+		bytes = other.bytes; length = other.length; mapped = other.mapped; fd = other.fd;
+		filename = move(other.filename); owned = move(other.owned);
+		dirty = move(other.dirty); undo = move(other.undo); lastHit = other.lastHit; verifyAll = other.verifyAll;
+		other.bytes = nullptr; other.length = 0; other.mapped = false; other.fd = -1; other.lastHit = 0;
+	}
+	return *this;
+}
+
+void SaveBuffer::open(const char* path, bool readOnly){
+	PhaseTimer<> timer(statRead);
+	close();
+	if(!readOnly){ recover(path); }
+
+	fd = ::open(path, readOnly ? O_RDONLY : O_RDWR);
+	if(fd < 0){ throw SaveError(SaveErrorCode::fileError, "could not read file"); }
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+		close();
+		throw SaveError(SaveErrorCode::fileError, "could not read file");
+	}
+	if(info.st_size == 0){
+		close();
+		throw SaveError(SaveErrorCode::invalidSave, "file is too small to be a save file");
+	}
+
+	void* map = mmap(nullptr, info.st_size, PROT_READ | (readOnly ? 0 : PROT_WRITE), MAP_PRIVATE, fd, 0);
+	if(map == MAP_FAILED){
+		close();
+		throw SaveError(SaveErrorCode::fileError, "could not read file");
+	}
+	bytes = (unsigned char*)map;
+	length = info.st_size;
+	mapped = true;
+	timer.addBytes(length);
+	filename = path;
+	reserveTracking();
+}
+
+void SaveBuffer::assign(vector<unsigned char> contents){
+	close();
+	owned = move(contents);
+	bytes = owned.data();
+	length = owned.size();
+	reserveTracking();
+}
+
+void SaveBuffer::borrow(span<unsigned char> contents){
+	close();
+	bytes = contents.data();
+	length = contents.size();
+	reserveTracking();
+}
+
+// The tracking vectors are cleared but keep their capacity for the next save
+void SaveBuffer::close(){
+	if(mapped){ munmap(bytes, length); }
+	if(fd >= 0){ ::close(fd); }
+	bytes = nullptr; length = 0; mapped = false; fd = -1;
+	filename.clear(); owned.clear();
+	dirty.clear(); undo.clear(); lastHit = 0;
+}
+
+void SaveBuffer::reserveTracking(){
+	dirty.reserve(64);
+	undo.reserve(4096);
+}
+
+// Add every part of [offset, offset + count) that isn't dirty yet
+void SaveBuffer::markDirtySlow(size_t offset, size_t count){
+	size_t pos = offset;
+	size_t end = offset + count;
+	auto it = lower_bound(dirty.begin(), dirty.end(), offset, [](const DirtyRange& r, size_t value){ return r.offset + r.length <= value; });
+	while(pos < end){
+		if(it != dirty.end() && it->offset <= pos){
+			pos = it->offset + it->length;
+			lastHit = it - dirty.begin();
+			++it;
+			continue;
+		}
+		size_t gapEnd = (it != dirty.end() && it->offset < end) ? it->offset : end;
+		DirtyRange r = {pos, gapEnd - pos, undo.size()};
+		undo.insert(undo.end(), bytes + pos, bytes + gapEnd);
+		it = dirty.insert(it, r);
+		lastHit = it - dirty.begin();
+		++it;
+		pos = gapEnd;
+	}
+}
+
+unsigned char SaveBuffer::original(size_t i) const {
+	auto it = lower_bound(dirty.begin(), dirty.end(), i, [](const DirtyRange& r, size_t value){ return r.offset + r.length <= value; });
+	if(it != dirty.end() && it->offset <= i){ return undo[it->original + (i - it->offset)]; }
+	return bytes[i];
+}
+
+size_t SaveBuffer::dirtyBytes() const {
+	size_t total = 0;
+	for(const DirtyRange& r : dirty){ total += r.length; }
+	return total;
+}
+
+size_t SaveBuffer::commit(){
+	if(!mapped){ throw SaveError(SaveErrorCode::fileError, "could not write to file"); }
+	if(dirty.empty()){ return 0; }
+	PhaseTimer<> timer(statWrite);
+
+	// Adjacent ranges are written with a single call
+	vector<pair<size_t, size_t>> writes;
+	for(const DirtyRange& r : dirty){
+		if(!writes.empty() && writes.back().first + writes.back().second == r.offset){ writes.back().second += r.length; }
+		else{ writes.push_back({r.offset, r.length}); }
+	}
+
+	string rollbackPath = filename + ".rollback";
+	writeRollback(rollbackPath);
+
+	size_t written = 0;
+	for(auto& w : writes){
+		if(!writeAll(fd, bytes + w.first, w.second, w.first)){ throw SaveError(SaveErrorCode::fileError, "could not write to file"); }
+		written += w.second;
+	}
+	if(fsync(fd) != 0){ throw SaveError(SaveErrorCode::fileError, "could not write to file"); }
+
+	// The save is consistent again, dropping the rollback data completes the commit
+	unlink(rollbackPath.c_str());
+	syncDirectory(filename);
+	markClean();
+	timer.addBytes(written);
+	return written;
+}
+
+void SaveBuffer::saveAs(const char* path){
+	PhaseTimer<> timer(statWrite, length);
+	string tmpPath = string(path) + ".tmp";
+	int out = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(out < 0){ throw SaveError(SaveErrorCode::fileError, "could not write to file"); }
+	bool ok = writeAll(out, bytes, length, 0) && fsync(out) == 0;
+	::close(out);
+	if(!ok || rename(tmpPath.c_str(), path) != 0){
+		unlink(tmpPath.c_str());
+		throw SaveError(SaveErrorCode::fileError, "could not write to file");
+	}
+	syncDirectory(path);
+	if(filename != path){ return; }
+	markClean();
+}
+
+void SaveBuffer::recover(const char* path){
+	string rollbackPath = string(path) + ".rollback";
+	ifstream in(rollbackPath, ios::binary);
+	if(!in){ return; }
+	vector<unsigned char> log((istreambuf_iterator<char>(in)), {});
+	in.close();
+
+	// A rollback file without its end marker was never completed, so the save wasn't touched yet
+	size_t magicLen = strlen(rollbackMagic);
+	bool complete = log.size() >= 2*magicLen + 12
+		&& memcmp(log.data(), rollbackMagic, magicLen) == 0
+		&& memcmp(log.data() + log.size() - magicLen, rollbackEndMagic, magicLen) == 0;
+	if(complete){
+		int out = ::open(path, O_WRONLY);
+		if(out < 0){ throw SaveError(SaveErrorCode::fileError, "could not roll back interrupted write"); }
+		size_t pos = magicLen + 8;
+		uint32_t count = readLE32(log, pos); pos += 4;
+		for(uint32_t i = 0; i < count; i++){
+			uint32_t offset = readLE32(log, pos);
+			uint32_t len = readLE32(log, pos + 4);
+			pos += 8;
+			if(pos + len > log.size() - magicLen || !writeAll(out, log.data() + pos, len, offset)){
+				::close(out);
+				throw SaveError(SaveErrorCode::fileError, "could not roll back interrupted write");
+			}
+			pos += len;
+		}
+		fsync(out);
+		::close(out);
+	}
+	unlink(rollbackPath.c_str());
+	syncDirectory(path);
+}
+
+void SaveBuffer::writeRollback(const string& rollbackPath){
+	vector<unsigned char> log(rollbackMagic, rollbackMagic + strlen(rollbackMagic));
+	appendLE32(log, length & 0xffffffff);
+	appendLE32(log, (uint64_t)length >> 32);
+	appendLE32(log, dirty.size());
+	for(const DirtyRange& r : dirty){
+		appendLE32(log, r.offset);
+		appendLE32(log, r.length);
+		log.insert(log.end(), undo.begin() + r.original, undo.begin() + r.original + r.length);
+	}
+	log.insert(log.end(), rollbackEndMagic, rollbackEndMagic + strlen(rollbackEndMagic));
+
+	int out = ::open(rollbackPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(out < 0){ throw SaveError(SaveErrorCode::fileError, "could not write to file"); }
+	bool ok = writeAll(out, log.data(), log.size(), 0) && fsync(out) == 0;
+	::close(out);
+	if(!ok){
+		unlink(rollbackPath.c_str());
+		throw SaveError(SaveErrorCode::fileError, "could not write to file");
+	}
+	syncDirectory(rollbackPath);
+}
+
+// Map the save file into 'data'
+void readFile(const char* filename, SaveBuffer& data, bool readOnly){
+	data.open(filename, readOnly);
+}
+
+// Write changes to savefile, only the modified ranges are written if 'filename' is the file 'data' was read from
+size_t writeFile(const char* filename, SaveBuffer& data){
+	if(data.path() == filename){
+		return data.commit();
+	}
+	data.saveAs(filename);
+	return data.size();
+}
+
+// - - - Small Block Functions - - - //
+
+/* Notes:
+	-> The save file checksum is CRC-16-CCITT (polynomial 0x1021, initial value 0xffff, no reflection, no final xor)
+	-> Two implementations produce identical results:
+		- slicing-by-8: eight constexpr tables, 8 bytes per step
+		- carry-less multiply (PCLMULQDQ): folds 64 bytes per step, only used if the CPU supports it
+	-> The implementation is picked once at runtime, crc16ccitt() is the only entry point
+*/
+
+#define crcPolynomial 0x1021
+
+// crcTables[k][b] is the checksum (with initial value 0) of byte b followed by k zero bytes
+constexpr array<array<uint16_t, 256>, 8> makeCrcTables(){
+	array<array<uint16_t, 256>, 8> tables = {};
+	for(int b = 0; b < 256; b++){
+		uint16_t crc = b << 8;
+		for(int bit = 0; bit < 8; bit++){
+			crc = (crc & 0x8000) ? (crc << 1) ^ crcPolynomial : (crc << 1);
+		}
+		tables[0][b] = crc;
+	}
+	for(int k = 1; k < 8; k++){
+		for(int b = 0; b < 256; b++){
+			uint16_t prev = tables[k-1][b];
+			tables[k][b] = (prev << 8) ^ tables[0][prev >> 8];
+		}
+	}
+	return tables;
+}
+constexpr auto crcTables = makeCrcTables();
+static_assert(crcTables[0][1] == 0x1021 && crcTables[0][255] == 0x1EF0, "CRC-16-CCITT table mismatch");
+
+// x^n mod P, used for the folding constants and for moving checksums over zero bytes
+constexpr uint16_t crcXPow(size_t n){
+	uint32_t value = 1;
+	for(size_t i = 0; i < n; i++){
+		value <<= 1;
+		if(value & 0x10000){ value ^= 0x10000 | crcPolynomial; }
+	}
+	return value;
+}
+
+// Continue the checksum 'crc' over 'chunk' using the slicing-by-8 tables
+uint16_t crc16Table(span<const unsigned char> chunk, uint16_t crc){
+	const unsigned char* p = chunk.data();
+	size_t n = chunk.size();
+	while(n >= 8){
+		crc = crcTables[7][p[0] ^ (crc >> 8)] ^ crcTables[6][p[1] ^ (crc & 0xff)]
+			^ crcTables[5][p[2]] ^ crcTables[4][p[3]] ^ crcTables[3][p[4]]
+			^ crcTables[2][p[5]] ^ crcTables[1][p[6]] ^ crcTables[0][p[7]];
+		p += 8;
+		n -= 8;
+	}
+	while(n--){
+		crc = (crc << 8) ^ crcTables[0][(crc >> 8) ^ *p++];
+	}
+	return crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Bytes are loaded in reverse so the first byte of a block ends up in the most significant bits
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crcReverseMask(){
+	return _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+}
+
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crcLoad(const unsigned char* src, __m128i reverse){
+	return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), reverse);
+}
+
+// One 128 bit folding step: x * x^128 (or x^512 for the 4 lane loop) mod P, added to 'next'
+// 'k' holds x^(n+64) mod P in the high and x^n mod P in the low quadword
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crcFold(__m128i x, __m128i k, __m128i next){
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00)), next);
+}
+
+// Continue the checksum 'crc' over 'chunk' by folding 16 byte blocks with carry-less multiplication
+// The folded 128 bit remainder is congruent to everything before it, so the table code finishes it off
+__attribute__((target("pclmul,ssse3")))
+uint16_t crc16Clmul(span<const unsigned char> chunk, uint16_t crc){
+	const unsigned char* p = chunk.data();
+	size_t n = chunk.size();
+	if(n < 128){ return crc16Table(chunk, crc); }
+
+	const __m128i reverse = crcReverseMask();
+
+	const __m128i fold512 = _mm_set_epi64x(crcXPow(512 + 64), crcXPow(512));
+	const __m128i fold128 = _mm_set_epi64x(crcXPow(128 + 64), crcXPow(128));
+
+	// The initial value is xored into the first two message bytes
+	__m128i x0 = _mm_xor_si128(crcLoad(p, reverse), _mm_slli_si128(_mm_cvtsi32_si128(crc), 14));
+	__m128i x1 = crcLoad(p + 16, reverse);
+	__m128i x2 = crcLoad(p + 32, reverse);
+	__m128i x3 = crcLoad(p + 48, reverse);
+	p += 64;
+	n -= 64;
+
+	while(n >= 64){
+		x0 = crcFold(x0, fold512, crcLoad(p, reverse));
+		x1 = crcFold(x1, fold512, crcLoad(p + 16, reverse));
+		x2 = crcFold(x2, fold512, crcLoad(p + 32, reverse));
+		x3 = crcFold(x3, fold512, crcLoad(p + 48, reverse));
+		p += 64;
+		n -= 64;
+	}
+
+	x1 = crcFold(x0, fold128, x1);
+	x2 = crcFold(x1, fold128, x2);
+	x3 = crcFold(x2, fold128, x3);
+	while(n >= 16){
+		x3 = crcFold(x3, fold128, crcLoad(p, reverse));
+		p += 16;
+		n -= 16;
+	}
+
+	alignas(16) unsigned char remainder[16];
+	_mm_store_si128((__m128i*)remainder, _mm_shuffle_epi8(x3, reverse));
+	crc = crc16Table(remainder, 0);
+	return crc16Table({p, n}, crc);
+}
+
+#endif
+
+using CrcKernel = uint16_t (*)(span<const unsigned char>, uint16_t);
+
+// Pick the fastest checksum implementation the CPU supports
+static CrcKernel selectCrcKernel(){
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")){ return crc16Clmul; }
+#endif
+	return crc16Table;
+}
+
+// Calculate savefile checksum for given small block data
+int crc16ccitt(span<const unsigned char> dataChunk){
+	static const CrcKernel kernel = selectCrcKernel();
+	PhaseTimer<> timer(statCrc, dataChunk.size());
+	return kernel(dataChunk, 0xffff);
+}
+
+// Update checksum bytes with 'newValue'
+void updateChecksum(SaveBuffer& data, int newValue, int block, int version){
+	if(block != 1 && block != 2){
+		throw SaveError(SaveErrorCode::invalidArgument, "could not update Savefile Checksum");
+	}
+	size_t pos = withVersionLayout(version, [&](auto layout){ return layout.smallChecksum(getSmallBlockOffset(block)); });
+	data[pos] = newValue & 0xff;
+	data[pos + 1] = newValue >> 8;
+}
+
+/* Notes:
+	-> The checksum is linear: crc(new) = crc(old) ^ crc0(old ^ new), where crc0 uses initial value 0
+	-> old ^ new is zero outside the dirty ranges, so only the edited bytes have to be hashed. Their
+	   contribution is then moved to the end of the block by multiplying with x^(8 * distance) mod P
+	-> The "old" checksum is the one stored in the save when it was opened or last committed, which is
+	   exactly what the pre-edit bytes of the checksum field in SaveBuffer hold
+	-> This trusts that stored checksum, SaveBuffer::setVerifyChecksums makes it recompute the whole block instead
+*/
+
+// Product of two polynomials (degree < 16) mod P
+constexpr uint16_t crcMulMod(uint16_t a, uint16_t b){
+	uint16_t product = 0;
+	for(int bit = 15; bit >= 0; bit--){
+		product = (product & 0x8000) ? (product << 1) ^ crcPolynomial : (product << 1);
+		if(b & (1 << bit)){ product ^= a; }
+	}
+	return product;
+}
+
+// crcZeroShift[k] = x^(8 * 2^k) mod P, appending 2^k zero bytes multiplies a checksum by this
+constexpr array<uint16_t, 64> makeCrcZeroShift(){
+	array<uint16_t, 64> shift = {};
+	shift[0] = crcXPow(8);
+	for(int k = 1; k < 64; k++){ shift[k] = crcMulMod(shift[k-1], shift[k-1]); }
+	return shift;
+}
+constexpr auto crcZeroShift = makeCrcZeroShift();
+
+// Checksum (initial value 0) of a message with checksum 'crc' followed by 'zeroBytes' zero bytes
+uint16_t crcShiftZeros(uint16_t crc, size_t zeroBytes){
+	for(int k = 0; zeroBytes; k++, zeroBytes >>= 1){
+		if(zeroBytes & 1){ crc = crcMulMod(crc, crcZeroShift[k]); }
+	}
+	return crc;
+}
+
+// New checksum of [start, start + count) given 'oldCrc', the checksum of the same range before the dirty ranges of 'data' changed
+int crc16ccittIncremental(int oldCrc, const SaveBuffer& data, size_t start, size_t count){
+	PhaseTimer<> timer(statCrc);
+	uint16_t delta = 0;
+	size_t pos = start;
+	size_t end = start + count;
+	unsigned char diff[64];
+
+	for(const DirtyRange& r : data.dirtyRanges()){
+		size_t lo = max(r.offset, start);
+		size_t hi = min(r.offset + r.length, end);
+		if(lo >= hi){ continue; }
+
+		delta = crcShiftZeros(delta, lo - pos);
+		const unsigned char* before = data.originalBytes(r) + (lo - r.offset);
+		const unsigned char* after = data.data() + lo;
+		for(size_t done = 0; done < hi - lo; ){
+			size_t n = min(sizeof(diff), hi - lo - done);
+			for(size_t i = 0; i < n; i++){ diff[i] = before[done + i] ^ after[done + i]; }
+			delta = crc16Table(span<const unsigned char>(diff, n), delta);
+			timer.addBytes(n);
+			done += n;
+		}
+		pos = hi;
+	}
+
+	delta = crcShiftZeros(delta, end - pos);
+	return (oldCrc ^ delta) & 0xffff;
+}
+
+// Checksum of the 'count' bytes at 'blockOffset' after editing, 'checksumPos' holds the checksum stored before the edits
+// Updated from the dirty ranges unless the whole block has to be verified
+int calcBlockChecksum(const SaveBuffer& data, size_t blockOffset, size_t count, size_t checksumPos){
+	size_t dirty = 0;
+	for(const DirtyRange& r : data.dirtyRanges()){
+		size_t lo = max(r.offset, blockOffset);
+		size_t hi = min(r.offset + r.length, blockOffset + count);
+		if(lo < hi){ dirty += hi - lo; }
+	}
+
+	// Recomputing is cheaper once a sizeable part of the block changed
+	if(data.verifiesChecksums() || dirty > count / 16){
+		return crc16ccitt(data.view(blockOffset, count));
+	}
+
+	int oldCrc = data.original(checksumPos) | (data.original(checksumPos + 1) << 8);
+	return crc16ccittIncremental(oldCrc, data, blockOffset, count);
+}
+
+// Checksum of the small block 'block' after editing
+int calcSmallBlockChecksum(const SaveBuffer& data, int block, int version){
+	if(block != 1 && block != 2){
+		throw SaveError(SaveErrorCode::invalidArgument, "could not update Savefile Checksum");
+	}
+	size_t blockOffset = getSmallBlockOffset(block);
+	return withVersionLayout(version, [&](auto layout){
+		return calcBlockChecksum(data, blockOffset, layout.smallLength, layout.smallChecksum(blockOffset));
+	});
+}
+
+// Find out in which block the last save was stored
+int getCurBlock(const SaveBuffer& data, int version){
+	PhaseTimer<> timer(statCurBlock);
+
+	return withVersionLayout(version, [&](auto layout){
+		if(data.size() < smallBlock2 + layout.smallLength + 0x14){
+			throw SaveError(SaveErrorCode::invalidSave, "file is too small to be a save file");
+		}
+
+		size_t time1 = layout.playTime(smallBlock1);
+		size_t time2 = layout.playTime(smallBlock2);
+		int block1 = data[time1 + 1];
+		int block2 = data[time2 + 1];
+
+		if(block1 == 0xff){
+			throw SaveError(SaveErrorCode::invalidSave, "save the game at least twice before editing");
+		}
+
+		block1 = block1 << 8; block1 += data[time1];
+		block1 *= 60*60;
+		block1 += data[time1 + 3];
+		block1 += data[time1 + 2]*60;
+		block2 = block2 << 8; block2 += data[time2];
+		block2 *= 60*60;
+		block2 += data[time2 + 3];
+		block2 += data[time2 + 2]*60;
+		if(block1 > block2){ return 1; }
+		else if(block1 < block2){ return 2; }
+		else{ return 2;}
+	});
+}
+
+// - - - Handle Pokemon Data Functions - - - //
+
+// Offset of the lead pokemon's record in the save file
+size_t getLeadPokemonOffset(int block, int version){
+	if(block != 1 && block != 2){
+		throw SaveError(SaveErrorCode::invalidArgument, "could not find Pokemon data");
+	}
+	return withVersionLayout(version, [&](auto layout){ return layout.partySlot(getSmallBlockOffset(block), 0); });
+}
+
+// Get the Pokemon's 'Personality Value' from the record at 'recordOffset'
+uint32_t getPersonalityValue(const SaveBuffer& data, size_t recordOffset){
+	return data[recordOffset] | (data[recordOffset+1] << 8) | (data[recordOffset+2] << 16) | ((uint32_t)data[recordOffset+3] << 24);
+}
+
+// - - - Character Encoding/Decoding Functions - - - //
+
+/* Notes:
+	-> Game text is stored as little endian 16 bit characters, terminated by 0xffff and padded with zeros
+	-> Decoding indexes gameCharacters directly with the character value
+	-> Encoding goes through a two level table indexed by the unicode code point (page = high byte)
+	-> Only the western character block (0x0100 - 0x01ff) is mapped, anything else decodes to U+FFFD
+*/
+
+// Unicode code point for every game character below 0x200, 0 if the character is not mapped
+constexpr array<char32_t, gameCharacterCount> makeGameCharacters(){
+	array<char32_t, gameCharacterCount> chars = {};
+	for(int i = 0; i < 10; i++){ chars[0x121 + i] = U'0' + i; }
+	for(int i = 0; i < 26; i++){
+		chars[0x12b + i] = U'A' + i;
+		chars[0x145 + i] = U'a' + i;
+	}
+
+	// Latin-1 letters from À to ÿ are in unicode order
+	for(int i = 0; i < 64; i++){ chars[0x15f + i] = U'À' + i; }
+
+	const char32_t symbols[] = {
+		U'Œ', U'œ', U'Ş', U'ş', U'ª', U'º', 0, 0, 0, U'₽', U'¡', U'¿', U'!', U'?', U',', U'.', // 0x19f - 0x1ae
+		U'…', U'･', U'/', U'‘', U'’', U'“', U'”', U'„', U'«', U'»', U'(', U')', U'♂', U'♀', U'+', U'-', // 0x1af - 0x1be
+		U'*', U'#', U'=', U'&', U'~', U':', U';', U'♠', U'♣', U'♥', U'♦', U'★', U'◎', U'○', U'□', U'△', // 0x1bf - 0x1ce
+		U'◇', U'@', U'♪', U'%', U'☀', U'☁', U'☂', U'☃', 0, 0, 0, 0, 0, 0, 0, U' ' // 0x1cf - 0x1de
+	};
+	for(size_t i = 0; i < size(symbols); i++){ chars[0x19f + i] = symbols[i]; }
+	return chars;
+}
+constexpr auto gameCharacters = makeGameCharacters();
+
+// Unicode -> game character, pages[pageIndex[cp >> 8]][cp & 0xff] (0 if not mapped)
+struct GameTextEncoder {
+	static constexpr int maxPages = 8;
+	array<uint8_t, 256> pageIndex = {};
+	array<array<uint16_t, 256>, maxPages> pages = {};
+	int pageCount = 1;
+
+	constexpr uint16_t encode(char32_t cp) const {
+		if(cp > 0xffff){ return 0; }
+		return pages[pageIndex[cp >> 8]][cp & 0xff];
+	}
+};
+
+constexpr GameTextEncoder makeGameTextEncoder(){
+	GameTextEncoder encoder;
+
+	// Page 0 of the table stays empty for unmapped pages
+	auto add = [&](char32_t cp, uint16_t code){
+		if(!encoder.pageIndex[cp >> 8]){ encoder.pageIndex[cp >> 8] = encoder.pageCount++; }
+		encoder.pages[encoder.pageIndex[cp >> 8]][cp & 0xff] = code;
+	};
+	for(int code = 0; code < gameCharacterCount; code++){
+		if(gameCharacters[code]){ add(gameCharacters[code], code); }
+	}
+
+	// ASCII apostrophe and quotes are accepted for convenience (e.g. "Farfetch'd")
+	add(U'\'', 0x1b3);
+	add(U'"', 0x1b5);
+	return encoder;
+}
+constexpr auto gameTextEncoder = makeGameTextEncoder();
+static_assert(gameTextEncoder.pageCount <= GameTextEncoder::maxPages, "too many pages in game text encoder");
+static_assert(gameTextEncoder.encode(U'A') == 0x12b && gameTextEncoder.encode(U'♀') == 0x1bc, "game text encoder mismatch");
+
+// Read one code point from UTF-8 'text' at 'pos', returns replacementCharacter for malformed input
+char32_t nextCodePoint(string_view text, size_t& pos){
+	unsigned char c = text[pos++];
+	if(c < 0x80){ return c; }
+
+	int extra = (c >= 0xf0) ? 3 : (c >= 0xe0) ? 2 : (c >= 0xc0) ? 1 : -1;
+	if(extra < 0 || pos + extra > text.size()){ return replacementCharacter; }
+	char32_t cp = c & (0x3f >> extra);
+	for(int i = 0; i < extra; i++){
+		unsigned char next = text[pos];
+		if((next & 0xc0) != 0x80){ return replacementCharacter; }
+		cp = (cp << 6) | (next & 0x3f);
+		pos++;
+	}
+	return cp;
+}
+
+// Append code point 'cp' as UTF-8 to 'out', returns false if it doesn't fit
+bool appendCodePoint(char32_t cp, char* out, size_t outSize, size_t& len){
+	int count = (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+	if(len + count > outSize){ return false; }
+	if(count == 1){ out[len++] = cp; return true; }
+	out[len++] = ((0xf00 >> count) & 0xf0) | (cp >> (6 * (count - 1)));
+	for(int i = count - 2; i >= 0; i--){ out[len++] = 0x80 | ((cp >> (6 * i)) & 0x3f); }
+	return true;
+}
+
+// Game character for a single unicode code point, throws if the game can't display it
+int toGameEncoding(char32_t c){
+	uint16_t code = gameTextEncoder.encode(c);
+	if(!code){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid characters detected");
+	}
+	return code;
+}
+
+// Unicode code point for a single game character, throws if the character is not mapped
+char32_t fromGameEncoding(int n){
+	if(n >= 0 && n < gameCharacterCount && gameCharacters[n]){
+		return gameCharacters[n];
+	}
+	throw SaveError(SaveErrorCode::invalidArgument, "invalid characters detected");
+}
+
+// Encode UTF-8 'text' into a game text field of 'fieldChars' characters: text, terminator, zero padding
+// Returns the number of characters written, or -1 if the text doesn't fit or has characters the game can't display
+int encodeGameText(string_view text, unsigned char* field, size_t fieldChars){
+	size_t count = 0;
+	size_t pos = 0;
+	while(pos < text.size()){
+		uint16_t code = gameTextEncoder.encode(nextCodePoint(text, pos));
+		if(!code || count + 1 >= fieldChars){ return -1; }
+		field[2*count] = code & 0xff;
+		field[2*count + 1] = code >> 8;
+		count++;
+	}
+
+	field[2*count] = gameTextTerminator & 0xff;
+	field[2*count + 1] = gameTextTerminator >> 8;
+	memset(field + 2*(count + 1), 0, 2*(fieldChars - count - 1));
+	return count;
+}
+
+// Decode a game text field of at most 'fieldChars' characters into UTF-8 at 'out', stops at the terminator
+// Unmapped characters become U+FFFD, returns the length written ('out' is always NUL terminated)
+size_t decodeGameText(const unsigned char* field, size_t fieldChars, char* out, size_t outSize){
+	size_t len = 0;
+	if(outSize == 0){ return 0; }
+	for(size_t i = 0; i < fieldChars; i++){
+		uint16_t code = field[2*i] | (field[2*i + 1] << 8);
+		if(code == gameTextTerminator){ break; }
+
+		char32_t cp = (code < gameCharacterCount && gameCharacters[code]) ? gameCharacters[code]
+			: (code == gameTextNewline) ? U'\n' : replacementCharacter;
+		if(!appendCodePoint(cp, out, outSize - 1, len)){ break; }
+	}
+	out[len] = 0;
+	return len;
+}
+
+// Decode 'count' text fields that are 'stride' bytes apart (e.g. the nicknames of consecutive records)
+// into fixed size slots of 'outStride' bytes, 'lengths' receives the decoded length of every field
+void decodeGameTextBulk(const unsigned char* fields, size_t count, size_t stride, size_t fieldChars, char* out, size_t outStride, size_t* lengths){
+	for(size_t i = 0; i < count; i++){
+		lengths[i] = decodeGameText(fields + i * stride, fieldChars, out + i * outStride, outStride);
+	}
+}
+
+
+// - - - Handle Pokemon Encryption Functions - - - //
+
+/* Notes:
+	-> A record is 136 bytes: personality value (0x00), flags (0x04), checksum (0x06) and four 32 byte data blocks (0x08 - 0x87)
+	-> The data blocks are stored shuffled (order depends on the personality value) and encrypted with a LCG seeded by the checksum
+	-> Decoded records are kept in ABCD order, so a field is always at the same offset (see getFieldOffset)
+*/
+
+// Pokemon data is divided into 4 shuffled blocks of data, this function returns an array of offsets to each block such that:
+	// -> the offset to block A is at index 0
+	// -> the offset to block B is at index 1
+	// -> the offset to block C is at index 2
+	// -> the offset to block D is at index 3
+
+const array<int, 4>& getBlockOffsets(uint32_t pv){
+
+	// Note: pv stands for Personality Value
+
+	static const array<int, 4> orderTable[24] = {
+
+			// A offset -> index 0; B offset -> index 1; C offset -> index 2; D offset -> index 3
+
+			{0,32,64,96}, //ABCD
+			{0,32,96,64}, //ABDC
+			{0,64,32,96}, //ACBD
+			{0,96,32,64}, //ACDB
+			{0,64,96,32}, //ADBC
+			{0,96,64,32}, //ADCB
+			{32,0,64,96}, //BACD
+			{32,0,96,64}, //BADC
+			{64,0,32,96}, //BCAD
+			{96,0,32,64}, //BCDA
+			{64,0,96,32}, //BDAC
+			{96,0,64,32}, //BDCA
+			{32,64,0,96}, //CABD
+			{32,96,0,64}, //CADB
+			{64,32,0,96}, //CBAD
+			{96,32,0,64}, //CBDA
+			{64,96,0,32}, //CDAB
+			{96,64,0,32}, //CDBA
+			{32,64,96,0}, //DABC
+			{32,96,64,0}, //DACB
+			{64,32,96,0}, //DBAC
+			{96,32,64,0}, //DBCA
+			{64,96,32,0}, //DCAB
+			{96,64,32,0}  //DCBA
+	};
+	return orderTable[((pv & 0x3e000) >> 0xd) % 24];
+}
+
+/* Notes:
+	-> The LCG is seed(n + 1) = A * seed(n) + C (mod 2^32), every step gives one 16 bit keystream word (the high half of the seed)
+	-> Stepping k times is again a multiply-add: seed(n + k) = A^k * seed(n) + C_k with C_k = C * (A^(k-1) + ... + A + 1)
+	-> The vector kernels keep seed(n + 1) ... seed(n + L) in L lanes and advance all of them by L steps with one multiply-add,
+	   the keystream words are then XORed into the data 16 or 32 bytes at a time
+*/
+
+struct LcgJump {
+	uint32_t mul;
+	uint32_t add;
+};
+
+// lcgJumps[k] advances a seed by k steps
+constexpr array<LcgJump, 17> makeLcgJumps(){
+	array<LcgJump, 17> jumps = {};
+	jumps[0] = {1, 0};
+	for(size_t k = 1; k < jumps.size(); k++){
+		jumps[k] = {jumps[k-1].mul * lcgMultiplier, jumps[k-1].add * lcgMultiplier + lcgIncrement};
+	}
+	return jumps;
+}
+constexpr auto lcgJumps = makeLcgJumps();
+
+// Seed after 'steps' steps of the LCG
+constexpr uint32_t lcgAdvance(uint32_t seed, uint64_t steps){
+	uint32_t mul = lcgMultiplier, add = lcgIncrement;
+	for(; steps; steps >>= 1){
+		if(steps & 1){ seed = seed * mul + add; }
+		add = add * mul + add;
+		mul = mul * mul;
+	}
+	return seed;
+}
+
+// Byte order of a 16 bit word read from the save with memcpy
+constexpr uint16_t littleEndian16(uint16_t value){
+	if constexpr(endian::native == endian::big){ return (value >> 8) | (value << 8); }
+	return value;
+}
+
+// Portable kernel, one 16 bit word per step
+void prngScalar(unsigned char* data, uint32_t seed, size_t count){
+	size_t i = 0;
+	for(; i + 2 <= count; i += 2){
+		seed = (lcgMultiplier * seed) + lcgIncrement;
+		uint16_t word;
+		memcpy(&word, data + i, 2);
+		word ^= littleEndian16(seed >> 16);
+		memcpy(data + i, &word, 2);
+	}
+	if(i < count){
+		seed = (lcgMultiplier * seed) + lcgIncrement;
+		data[i] ^= (seed >> 16) & 0xff;
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// 8 keystream words per step: two vectors of 4 lanes, advanced by 8 steps each time
+__attribute__((target("sse4.1")))
+void prngSse41(unsigned char* data, uint32_t seed, size_t count){
+	const __m128i jumpMul = _mm_set1_epi32(lcgJumps[8].mul);
+	const __m128i jumpAdd = _mm_set1_epi32(lcgJumps[8].add);
+	const __m128i start = _mm_set1_epi32(seed);
+	__m128i lo = _mm_add_epi32(_mm_mullo_epi32(start, _mm_setr_epi32(lcgJumps[1].mul, lcgJumps[2].mul, lcgJumps[3].mul, lcgJumps[4].mul)),
+		_mm_setr_epi32(lcgJumps[1].add, lcgJumps[2].add, lcgJumps[3].add, lcgJumps[4].add));
+	__m128i hi = _mm_add_epi32(_mm_mullo_epi32(start, _mm_setr_epi32(lcgJumps[5].mul, lcgJumps[6].mul, lcgJumps[7].mul, lcgJumps[8].mul)),
+		_mm_setr_epi32(lcgJumps[5].add, lcgJumps[6].add, lcgJumps[7].add, lcgJumps[8].add));
+
+	size_t i = 0;
+	for(; i + 16 <= count; i += 16){
+		__m128i key = _mm_packus_epi32(_mm_srli_epi32(lo, 16), _mm_srli_epi32(hi, 16));
+		__m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+		_mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(block, key));
+		lo = _mm_add_epi32(_mm_mullo_epi32(lo, jumpMul), jumpAdd);
+		hi = _mm_add_epi32(_mm_mullo_epi32(hi, jumpMul), jumpAdd);
+	}
+	if(i < count){ prngScalar(data + i, lcgAdvance(seed, i / 2), count - i); }
+}
+
+// 16 keystream words per step: two vectors of 8 lanes, advanced by 16 steps each time
+__attribute__((target("avx2")))
+void prngAvx2(unsigned char* data, uint32_t seed, size_t count){
+	const __m256i jumpMul = _mm256_set1_epi32(lcgJumps[16].mul);
+	const __m256i jumpAdd = _mm256_set1_epi32(lcgJumps[16].add);
+	const __m256i start = _mm256_set1_epi32(seed);
+	__m256i lo = _mm256_add_epi32(_mm256_mullo_epi32(start, _mm256_setr_epi32(lcgJumps[1].mul, lcgJumps[2].mul, lcgJumps[3].mul, lcgJumps[4].mul,
+		lcgJumps[5].mul, lcgJumps[6].mul, lcgJumps[7].mul, lcgJumps[8].mul)),
+		_mm256_setr_epi32(lcgJumps[1].add, lcgJumps[2].add, lcgJumps[3].add, lcgJumps[4].add, lcgJumps[5].add, lcgJumps[6].add, lcgJumps[7].add, lcgJumps[8].add));
+	__m256i hi = _mm256_add_epi32(_mm256_mullo_epi32(start, _mm256_setr_epi32(lcgJumps[9].mul, lcgJumps[10].mul, lcgJumps[11].mul, lcgJumps[12].mul,
+		lcgJumps[13].mul, lcgJumps[14].mul, lcgJumps[15].mul, lcgJumps[16].mul)),
+		_mm256_setr_epi32(lcgJumps[9].add, lcgJumps[10].add, lcgJumps[11].add, lcgJumps[12].add, lcgJumps[13].add, lcgJumps[14].add, lcgJumps[15].add, lcgJumps[16].add));
+
+	size_t i = 0;
+	for(; i + 32 <= count; i += 32){
+		// packus works within 128 bit halves, the permute puts the words back in stream order
+		__m256i key = _mm256_permute4x64_epi64(_mm256_packus_epi32(_mm256_srli_epi32(lo, 16), _mm256_srli_epi32(hi, 16)), 0xd8);
+		__m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_xor_si256(block, key));
+		lo = _mm256_add_epi32(_mm256_mullo_epi32(lo, jumpMul), jumpAdd);
+		hi = _mm256_add_epi32(_mm256_mullo_epi32(hi, jumpMul), jumpAdd);
+	}
+	if(i < count){ prngSse41(data + i, lcgAdvance(seed, i / 2), count - i); }
+}
+
+#endif
+
+using PrngKernel = void (*)(unsigned char*, uint32_t, size_t);
+
+// Pick the widest encryption kernel the CPU supports
+static PrngKernel selectPrngKernel(){
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")){ return prngAvx2; }
+	if(__builtin_cpu_supports("sse4.1")){ return prngSse41; }
+#endif
+	return prngScalar;
+}
+
+// Encrypt/Decrypt 'count' bytes of pokemon data (linear congruential generator)
+void prng(unsigned char* data, uint32_t seed, size_t count){
+	static const PrngKernel kernel = selectPrngKernel();
+	PhaseTimer<> timer(statPrng, count);
+	kernel(data, seed, count);
+}
+
+// Encrypt/Decrypt 'records' blocks of 'count' bytes, 'stride' bytes apart, block i uses 'seeds[i]'
+void prngBatch(unsigned char* data, size_t stride, const uint32_t* seeds, size_t records, size_t count){
+	static const PrngKernel kernel = selectPrngKernel();
+	PhaseTimer<> timer(statPrng, records * count);
+	for(size_t r = 0; r < records; r++){
+		kernel(data + r * stride, seeds[r], count);
+	}
+}
+
+// Calculate the checksum of the (decrypted) 128 bytes of pokemon data blocks
+int calcPokemonChecksum(span<const unsigned char> dataChunk){
+	PhaseTimer<> timer(statPokemonChecksum, dataChunk.size());
+	int sum = 0;
+	for(unsigned long i = 0; i + 1 < dataChunk.size(); i += 2){
+		sum += (dataChunk[i+1] << 8) + dataChunk[i];
+	}
+	return sum & 0xffff;
+}
+
+// Decrypt and unshuffle the encrypted record at 'src' into 'out'
+void decodePokemon(const unsigned char* src, unsigned char* out){
+	uint32_t pv = src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+	uint32_t checksum = src[6] | (src[7] << 8);
+	const array<int, 4>& blockOffsets = getBlockOffsets(pv);
+
+	unsigned char decrypted[pokemonRecordSize - 8];
+	memcpy(decrypted, src + 8, sizeof(decrypted));
+	prng(decrypted, checksum, sizeof(decrypted));
+
+	memcpy(out, src, 8);
+	for(int i = 0; i < 4; i++){
+		memcpy(out + 8 + i * pokemonDataBlockSize, decrypted + blockOffsets[i], pokemonDataBlockSize);
+	}
+}
+
+// Recompute the checksum of the decoded record 'record' (stored back into it), then shuffle and encrypt it into 'out'
+void encodePokemon(unsigned char* record, unsigned char* out){
+	int checksum = calcPokemonChecksum(span<const unsigned char>(record + 8, pokemonRecordSize - 8));
+	record[6] = checksum & 0xff;
+	record[7] = checksum >> 8;
+
+	uint32_t pv = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+	const array<int, 4>& blockOffsets = getBlockOffsets(pv);
+
+	memcpy(out, record, 8);
+	for(int i = 0; i < 4; i++){
+		memcpy(out + 8 + blockOffsets[i], record + 8 + i * pokemonDataBlockSize, pokemonDataBlockSize);
+	}
+	prng(out + 8, checksum, pokemonRecordSize - 8);
+}
+
+
+// - - - Pokemon View - - - //
+
+// Update the small block checksum after edits, once per batch of edits
+void updateSmallBlockChecksum(SaveBuffer& data, int block, int version){
+	updateChecksum(data, calcSmallBlockChecksum(data, block, version), block, version);
+}
+
+
+// - - - Personality Value Search Functions - - - //
+
+/* Notes:
+	-> The personality value (PV) decides a pokemon's nature (pv % 25), gender (low byte against the species' gender threshold),
+	   which of its two abilities it has (bit 0) and the shuffle order of its data blocks
+	-> A pokemon is shiny if (tid ^ sid ^ pv high half ^ pv low half) < 8, so for a shiny PV the high half follows from the low half
+	   and 3 free bits: the shiny search space is 2^19 instead of 2^32
+	-> The low byte range is fixed by the constraints, so candidates are built as (upper bits << 8) | low byte and never have to
+	   be filtered on it
+	-> Candidates are evaluated in chunks with branch free predicates, hits are compacted into a buffer and handed out per chunk
+*/
+
+// Largest chunk (in PVs) findPersonalityValue searches without allocating
+#define pvStackHits 2048
+
+// Number of chunks the search space of 'c' is split into
+static size_t pvChunkCount(const PvConstraints& c){
+	// Shiny: one chunk per high byte of the low half. Otherwise 256 values of the upper 24 bits per chunk
+	return c.shiny ? 256 : (1 << 16);
+}
+
+// Write every hit of chunk 'chunk' to 'hits' (in enumeration order), returns the number of hits
+static size_t searchPvChunk(const PvConstraints& c, size_t chunk, uint32_t* hits){
+	const uint32_t lowCount = c.lowByteMax - c.lowByteMin + 1;
+	const bool anyNature = c.nature < 0, anyAbility = c.abilityBit < 0, anyShuffle = c.shuffle < 0;
+	const uint32_t nature = c.nature, abilityBit = c.abilityBit, shuffle = c.shuffle;
+	size_t n = 0;
+
+	auto test = [&](uint32_t pv){
+		bool ok = (anyNature | (pv % 25 == nature)) & (anyAbility | ((pv & 1) == abilityBit)) & (anyShuffle | ((uint32_t)getShuffleIndex(pv) == shuffle));
+		hits[n] = pv;
+		n += ok;
+	};
+
+	if(c.shiny){
+		const uint32_t trainer = c.tid ^ c.sid;
+		for(uint32_t low = 0; low < lowCount; low++){
+			uint32_t lo = (chunk << 8) | (c.lowByteMin + low);
+			for(uint32_t x = 0; x < 8; x++){
+				test((((trainer ^ lo ^ x) & 0xffff) << 16) | lo);
+			}
+		}
+	}
+	else{
+		for(uint32_t upper = chunk << 8; upper < (chunk + 1) << 8; upper++){
+			for(uint32_t low = 0; low < lowCount; low++){
+				test((upper << 8) | (c.lowByteMin + low));
+			}
+		}
+	}
+	return n;
+}
+
+// Call 'onHit' for every PV meeting 'constraints' until it returns false, chunks are spread over 'threads' workers
+// With one thread hits come in enumeration order, otherwise in order within a chunk but chunks may interleave
+void searchPersonalityValues(const PvConstraints& constraints, unsigned threads, const function<bool(uint32_t)>& onHit){
+	if(constraints.lowByteMin < 0 || constraints.lowByteMax > 255 || constraints.lowByteMin > constraints.lowByteMax){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid low byte range");
+	}
+	size_t chunks = pvChunkCount(constraints);
+	size_t chunkSize = 256 * 8 * (constraints.lowByteMax - constraints.lowByteMin + 1);
+	if(threads == 0){ threads = 1; }
+
+	atomic<size_t> nextChunk(0);
+	atomic<bool> stop(false);
+	mutex hitLock;
+
+	auto worker = [&](){
+		vector<uint32_t> hits(chunkSize);
+		while(!stop){
+			size_t chunk = nextChunk++;
+			if(chunk >= chunks){ return; }
+			size_t n = searchPvChunk(constraints, chunk, hits.data());
+			if(!n){ continue; }
+
+			lock_guard<mutex> guard(hitLock);
+			for(size_t i = 0; i < n && !stop; i++){
+				if(!onHit(hits[i])){ stop = true; }
+			}
+		}
+	};
+
+	vector<thread> pool;
+	for(unsigned t = 1; t < threads; t++){ pool.emplace_back(worker); }
+	worker();
+	for(thread& t : pool){ t.join(); }
+}
+
+// First PV in enumeration order meeting 'constraints', the result does not depend on the number of threads
+optional<uint32_t> findPersonalityValue(const PvConstraints& constraints, unsigned threads){
+	size_t chunks = pvChunkCount(constraints);
+	size_t chunkSize = 256 * 8 * (constraints.lowByteMax - constraints.lowByteMin + 1);
+	if(threads == 0){ threads = 1; }
+
+	// Small single threaded searches (e.g. a shiny PV with a fixed low byte) work from the stack, the edit path doesn't allocate
+	if(threads == 1 && chunkSize <= pvStackHits){
+		uint32_t hits[pvStackHits];
+		for(size_t chunk = 0; chunk < chunks; chunk++){
+			if(searchPvChunk(constraints, chunk, hits)){ return hits[0]; }
+		}
+		return nullopt;
+	}
+
+	// Chunks are claimed in order, once a chunk has a hit no later chunk has to be searched
+	atomic<size_t> nextChunk(0);
+	atomic<size_t> bestChunk(SIZE_MAX);
+	mutex bestLock;
+	uint32_t best = 0;
+
+	auto worker = [&](){
+		vector<uint32_t> hits(chunkSize);
+		while(true){
+			size_t chunk = nextChunk++;
+			if(chunk >= chunks || chunk > bestChunk){ return; }
+			if(!searchPvChunk(constraints, chunk, hits.data())){ continue; }
+
+			lock_guard<mutex> guard(bestLock);
+			if(chunk < bestChunk){
+				bestChunk = chunk;
+				best = hits[0];
+			}
+		}
+	};
+
+	vector<thread> pool;
+	for(unsigned t = 1; t < threads; t++){ pool.emplace_back(worker); }
+	worker();
+	for(thread& t : pool){ t.join(); }
+
+	if(bestChunk == SIZE_MAX){ return nullopt; }
+	return best;
+}
+
+
+// - - - Seed Search Functions - - - //
+
+/* Notes:
+	-> The games generate pokemon with the same LCG that encrypts them, one call advances the seed and returns its high 16 bits
+	-> Method 1 (static encounters): PV low, PV high, IVs HP/Atk/Def, IVs Spe/SpA/SpD (bit 15 of the IV calls is ignored)
+	-> Method J (DPPt wild) and K (HGSS wild) first pick a nature (J: call / 0xa3e, K: call % 25) and then draw PV pairs until
+	   one has that nature, followed by the two IV calls
+	-> Finding the seeds of a PV: the seed after the PV low call is (pv low << 16) | x, only the 16 bits x are unknown.
+	   The high half of the next seed is high(A * (pv low << 16) + C) + high(A * x) (+ 1 if the low halves carry), so x has to be
+	   in one of two buckets of a table indexed by high(A * x): about 2 candidates to check instead of 65536
+	-> The IVs then confirm the candidates, going backwards (inverse LCG) gives the seed before the first call and from there
+	   the frame since the last initial seed. DS initial seeds look like 0xAABBCCCC with BB the hour (< 24) and CCCC the delay
+*/
+
+static_assert(lcgMultiplier * lcgInverseMultiplier == 1u, "inverse LCG multiplier is wrong");
+static_assert(lcgInverseMultiplier * lcgIncrement + lcgInverseIncrement == 0u, "inverse LCG increment is wrong");
+
+// Low halves x grouped by high(A * x), members of bucket v are low[start[v]] ... low[start[v + 1] - 1]
+struct SeedLowTable {
+	vector<uint32_t> start;
+	vector<uint16_t> low;
+};
+
+static const SeedLowTable& getSeedLowTable(){
+	static const SeedLowTable table = [](){
+		SeedLowTable t;
+		t.start.assign(0x10001, 0);
+		t.low.resize(0x10000);
+		for(uint32_t x = 0; x < 0x10000; x++){ t.start[((lcgMultiplier * x) >> 16) + 1]++; }
+		for(uint32_t v = 0; v < 0x10000; v++){ t.start[v + 1] += t.start[v]; }
+		vector<uint32_t> fill(t.start.begin(), t.start.end() - 1);
+		for(uint32_t x = 0; x < 0x10000; x++){ t.low[fill[(lcgMultiplier * x) >> 16]++] = x; }
+		return t;
+	}();
+	return table;
+}
+
+// Every seed whose call returns 'first' and whose next call returns 'second', returns how many were written to 'out' (at most 4)
+size_t findConsecutiveSeeds(uint16_t first, uint16_t second, uint32_t* out){
+	const SeedLowTable& table = getSeedLowTable();
+	uint32_t base = lcgNext((uint32_t)first << 16);
+	size_t n = 0;
+
+	for(uint32_t carry = 0; carry < 2; carry++){
+		uint16_t bucket = second - (base >> 16) - carry;
+		for(uint32_t i = table.start[bucket]; i < table.start[bucket + 1] && n < 4; i++){
+			uint32_t seed = ((uint32_t)first << 16) | table.low[i];
+			if((lcgNext(seed) >> 16) == second){ out[n++] = seed; }
+		}
+	}
+	return n;
+}
+
+// Walk back from 'seed' to the closest initial seed, fills in the frame of 'hit'
+void findInitialSeed(SeedHit& hit, int maxFrames){
+	uint32_t seed = hit.originSeed;
+	hit.frame = -1;
+	for(int frame = 0; frame <= maxFrames; frame++){
+		if(((seed >> 16) & 0xff) < 24 && (seed & 0xffff) <= seedMaxDelay){
+			hit.initialSeed = seed;
+			hit.frame = frame;
+			return;
+		}
+		seed = lcgPrev(seed);
+	}
+}
+
+// Every way Method 1 and Method J (DPPt) or K (HGSS) can produce 'pv' together with 'ivs' (as stored in a record)
+vector<SeedHit> findGenerationSeeds(uint32_t pv, uint32_t ivs, int version, int maxFrames){
+	vector<SeedHit> hits;
+	uint32_t candidates[4];
+	size_t n = findConsecutiveSeeds(pv & 0xffff, pv >> 16, candidates);
+	int wildMethod = (version == heartgold) ? methodK : methodJ;
+	int nature = pv % 25;
+
+	for(size_t i = 0; i < n; i++){
+		uint32_t ivSeed1 = lcgNext(lcgNext(candidates[i]));
+		uint32_t ivSeed2 = lcgNext(ivSeed1);
+		if(((ivSeed1 >> 16) & 0x7fff) != (ivs & 0x7fff) || ((ivSeed2 >> 16) & 0x7fff) != ((ivs >> 15) & 0x7fff)){ continue; }
+
+		// Seed before the PV low call
+		uint32_t seed = lcgPrev(candidates[i]);
+		hits.push_back({methodOne, seed, 0, -1});
+
+		// The call that led to 'seed' is either the nature call or the PV high call of a rejected pair
+		for(int rejects = 0; rejects <= seedMaxRejects; rejects++){
+			if(getMethodNature(seed >> 16, wildMethod) == nature){ hits.push_back({wildMethod, lcgPrev(seed), 0, -1}); }
+			uint32_t rejectedLow = lcgPrev(seed);
+			if((((seed >> 16) << 16) | (rejectedLow >> 16)) % 25 == (uint32_t)nature){ break; }
+			seed = lcgPrev(rejectedLow);
+		}
+	}
+
+	for(SeedHit& hit : hits){ findInitialSeed(hit, maxFrames); }
+	return hits;
+}
+
+
+// - - - PC Box Storage Functions - - - //
+
+/* Notes:
+	-> The PC has 18 boxes of 30 pokemon, the boxes are stored back to back (boxSize apart) in the big block
+	-> Boxed pokemon only have the 136 byte record (no party stats), an empty slot is all zero bytes
+	-> Big blocks are not always saved together with the small blocks, the one with the higher save counter is current
+	-> BoxStorage decodes the whole PC at once, edits only change the decoded copy and commit() encrypts the
+	   edited slots back and updates the big block checksum once
+*/
+
+// Offset of big block 'block' in the save file
+size_t getBigBlockOffset(int block, int version){
+	if(block != 1 && block != 2){
+		throw SaveError(SaveErrorCode::invalidArgument, "could not find PC box data");
+	}
+	return withVersionLayout(version, [&](auto layout){ return layout.bigBlock(getSmallBlockOffset(block)); });
+}
+
+// Find out in which big block the boxes were last saved, 'smallBlock' (the current small block) is used if the counters don't tell
+int getCurBigBlock(const SaveBuffer& data, int version, int smallBlock){
+	auto [counter1, counter2] = withVersionLayout(version, [&](auto layout){
+		if(data.size() < layout.saveSize){
+			throw SaveError(SaveErrorCode::invalidSave, "file is too small to be a save file");
+		}
+		auto saveCounter = [&](size_t small){
+			size_t pos = layout.bigCounter(layout.bigBlock(small));
+			return data[pos] | (data[pos+1] << 8) | (data[pos+2] << 16) | ((uint32_t)data[pos+3] << 24);
+		};
+		return pair<uint32_t, uint32_t>(saveCounter(smallBlock1), saveCounter(smallBlock2));
+	});
+
+	// Blocks that were never written read as 0xff
+	if(counter1 == 0xffffffff && counter2 != 0xffffffff){ return 2; }
+	if(counter2 == 0xffffffff && counter1 != 0xffffffff){ return 1; }
+	if(counter1 > counter2){ return 1; }
+	else if(counter1 < counter2){ return 2; }
+	return smallBlock;
+}
+
+// Offset of the record in 'slot' of 'box' (both counted from 0) in big block 'block'
+size_t getBoxSlotOffset(int block, int version, int box, int slot){
+	if(box < 0 || box >= boxCount || slot < 0 || slot >= boxSlotCount){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid box slot");
+	}
+	size_t big = getBigBlockOffset(block, version);
+	return withVersionLayout(version, [&](auto layout){ return layout.boxSlot(big, box, slot); });
+}
+
+// Checksum of the big block 'block' after editing
+int calcBigBlockChecksum(const SaveBuffer& data, int block, int version){
+	size_t blockOffset = getBigBlockOffset(block, version);
+	return withVersionLayout(version, [&](auto layout){
+		return calcBlockChecksum(data, blockOffset, layout.bigLength, layout.bigChecksum(blockOffset));
+	});
+}
+
+// Update the big block checksum after box edits, once per batch of edits
+void updateBigBlockChecksum(SaveBuffer& data, int block, int version){
+	int newValue = calcBigBlockChecksum(data, block, version);
+	size_t big = getBigBlockOffset(block, version);
+	size_t pos = withVersionLayout(version, [&](auto layout){ return layout.bigChecksum(big); });
+	data[pos] = newValue & 0xff;
+	data[pos + 1] = newValue >> 8;
+}
+
+// An empty box slot (or a released pokemon) is all zero bytes
+bool isEmptyRecord(const unsigned char* record){
+	uint64_t bits = 0;
+	for(int i = 0; i < pokemonRecordSize; i += 8){
+		uint64_t word;
+		memcpy(&word, record + i, 8);
+		bits |= word;
+	}
+	return bits == 0;
+}
+
+// Decode 'count' encrypted records at 'src', 'srcStride' bytes apart, into 'out' (packed), empty records stay all zero
+// Records are decrypted in chunks with one prngBatch call, so the kernel is selected once per chunk
+void decodePokemonBatch(const unsigned char* src, size_t count, unsigned char* out, size_t srcStride){
+	const size_t chunk = 32;
+	unsigned char decrypted[chunk][pokemonRecordSize - 8];
+	uint32_t seeds[chunk];
+
+	for(size_t first = 0; first < count; first += chunk){
+		size_t n = min(chunk, count - first);
+		for(size_t i = 0; i < n; i++){
+			const unsigned char* record = src + (first + i) * srcStride;
+			seeds[i] = record[6] | (record[7] << 8);
+			memcpy(decrypted[i], record + 8, pokemonRecordSize - 8);
+		}
+		prngBatch(decrypted[0], pokemonRecordSize - 8, seeds, n, pokemonRecordSize - 8);
+
+		for(size_t i = 0; i < n; i++){
+			const unsigned char* record = src + (first + i) * srcStride;
+			unsigned char* decoded = out + (first + i) * pokemonRecordSize;
+			if(isEmptyRecord(record)){
+				memset(decoded, 0, pokemonRecordSize);
+				continue;
+			}
+			uint32_t pv = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+			const array<int, 4>& blockOffsets = getBlockOffsets(pv);
+			memcpy(decoded, record, 8);
+			for(int k = 0; k < 4; k++){
+				memcpy(decoded + 8 + k * pokemonDataBlockSize, decrypted[i] + blockOffsets[k], pokemonDataBlockSize);
+			}
+		}
+	}
+}
+
+// Decode all boxes of the current big block, 'threads' workers split the boxes between them
+BoxStorage::BoxStorage(SaveBuffer& save, int version, unsigned threads) : data(save), saveVersion(version), records(pcSlotCount * pokemonRecordSize) {
+	block = getCurBigBlock(data, saveVersion, getCurBlock(data, saveVersion));
+	load(threads);
+}
+
+// Number of slots holding a pokemon
+size_t BoxStorage::occupied() const {
+	size_t n = 0;
+	for(size_t i = 0; i < pcSlotCount; i++){ n += !isEmptyRecord(&records[i * pokemonRecordSize]); }
+	return n;
+}
+
+// Encrypt every edited slot back into the save and update the big block checksum, returns the number of slots written
+size_t BoxStorage::commit(){
+	size_t written = 0;
+	unsigned char encrypted[pokemonRecordSize];
+
+	size_t big = getBigBlockOffset(block, saveVersion);
+	withVersionLayout(saveVersion, [&](auto layout){
+		for(size_t i = 0; i < pcSlotCount; i++){
+			if(!modified[i]){ continue; }
+			unsigned char* record = &records[i * pokemonRecordSize];
+			if(isEmptyRecord(record)){ memset(encrypted, 0, sizeof(encrypted)); }
+			else{ encodePokemon(record, encrypted); }
+
+			// Personality value and flags usually stay the same, skip them then
+			size_t offset = layout.boxSlot(big, i / boxSlotCount, i % boxSlotCount);
+			size_t skip = memcmp(data.view(offset, 6).data(), encrypted, 6) == 0 ? 6 : 0;
+			memcpy(data.writable(offset + skip, pokemonRecordSize - skip), encrypted + skip, pokemonRecordSize - skip);
+			modified[i] = false;
+			written++;
+		}
+	});
+
+	if(written){ updateBigBlockChecksum(data, block, saveVersion); }
+	return written;
+}
+
+void BoxStorage::load(unsigned threads){
+	size_t big = getBigBlockOffset(block, saveVersion);
+	withVersionLayout(saveVersion, [&](auto layout){
+		auto decodeBoxes = [this, big, layout](int first, int last){
+			for(int box = first; box < last; box++){
+				size_t offset = layout.boxSlot(big, box, 0);
+				decodePokemonBatch(data.view(offset, boxSlotCount * pokemonRecordSize).data(), boxSlotCount, &records[box * boxSlotCount * pokemonRecordSize]);
+			}
+		};
+
+		threads = clamp(threads, 1u, (unsigned)boxCount);
+		vector<thread> pool;
+		for(unsigned t = 1; t < threads; t++){
+			pool.emplace_back(decodeBoxes, boxCount * t / threads, boxCount * (t + 1) / threads);
+		}
+		decodeBoxes(0, boxCount / threads);
+		for(thread& t : pool){ t.join(); }
+	});
+}
+
+
+// - - - Party Functions - - - //
+
+/* Notes:
+	-> The party is an array of six 236 byte records starting at leadPokemonOffset, the party size is stored right before it
+	-> The first 136 bytes of a party record are the same as a boxed record, the last 100 bytes are the battle stats
+	   (level, current HP, stats, ...), encrypted with the same LCG but seeded with the personality value
+	-> Party decodes all six slots at once, commit() encrypts the edited slots back, the small block checksum
+	   has to be updated by the caller once all edits are done (like PokemonView)
+*/
+
+// Offset of party 'slot' (counted from 0) in small block 'block'
+size_t getPartySlotOffset(int block, int version, int slot){
+	if(slot < 0 || slot >= partySize){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid party slot");
+	}
+	return getLeadPokemonOffset(block, version) + slot * pokemonPartyRecordSize;
+}
+
+// Number of pokemon in the party
+int getPartyCount(const SaveBuffer& data, int block, int version){
+	int count = data[getLeadPokemonOffset(block, version) - 4];
+	return min(count, partySize);
+}
+
+Party::Party(SaveBuffer& save, int block, int version) : data(save), saveBlock(block), saveVersion(version) {
+	partyCount = getPartyCount(data, saveBlock, saveVersion);
+	partyOffset = getPartySlotOffset(saveBlock, saveVersion, 0);
+	const unsigned char* src = data.view(partyOffset, partySize * pokemonPartyRecordSize).data();
+	decodePokemonBatch(src, partySize, &records[0][0], pokemonPartyRecordSize);
+
+	uint32_t seeds[partySize];
+	for(int slot = 0; slot < partySize; slot++){
+		const unsigned char* record = src + slot * pokemonPartyRecordSize;
+		seeds[slot] = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+		memcpy(battleStats[slot], record + pokemonRecordSize, pokemonBattleStatsSize);
+	}
+	prngBatch(&battleStats[0][0], pokemonBattleStatsSize, seeds, partySize, pokemonBattleStatsSize);
+}
+
+// Encrypt every edited slot back into the save, returns the number of slots written
+size_t Party::commit(){
+	size_t written = 0;
+	unsigned char encrypted[pokemonPartyRecordSize];
+
+	for(int slot = 0; slot < partySize; slot++){
+		if(!modified[slot]){ continue; }
+		size_t offset = partyOffset + slot * pokemonPartyRecordSize;
+		encodePokemon(records[slot], encrypted);
+
+		// The battle stats only have to be encrypted again if they were replaced or the personality value changed
+		size_t length = pokemonRecordSize;
+		if(statsModified[slot] || memcmp(data.view(offset, 4).data(), encrypted, 4) != 0){
+			memcpy(encrypted + pokemonRecordSize, battleStats[slot], pokemonBattleStatsSize);
+			prng(encrypted + pokemonRecordSize, records[slot][0] | (records[slot][1] << 8) | (records[slot][2] << 16) | ((uint32_t)records[slot][3] << 24), pokemonBattleStatsSize);
+			length = pokemonPartyRecordSize;
+		}
+
+		size_t skip = memcmp(data.view(offset, 6).data(), encrypted, 6) == 0 ? 6 : 0;
+		memcpy(data.writable(offset + skip, length - skip), encrypted + skip, length - skip);
+		modified[slot] = false;
+		statsModified[slot] = false;
+		written++;
+	}
+	return written;
+}
+
+void Party::set(int slot, const unsigned char* decodedRecord, const unsigned char* stats){
+	checkSlot(slot);
+	if(slot > partyCount){
+		throw SaveError(SaveErrorCode::invalidArgument, "party slots have to be filled in order");
+	}
+	memcpy(records[slot], decodedRecord, pokemonRecordSize);
+	memcpy(battleStats[slot], stats, pokemonBattleStatsSize);
+	modified[slot] = true;
+	statsModified[slot] = true;
+	if(slot == partyCount){
+		partyCount++;
+		data[partyOffset - 4] = partyCount;
+	}
+}
+
+
+// - - - PKM File Functions - - - //
+
+// A decoded record is valid if it passes its checksum and holds a species
+static bool isValidPkmRecord(const unsigned char* record){
+	int species = record[pokemon[speciesID]] | (record[pokemon[speciesID] + 1] << 8);
+	return calcPokemonChecksum(span<const unsigned char>(record + 8, pokemonRecordSize - 8)) == (record[6] | (record[7] << 8))
+		&& species >= 1 && species <= getSpeciesCount();
+}
+
+PkmRecord parsePkm(span<const unsigned char> bytes){
+	if(bytes.size() != pokemonRecordSize && bytes.size() != pokemonPartyRecordSize){
+		throw SaveError(SaveErrorCode::invalidArgument, "not a .pkm file (" + to_string(bytes.size()) + " bytes)");
+	}
+
+	PkmRecord result;
+	result.hasBattleStats = bytes.size() == pokemonPartyRecordSize;
+	result.encrypted = !isValidPkmRecord(bytes.data());
+	if(result.encrypted){
+		decodePokemonBatch(bytes.data(), 1, result.record);
+		if(!isValidPkmRecord(result.record)){
+			throw SaveError(SaveErrorCode::invalidSave, "pokemon checksum doesn't match");
+		}
+	}
+	else{
+		memcpy(result.record, bytes.data(), pokemonRecordSize);
+	}
+
+	if(result.hasBattleStats){
+		memcpy(result.battleStats, bytes.data() + pokemonRecordSize, pokemonBattleStatsSize);
+		if(result.encrypted){
+			prng(result.battleStats, result.record[0] | (result.record[1] << 8) | (result.record[2] << 16) | ((uint32_t)result.record[3] << 24), pokemonBattleStatsSize);
+		}
+	}
+	return result;
+}
+
+size_t writePkm(const unsigned char* decodedRecord, const unsigned char* stats, bool encrypted, unsigned char* out){
+	size_t size = stats ? pokemonPartyRecordSize : pokemonRecordSize;
+	if(stats){ memcpy(out + pokemonRecordSize, stats, pokemonBattleStatsSize); }
+	if(!encrypted){
+		memcpy(out, decodedRecord, pokemonRecordSize);
+		return size;
+	}
+
+	unsigned char record[pokemonRecordSize];
+	memcpy(record, decodedRecord, pokemonRecordSize);
+	encodePokemon(record, out);
+	if(stats){ prng(out + pokemonRecordSize, record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24), pokemonBattleStatsSize); }
+	return size;
+}
+
+
+// - - - Player Editing Functions - - - //
+
+// Write a new player name, the small block checksum is updated by the caller
+void setPlayerName(SaveBuffer& data, string_view newName, int block, int version){
+	if(block != 1 && block != 2){
+		throw SaveError(SaveErrorCode::invalidArgument, "couldn't change player name");
+	}
+
+	// Encode first so an invalid name leaves the save untouched
+	unsigned char encoded[trainerNameChars * 2];
+	if(encodeGameText(newName, encoded, trainerNameChars) < 0){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid name, make sure the desired name is at most 7 characters long and consists of characters the game can display");
+	}
+
+	size_t pos = withVersionLayout(version, [&](auto layout){ return layout.trainerName(getSmallBlockOffset(block)); });
+	memcpy(data.writable(pos, sizeof(encoded)), encoded, sizeof(encoded));
+}
+
+// Write a new player name and update the small block checksum
+void changePlayerName(SaveBuffer& data, string_view newName, int block, int version){
+	setPlayerName(data, newName, block, version);
+
+	// Update save file checksum (of the block that was edited)
+	updateSmallBlockChecksum(data, block, version);
+}
+
+
+// - - - Pokemon Editing Functions - - - //
+
+// Edit the species of a pokemon
+void editPokemonSpecies(PokemonRecord& view, string_view pokemonName){
+
+	// Get Pokemon Species ID for given 'pokemonName'
+	int id = getSpeciesID(pokemonName);
+	if(!id){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid Pokemon name");
+	}
+
+	// Update pokemon species and name (species names are ASCII and always fit a nickname)
+	char upperName[nicknameChars];
+	size_t length = min(pokemonName.size(), sizeof(upperName));
+	for(size_t i = 0; i < length; i++){ upperName[i] = toupper(pokemonName[i]); }
+	view.setSpecies(id);
+	view.setNickname(string_view(upperName, length));
+}
+
+// Edit the ability of a pokemon
+void editPokemonAbility(PokemonRecord& view, string_view abilityName){
+
+	// Get the Ability ID for given 'abilityName'
+	int id = getAbilityID(abilityName);
+	if(!id){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid Ability name");
+	}
+	view.setAbility(id);
+}
+
+// Edit the moves of a pokemon, the move's PP is set to its base PP
+void editPokemonMove(PokemonRecord& view, string_view moveName, int moveSlot){
+
+	// Make sure the value of 'moveSlot' is valid
+	if(moveSlot < 1 || moveSlot > 4){
+		throw SaveError(SaveErrorCode::invalidArgument, "could not edit pokemon");
+	}
+
+	// Get Move ID and PP amount for given 'moveName'
+	int id = getMoveID(moveName);
+	if(!id){
+		throw SaveError(SaveErrorCode::invalidArgument, "invalid Move name");
+	}
+	view.setMove(moveSlot, id);
+	view.setPP(moveSlot, getMovePP(id));
+}
+
+// Make a pokemon shiny for its original trainer
+// A new personality value is searched that keeps the nature, gender and ability (low byte), the trainer IDs are not touched
+void makePokemonShiny(PokemonRecord& view){
+	if(view.isShiny()){ return; }
+
+	uint32_t pv = view.getPersonalityValue();
+	PvConstraints constraints;
+	constraints.shiny = true;
+	constraints.tid = view.getOtId();
+	constraints.sid = view.getOtSecretId();
+	constraints.nature = pv % 25;
+	constraints.lowByteMin = constraints.lowByteMax = pv & 0xff;
+
+	optional<uint32_t> shinyPv = findPersonalityValue(constraints);
+	if(!shinyPv){
+		throw SaveError(SaveErrorCode::notFound, "no shiny personality value keeps this pokemon's nature and gender");
+	}
+	view.setPersonalityValue(*shinyPv);
+}
+
+// Set the PP of every move to its maximum (base PP raised by the PP Ups used on it)
+void restorePokemonPP(PokemonRecord& view){
+	for(int slot = 1; slot <= 4; slot++){
+		int move = view.getMove(slot);
+		if(!move){ continue; }
+		view.setPP(slot, getMovePP(move) * (5 + view.getPPUps(slot)) / 5);
+	}
+}
+
+// Apply one edit to a decoded pokemon, 'option' selects the edit like in the menus
+void editPokemon(PokemonRecord& view, string_view pokemonName, string_view abilityName, string_view moveName, int moveSlot, int option){
+	switch(option){
+		case 1:
+			// Edit Pokemon Species
+			editPokemonSpecies(view, pokemonName);
+			break;
+		case 2:
+			// Edit Pokemon Ability
+			editPokemonAbility(view, abilityName);
+			break;
+		case 3:
+			// Edit Pokemon Moves
+			editPokemonMove(view, moveName, moveSlot);
+			break;
+		case 4:
+			// Make Pokemon Shiny
+			makePokemonShiny(view);
+			break;
+		case 5:
+			// Restore Pokemon PP
+			restorePokemonPP(view);
+			break;
+		default:
+			throw SaveError(SaveErrorCode::invalidArgument, "could not edit pokemon");
+	}
+}
+
+// Apply one edit to every pokemon in the party
+void editParty(Party& party, string_view pokemonName, string_view abilityName, string_view moveName, int moveSlot, int option){
+	for(int slot = 0; slot < party.count(); slot++){
+		PokemonRecord view = party.at(slot);
+		editPokemon(view, pokemonName, abilityName, moveName, moveSlot, option);
+	}
+}
+
+// Function that handles the encryption and calls specified pokemon edit function for the lead pokemon
+// Goes through Party because a new personality value (shiny) also re-keys the lead's battle stats
+void editPokemon(SaveBuffer& data, string_view pokemonName, string_view abilityName, string_view moveName, int moveSlot, int block, int version, int option){
+	Party party(data, block, version);
+	PokemonRecord lead = party.at(0);
+	editPokemon(lead, pokemonName, abilityName, moveName, moveSlot, option);
+	party.commit();
+	updateSmallBlockChecksum(data, block, version);
+}
+
+// Edit the whole party with one decrypt/encrypt pass and one checksum update
+void editParty(SaveBuffer& data, string_view pokemonName, string_view abilityName, string_view moveName, int moveSlot, int block, int version, int option){
+	Party party(data, block, version);
+	editParty(party, pokemonName, abilityName, moveName, moveSlot, option);
+	party.commit();
+	updateSmallBlockChecksum(data, block, version);
+}
+
+
+// - - - Save Diff Functions - - - //
+
+/* Notes:
+	-> Two snapshots of a save differ in a few hundred bytes of pokemon data, but encryption and the block checksums
+	   change many more bytes, so the diff works on the decrypted records:
+		- party and box records of both save slots are decoded (party battle stats included) and diffed field by field
+		- all other bytes are diffed as they are, except the block checksum fields
+		- every block whose bytes change gets a checksum op with the checksum the target stores
+	-> Applying a patch decodes each touched record once, applies its changes, then re-encrypts it (recomputing the
+	   pokemon checksum). The block checksums are recomputed from the dirty ranges and compared with the expected ones,
+	   so a patch applied to the wrong save is detected instead of writing a broken file
+	-> Records that don't decode to a valid record in the target (bad eggs, cleared slots) are stored verbatim, as are
+	   checksums the target stores wrong on purpose, so applying always reproduces the target exactly
+	-> Patch format (little endian): magic, version, save size, op count, ops. Ops:
+		0 raw:      offset (4), length (4), bytes
+		1 record:   record offset (4), type (1, 0 box / 1 party), position in the decoded record (2), length (2), bytes
+		2 checksum: block offset (4), block length (4), checksum offset (4), checksum (2), flags (1, 1 = verify)
+*/
+
+#define patchMagic "PSEPTCH1"
+#define patchRawOp 0
+#define patchRecordOp 1
+#define patchChecksumOp 2
+#define patchBoxRecord 0
+#define patchPartyRecord 1
+
+// Equal bytes shorter than this between two changes are copied instead of starting a new op
+#define patchMergeGap 8
+
+static void putPatchValue(vector<unsigned char>& out, uint32_t value, int bytes){
+	for(int i = 0; i < bytes; i++){ out.push_back((value >> (8 * i)) & 0xff); }
+}
+
+static uint32_t getPatchValue(span<const unsigned char> patch, size_t& pos, int bytes){
+	if(pos + bytes > patch.size()){ throw SaveError(SaveErrorCode::invalidArgument, "patch is truncated"); }
+	uint32_t value = 0;
+	for(int i = 0; i < bytes; i++){ value |= (uint32_t)patch[pos + i] << (8 * i); }
+	pos += bytes;
+	return value;
+}
+
+// Decode a box (136 bytes) or party (236 bytes) record, empty records decode to zeros, battle stats are decrypted with the PV
+static void decodePatchRecord(const unsigned char* src, int type, unsigned char* out){
+	decodePokemonBatch(src, 1, out);
+	if(type == patchPartyRecord){
+		uint32_t pv = src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+		memcpy(out + pokemonRecordSize, src + pokemonRecordSize, pokemonBattleStatsSize);
+		prng(out + pokemonRecordSize, pv, pokemonBattleStatsSize);
+	}
+}
+
+// Inverse of decodePatchRecord, the pokemon checksum of 'record' is recomputed
+static void encodePatchRecord(unsigned char* record, int type, unsigned char* out){
+	encodePokemon(record, out);
+	if(type == patchPartyRecord){
+		uint32_t pv = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+		memcpy(out + pokemonRecordSize, record + pokemonRecordSize, pokemonBattleStatsSize);
+		prng(out + pokemonRecordSize, pv, pokemonBattleStatsSize);
+	}
+}
+
+// A decoded record can be rebuilt by encodePatchRecord if its stored checksum is right
+static bool isValidDecodedRecord(const unsigned char* decoded){
+	return calcPokemonChecksum(span<const unsigned char>(decoded + 8, pokemonRecordSize - 8)) == (decoded[6] | (decoded[7] << 8));
+}
+
+struct PatchRecord {
+	size_t offset;
+	int type;
+};
+
+struct PatchBlock {
+	size_t offset;
+	size_t length; // Bytes covered by the checksum
+	size_t checksumPos;
+	size_t end; // End of the block including its footer
+};
+
+// Every record and block of both save slots of 'version'
+static void getPatchLayout(int version, vector<PatchRecord>& records, vector<PatchBlock>& blocks){
+	withVersionLayout(version, [&](auto layout){
+		for(int block = 1; block <= 2; block++){
+			size_t small = getSmallBlockOffset(block);
+			blocks.push_back({small, layout.smallLength, layout.smallChecksum(small), layout.smallChecksum(small) + 2});
+			for(int slot = 0; slot < partySize; slot++){ records.push_back({layout.partySlot(small, slot), patchPartyRecord}); }
+
+			size_t big = layout.bigBlock(small);
+			blocks.push_back({big, layout.bigLength, layout.bigChecksum(big), layout.bigChecksum(big) + 2});
+			for(int box = 0; box < boxCount; box++){
+				for(int slot = 0; slot < boxSlotCount; slot++){ records.push_back({layout.boxSlot(big, box, slot), patchBoxRecord}); }
+			}
+		}
+	});
+	sort(records.begin(), records.end(), [](const PatchRecord& a, const PatchRecord& b){ return a.offset < b.offset; });
+}
+
+// Append raw ops for the differences of base and target in [start, end)
+static void diffRawRange(const unsigned char* base, const unsigned char* target, size_t start, size_t end, vector<unsigned char>& out, size_t& opCount){
+	size_t pos = start;
+	while(pos < end){
+		// Skip equal bytes 64 at a time
+		while(pos + 64 <= end && memcmp(base + pos, target + pos, 64) == 0){ pos += 64; }
+		while(pos < end && base[pos] == target[pos]){ pos++; }
+		if(pos >= end){ break; }
+
+		size_t runEnd = pos + 1, equal = 0;
+		for(size_t i = pos + 1; i < end && equal < patchMergeGap; i++){
+			if(base[i] != target[i]){ runEnd = i + 1; equal = 0; }
+			else{ equal++; }
+		}
+		out.push_back(patchRawOp);
+		putPatchValue(out, pos, 4);
+		putPatchValue(out, runEnd - pos, 4);
+		out.insert(out.end(), target + pos, target + runEnd);
+		opCount++;
+		pos = runEnd;
+	}
+}
+
+// Structure-aware patch that turns 'base' into 'target' (both saves of 'version')
+vector<unsigned char> diffSaves(span<const unsigned char> base, span<const unsigned char> target, int version){
+	if(base.size() != target.size()){ throw SaveError(SaveErrorCode::invalidArgument, "saves differ in size"); }
+	vector<PatchRecord> records;
+	vector<PatchBlock> blocks;
+	getPatchLayout(version, records, blocks);
+	if(base.size() < blocks.back().end){ throw SaveError(SaveErrorCode::invalidSave, "file is too small to be a save file"); }
+
+	vector<unsigned char> out(patchMagic, patchMagic + strlen(patchMagic));
+	out.push_back(version);
+	putPatchValue(out, base.size(), 4);
+	size_t countPos = out.size();
+	putPatchValue(out, 0, 4);
+	size_t opCount = 0;
+
+	// Bytes that are not diffed raw: records and checksum fields
+	vector<pair<size_t, size_t>> covered;
+	for(const PatchRecord& r : records){ covered.push_back({r.offset, r.offset + (r.type == patchPartyRecord ? pokemonPartyRecordSize : pokemonRecordSize)}); }
+	for(const PatchBlock& b : blocks){ covered.push_back({b.checksumPos, b.checksumPos + 2}); }
+	sort(covered.begin(), covered.end());
+
+	unsigned char baseRecord[pokemonPartyRecordSize], targetRecord[pokemonPartyRecordSize];
+	size_t rawPos = 0, recordIndex = 0;
+	for(const auto& range : covered){
+		diffRawRange(base.data(), target.data(), rawPos, range.first, out, opCount);
+		rawPos = range.second;
+
+		if(recordIndex >= records.size() || records[recordIndex].offset != range.first){ continue; }
+		const PatchRecord& r = records[recordIndex++];
+		size_t size = range.second - range.first;
+		if(memcmp(base.data() + r.offset, target.data() + r.offset, size) == 0){ continue; }
+
+		// Empty or broken target records can't be rebuilt by encoding, they are copied as they are
+		decodePatchRecord(target.data() + r.offset, r.type, targetRecord);
+		decodePatchRecord(base.data() + r.offset, r.type, baseRecord);
+		if(isEmptyRecord(target.data() + r.offset) || !isValidDecodedRecord(targetRecord)){
+			diffRawRange(base.data(), target.data(), r.offset, range.second, out, opCount);
+			continue;
+		}
+
+		// The pokemon checksum is recomputed when encoding, it never has to be stored
+		baseRecord[6] = targetRecord[6];
+		baseRecord[7] = targetRecord[7];
+		size_t pos = 0;
+		size_t recordOps = 0;
+		while(pos < size){
+			while(pos < size && baseRecord[pos] == targetRecord[pos]){ pos++; }
+			if(pos >= size){ break; }
+			size_t runEnd = pos + 1, equal = 0;
+			for(size_t i = pos + 1; i < size && equal < patchMergeGap; i++){
+				if(baseRecord[i] != targetRecord[i]){ runEnd = i + 1; equal = 0; }
+				else{ equal++; }
+			}
+			out.push_back(patchRecordOp);
+			putPatchValue(out, r.offset, 4);
+			out.push_back(r.type);
+			putPatchValue(out, pos, 2);
+			putPatchValue(out, runEnd - pos, 2);
+			out.insert(out.end(), targetRecord + pos, targetRecord + runEnd);
+			recordOps++;
+			pos = runEnd;
+		}
+
+		// Same decoded data but different bytes (e.g. a base record with a wrong checksum): copy the record
+		if(!recordOps){ diffRawRange(base.data(), target.data(), r.offset, range.second, out, opCount); }
+		opCount += recordOps;
+	}
+	diffRawRange(base.data(), target.data(), rawPos, base.size(), out, opCount);
+
+	// Blocks with changes get the checksum the target stores, verified on apply unless the target's checksum is wrong
+	for(const PatchBlock& b : blocks){
+		bool changed = memcmp(base.data() + b.offset, target.data() + b.offset, b.end - b.offset) != 0;
+		if(!changed){ continue; }
+		uint16_t stored = target[b.checksumPos] | (target[b.checksumPos + 1] << 8);
+		bool valid = crc16ccitt(target.subspan(b.offset, b.length)) == stored;
+		out.push_back(patchChecksumOp);
+		putPatchValue(out, b.offset, 4);
+		putPatchValue(out, b.length, 4);
+		putPatchValue(out, b.checksumPos, 4);
+		putPatchValue(out, stored, 2);
+		out.push_back(valid ? 1 : 0);
+		opCount++;
+	}
+
+	for(int i = 0; i < 4; i++){ out[countPos + i] = (opCount >> (8 * i)) & 0xff; }
+	return out;
+}
+
+// Version of the saves 'patch' was made for
+int getPatchVersion(span<const unsigned char> patch){
+	size_t magicLen = strlen(patchMagic);
+	if(patch.size() < magicLen + 9 || memcmp(patch.data(), patchMagic, magicLen) != 0){
+		throw SaveError(SaveErrorCode::invalidArgument, "not a save patch");
+	}
+	return patch[magicLen];
+}
+
+// Apply 'patch' to 'data', returns the number of ops applied
+size_t applySavePatch(SaveBuffer& data, span<const unsigned char> patch){
+	getPatchVersion(patch);
+	size_t pos = strlen(patchMagic) + 1;
+	if(getPatchValue(patch, pos, 4) != data.size()){ throw SaveError(SaveErrorCode::invalidSave, "patch is for a save of a different size"); }
+	uint32_t opCount = getPatchValue(patch, pos, 4);
+
+	// Record ops of the same record are consecutive, the record is decoded once and encoded when the next op is elsewhere
+	unsigned char record[pokemonPartyRecordSize], encrypted[pokemonPartyRecordSize];
+	size_t recordOffset = SIZE_MAX;
+	int recordType = patchBoxRecord;
+	auto flushRecord = [&](){
+		if(recordOffset == SIZE_MAX){ return; }
+		size_t size = (recordType == patchPartyRecord) ? pokemonPartyRecordSize : pokemonRecordSize;
+		encodePatchRecord(record, recordType, encrypted);
+		memcpy(data.writable(recordOffset, size), encrypted, size);
+		recordOffset = SIZE_MAX;
+	};
+
+	for(uint32_t op = 0; op < opCount; op++){
+		int kind = getPatchValue(patch, pos, 1);
+		if(kind == patchRecordOp){
+			size_t offset = getPatchValue(patch, pos, 4);
+			int type = getPatchValue(patch, pos, 1);
+			size_t at = getPatchValue(patch, pos, 2);
+			size_t length = getPatchValue(patch, pos, 2);
+			size_t size = (type == patchPartyRecord) ? pokemonPartyRecordSize : pokemonRecordSize;
+			if(type > patchPartyRecord || at + length > size || pos + length > patch.size()){
+				throw SaveError(SaveErrorCode::invalidArgument, "patch is corrupted");
+			}
+			if(offset != recordOffset){
+				flushRecord();
+				decodePatchRecord(data.view(offset, size).data(), type, record);
+				recordOffset = offset;
+				recordType = type;
+			}
+			memcpy(record + at, patch.data() + pos, length);
+			pos += length;
+			continue;
+		}
+
+		flushRecord();
+		if(kind == patchRawOp){
+			size_t offset = getPatchValue(patch, pos, 4);
+			size_t length = getPatchValue(patch, pos, 4);
+			if(pos + length > patch.size()){ throw SaveError(SaveErrorCode::invalidArgument, "patch is truncated"); }
+			memcpy(data.writable(offset, length), patch.data() + pos, length);
+			pos += length;
+		}
+		else if(kind == patchChecksumOp){
+			size_t offset = getPatchValue(patch, pos, 4);
+			size_t length = getPatchValue(patch, pos, 4);
+			size_t checksumPos = getPatchValue(patch, pos, 4);
+			uint16_t expected = getPatchValue(patch, pos, 2);
+			bool verify = getPatchValue(patch, pos, 1) & 1;
+
+			// The incremental checksum trusts the checksum the base stores, recompute the block before giving up
+			if(verify && calcBlockChecksum(data, offset, length, checksumPos) != expected
+			   && crc16ccitt(data.view(offset, length)) != expected){
+				throw SaveError(SaveErrorCode::invalidSave, "patch does not match this save");
+			}
+			data[checksumPos] = expected & 0xff;
+			data[checksumPos + 1] = expected >> 8;
+		}
+		else{
+			throw SaveError(SaveErrorCode::invalidArgument, "patch is corrupted");
+		}
+	}
+	flushRecord();
+	return opCount;
+}
+
+
+// - - - Integrity Check Functions - - - //
+
+/* Notes:
+	-> Blocks that were never written are all 0xff, their save counter reads as 0xffffffff
+	-> The newest small block is the one with the higher save counter, play time decides if the counters are equal
+	   (like getCurBlock, which only looks at the play time)
+	-> Records are checked in the order the game would find problems: bad egg flag, checksum, then the data itself
+*/
+
+#define badEggFlag 0x04
+#define maxLevel 100
+
+static BlockIntegrity checkBlock(const SaveBuffer& data, size_t blockOffset, size_t length, size_t checksumPos){
+	BlockIntegrity result;
+	result.storedChecksum = data[checksumPos] | (data[checksumPos + 1] << 8);
+	result.saveCounter = data[blockOffset + length] | (data[blockOffset + length + 1] << 8) | (data[blockOffset + length + 2] << 16) | ((uint32_t)data[blockOffset + length + 3] << 24);
+	if(result.saveCounter == 0xffffffff && result.storedChecksum == 0xffff){
+		result.status = blockUnused;
+		result.checksum = 0xffff;
+		return result;
+	}
+	result.checksum = crc16ccitt(data.view(blockOffset, length));
+	result.status = (result.checksum == result.storedChecksum) ? blockValid : blockCorrupt;
+	return result;
+}
+
+// Play time of the small block at 'small' in seconds
+template <typename Layout>
+static uint32_t getPlayTime(const SaveBuffer& data, size_t small){
+	size_t pos = Layout::playTime(small);
+	return (uint32_t)(data[pos] | (data[pos + 1] << 8)) * 60 * 60 + data[pos + 2] * 60 + data[pos + 3];
+}
+
+// Problem of the encrypted record at 'record', 'decoded' is the decoded copy, 0 if it is fine
+static int checkRecord(const unsigned char* record, const unsigned char* decoded){
+	if(record[4] & badEggFlag){ return recordBadEgg; }
+	if(calcPokemonChecksum(span<const unsigned char>(decoded + 8, pokemonRecordSize - 8)) != (decoded[6] | (decoded[7] << 8))){
+		return recordBadChecksum;
+	}
+	int species = decoded[pokemon[speciesID]] | (decoded[pokemon[speciesID] + 1] << 8);
+	if(species < 1 || species > getSpeciesCount()){ return recordBadData; }
+	return 0;
+}
+
+template <typename Layout>
+static SaveIntegrity checkLayoutIntegrity(const SaveBuffer& data){
+	if(data.size() < Layout::saveSize){
+		throw SaveError(SaveErrorCode::invalidSave, "file is too small to be a save file");
+	}
+
+	SaveIntegrity result = {};
+	for(int block = 1; block <= 2; block++){
+		size_t smallOffset = getSmallBlockOffset(block);
+		size_t bigOffset = Layout::bigBlock(smallOffset);
+		result.smallBlocks[block - 1] = checkBlock(data, smallOffset, Layout::smallLength, Layout::smallChecksum(smallOffset));
+		result.bigBlocks[block - 1] = checkBlock(data, bigOffset, Layout::bigLength, Layout::bigChecksum(bigOffset));
+	}
+
+	// Newest block by save counter, then play time, unused blocks never win
+	auto newer = [&](const BlockIntegrity* blocks, bool small){
+		if(blocks[0].status == blockUnused){ return 2; }
+		if(blocks[1].status == blockUnused){ return 1; }
+		if(blocks[0].saveCounter != blocks[1].saveCounter){ return blocks[0].saveCounter > blocks[1].saveCounter ? 1 : 2; }
+		if(small){ return getPlayTime<Layout>(data, smallBlock1) > getPlayTime<Layout>(data, smallBlock2) ? 1 : 2; }
+		return 0;
+	};
+	auto current = [&](const BlockIntegrity* blocks, int newest){
+		if(newest && blocks[newest - 1].status == blockValid){ return newest; }
+		if(blocks[0].status == blockValid){ return 1; }
+		if(blocks[1].status == blockValid){ return 2; }
+		return 0;
+	};
+	result.newestBlock = newer(result.smallBlocks, true);
+	result.currentBlock = current(result.smallBlocks, result.newestBlock);
+	int newestBig = newer(result.bigBlocks, false);
+	result.currentBigBlock = current(result.bigBlocks, newestBig ? newestBig : result.currentBlock);
+
+	unsigned char decoded[boxSlotCount * pokemonRecordSize];
+	for(int block = 1; block <= 2; block++){
+		size_t smallOffset = getSmallBlockOffset(block);
+		size_t bigOffset = Layout::bigBlock(smallOffset);
+
+		// Party, only the slots in use, the battle stats have to hold a possible level
+		if(result.smallBlocks[block - 1].status != blockUnused){
+			result.partyCount[block - 1] = data[Layout::partyCount(smallOffset)];
+			int count = min(result.partyCount[block - 1], partySize);
+			const unsigned char* party = data.view(Layout::partySlot(smallOffset, 0), partySize * pokemonPartyRecordSize).data();
+			decodePokemonBatch(party, count, decoded, pokemonPartyRecordSize);
+			for(int slot = 0; slot < count; slot++){
+				const unsigned char* record = party + slot * pokemonPartyRecordSize;
+				int problem = checkRecord(record, decoded + slot * pokemonRecordSize);
+				if(!problem){
+					unsigned char stats[8];
+					memcpy(stats, record + pokemonRecordSize, sizeof(stats));
+					prng(stats, record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24), sizeof(stats));
+					if(stats[4] < 1 || stats[4] > maxLevel){ problem = recordBadData; }
+				}
+				if(problem){ result.issues.push_back({block, -1, slot, problem}); }
+			}
+			result.records += count;
+		}
+
+		// Boxes, empty slots are all zero
+		if(result.bigBlocks[block - 1].status == blockUnused){ continue; }
+		for(int box = 0; box < boxCount; box++){
+			const unsigned char* records = data.view(Layout::boxSlot(bigOffset, box, 0), boxSlotCount * pokemonRecordSize).data();
+			decodePokemonBatch(records, boxSlotCount, decoded);
+			for(int slot = 0; slot < boxSlotCount; slot++){
+				const unsigned char* record = records + slot * pokemonRecordSize;
+				if(isEmptyRecord(record)){ continue; }
+				result.records++;
+				int problem = checkRecord(record, decoded + slot * pokemonRecordSize);
+				if(problem){ result.issues.push_back({block, box, slot, problem}); }
+			}
+		}
+	}
+	return result;
+}
+
+SaveIntegrity checkSaveIntegrity(const SaveBuffer& data, int version){
+	return withVersionLayout(version, [&](auto layout){ return checkLayoutIntegrity<decltype(layout)>(data); });
+}
+
+
+// - - - Version Detection Functions - - - //
+
+/* Notes:
+	-> A save almost never fits a wrong profile: the small block checksum alone matches by chance once in 65536 files
+	-> Real saves store the size of the small block (footer included) in its footer, generated saves leave the footer
+	   zero, so the footer adds to the score but isn't required
+	-> The cheap signals (footer, trainer, party) are probed first. The checksums are the expensive part, they are
+	   skipped for profiles that can't beat the best score so far (at most tie it, which takes two checksums matching by
+	   chance), and the big block is only checked
+	   after the small block of the same save slot matched
+*/
+
+#define smallChecksumWeight 40
+#define bigChecksumWeight 20
+#define footerWeight 15
+#define trainerWeight 10
+#define partyWeight 15
+#define maxPlayHours 999
+
+// Signals of a profile that only read a few bytes of the small block at 'blockOffset'
+template <typename Layout>
+static unsigned probeSmallBlock(const SaveBuffer& data, size_t blockOffset){
+	unsigned signals = 0;
+
+	// Footer: one of its fields is the block size
+	uint32_t blockLength = Layout::smallChecksum(0) + 2;
+	for(size_t pos = blockOffset + Layout::smallLength; pos + 4 <= Layout::smallChecksum(blockOffset); pos += 4){
+		if((data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | ((uint32_t)data[pos + 3] << 24)) == blockLength){
+			signals |= signalFooter;
+			break;
+		}
+	}
+
+	// Trainer: at least one character before the terminator, play time within what the game counts
+	const unsigned char* name = data.view(Layout::trainerName(blockOffset), trainerNameChars * 2).data();
+	uint16_t first = name[0] | (name[1] << 8);
+	bool terminated = false;
+	for(int i = 1; i < trainerNameChars && !terminated; i++){ terminated = (name[2*i] | (name[2*i + 1] << 8)) == gameTextTerminator; }
+	size_t time = Layout::playTime(blockOffset);
+	int hours = data[time] | (data[time + 1] << 8);
+	if(first != 0 && first != gameTextTerminator && terminated && hours <= maxPlayHours && data[time + 2] < 60 && data[time + 3] < 60){
+		signals |= signalTrainer;
+	}
+
+	// Party: a plausible count and a lead pokemon that passes its checksum
+	int count = data[Layout::partyCount(blockOffset)];
+	if(count >= 1 && count <= partySize){
+		unsigned char decoded[pokemonRecordSize];
+		const unsigned char* lead = data.view(Layout::partySlot(blockOffset, 0), pokemonPartyRecordSize).data();
+		decodePokemonBatch(lead, 1, decoded, pokemonPartyRecordSize);
+		int species = decoded[pokemon[speciesID]] | (decoded[pokemon[speciesID] + 1] << 8);
+		if(calcPokemonChecksum(span<const unsigned char>(decoded + 8, pokemonRecordSize - 8)) == (decoded[6] | (decoded[7] << 8))
+			&& species >= 1 && species <= getSpeciesCount()){
+			signals |= signalParty;
+		}
+	}
+	return signals;
+}
+
+static int signalScore(unsigned signals){
+	return ((signals & signalSmallChecksum) ? smallChecksumWeight : 0) + ((signals & signalBigChecksum) ? bigChecksumWeight : 0)
+		+ ((signals & signalFooter) ? footerWeight : 0) + ((signals & signalTrainer) ? trainerWeight : 0) + ((signals & signalParty) ? partyWeight : 0);
+}
+
+VersionDetection detectVersion(const SaveBuffer& data){
+	VersionDetection result;
+	VersionScore* scores = result.ranked;
+
+	// Cheap signals of every profile, the better of the two save slots counts
+	for(int version = 0; version < versionProfileCount; version++){
+		VersionScore& s = scores[version];
+		s = {version, 0, 0};
+		withVersionLayout(version, [&](auto layout){
+			using Layout = decltype(layout);
+			if(data.size() < Layout::saveSize){
+				s.score = -1;
+				return;
+			}
+			for(int block = 1; block <= 2; block++){
+				unsigned signals = probeSmallBlock<Layout>(data, getSmallBlockOffset(block));
+				if(signalScore(signals) > signalScore(s.signals)){ s.signals = signals; }
+			}
+			s.score = signalScore(s.signals);
+		});
+	}
+	sort(scores, scores + versionProfileCount, [](const VersionScore& a, const VersionScore& b){ return a.score > b.score; });
+
+	// Checksums, most promising profile first
+	int best = 0;
+	for(int i = 0; i < versionProfileCount; i++){
+		VersionScore& s = scores[i];
+		if(s.score < 0){
+			s.score = 0;
+			continue;
+		}
+		if(s.score + smallChecksumWeight + bigChecksumWeight <= best){ continue; }
+		withVersionLayout(s.version, [&](auto layout){
+			for(int block = 1; block <= 2; block++){
+				size_t smallOffset = getSmallBlockOffset(block);
+				size_t checksumPos = layout.smallChecksum(smallOffset);
+				if(crc16ccitt(data.view(smallOffset, layout.smallLength)) != (data[checksumPos] | (data[checksumPos + 1] << 8))){ continue; }
+				s.signals |= signalSmallChecksum;
+
+				size_t bigOffset = layout.bigBlock(smallOffset);
+				checksumPos = layout.bigChecksum(bigOffset);
+				if(crc16ccitt(data.view(bigOffset, layout.bigLength)) == (data[checksumPos] | (data[checksumPos + 1] << 8))){
+					s.signals |= signalBigChecksum;
+					break;
+				}
+			}
+		});
+		s.score = signalScore(s.signals);
+		best = max(best, s.score);
+	}
+	stable_sort(scores, scores + versionProfileCount, [](const VersionScore& a, const VersionScore& b){ return a.score > b.score; });
+
+	bool confident = scores[0].score >= detectMinScore && scores[0].score - scores[1].score >= detectMinMargin;
+	result.version = confident ? scores[0].version : -1;
+	return result;
+}
+
+
+// - - - Edit Journal Functions - - - //
+
+/* Notes:
+	-> Journal file: magic, save size (4), fingerprint of the save when the journal was started (8), records
+	-> Record: payload length (4), payload, CRC-16 of the payload (2); a record torn by a crash fails the CRC and is
+	   dropped together with everything after it
+	-> Payload: type (1), unix time (8), then
+		edit:   label length (2), label, run count (4), runs: offset (4), length (2), old bytes, new bytes
+		commit: fingerprint of the save after the commit (8)
+	-> The commit record is appended before the save is written. SaveBuffer::commit either completes or is rolled back
+	   when the save is opened again, so the save matches the last commit record or, after a crash, the one before it;
+	   the records after the matching commit are the edits that still have to be applied
+	-> A save that matches neither was changed by something else, its journal no longer applies
+*/
+
+#define journalMagic "PSEJRNL1"
+#define journalHeaderSize 20
+
+// Journal record types
+#define journalEdit 0
+#define journalUndo 1
+#define journalRedo 2
+#define journalCommit 3
+
+// Equal bytes shorter than this between two changes are stored in the same run
+#define journalMergeGap 8
+
+static void putJournalValue(vector<unsigned char>& out, uint64_t value, int bytes){
+	for(int i = 0; i < bytes; i++){ out.push_back((value >> (8 * i)) & 0xff); }
+}
+
+static uint64_t getJournalValue(span<const unsigned char> in, size_t& pos, int bytes){
+	if(pos + bytes > in.size()){ throw SaveError(SaveErrorCode::invalidSave, "edit journal is corrupt"); }
+	uint64_t value = 0;
+	for(int i = 0; i < bytes; i++){ value |= (uint64_t)in[pos + i] << (8 * i); }
+	pos += bytes;
+	return value;
+}
+
+// FNV-1a hash of the whole save, tells whether the journal belongs to it
+static uint64_t getFingerprint(span<const unsigned char> save){
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for(unsigned char c : save){ hash = (hash ^ c) * 0x100000001b3ull; }
+	return hash;
+}
+
+EditJournal::EditJournal(SaveBuffer& save, const string& path) : data(save), journalPath(path) {
+	load();
+}
+
+EditJournal::~EditJournal(){
+	if(fd >= 0){ ::close(fd); }
+}
+
+void EditJournal::load(){
+	vector<unsigned char> log;
+	ifstream in(journalPath, ios::binary);
+	if(in){ log.assign(istreambuf_iterator<char>(in), {}); }
+	in.close();
+
+	journaled.assign(data.data(), data.data() + data.size());
+	uint64_t saveFingerprint = getFingerprint(journaled);
+
+	bool found = log.size() >= journalHeaderSize;
+	bool usable = found && memcmp(log.data(), journalMagic, strlen(journalMagic)) == 0;
+	size_t pos = strlen(journalMagic);
+	usable = usable && getJournalValue(log, pos, 4) == data.size();
+	uint64_t committed = usable ? getJournalValue(log, pos, 8) : 0;
+
+	// Complete records and the last two commits, the header counts as the first commit
+	vector<span<const unsigned char>> records;
+	size_t lastCommit = 0, previousCommit = 0;
+	uint64_t previous = committed;
+	size_t end = journalHeaderSize;
+	while(usable && end + 4 <= log.size()){
+		size_t p = end;
+		size_t length = getJournalValue(log, p, 4);
+		if(length < 9 || p + length + 2 > log.size()){ break; }
+		span<const unsigned char> payload(log.data() + p, length);
+		if(crc16ccitt(payload) != (log[p + length] | (log[p + length + 1] << 8))){ break; }
+		records.push_back(payload);
+		if(payload[0] == journalCommit){
+			size_t q = 9;
+			previous = committed;
+			previousCommit = lastCommit;
+			committed = getJournalValue(payload, q, 8);
+			lastCommit = records.size();
+		}
+		end = p + length + 2;
+	}
+
+	// Records after the commit the save matches change the save
+	usable = usable && (saveFingerprint == committed || saveFingerprint == previous);
+	if(usable){
+		size_t first = (saveFingerprint == committed) ? lastCommit : previousCommit;
+		for(size_t i = 0; i < records.size(); i++){
+			applyRecord(records[i], i >= first ? journaled.data() : nullptr);
+		}
+	}
+
+	if(!usable){
+		// Edits made after the last commit never reached the save, they only live on in the .old journal
+		discarded = 0;
+		for(size_t i = lastCommit; i < records.size(); i++){
+			if(records[i][0] != journalCommit){ discarded++; }
+		}
+		if(found){ rename(journalPath.c_str(), (journalPath + ".old").c_str()); }
+		history.clear(); runs.clear(); runBytes.clear();
+		appliedCount = 0;
+		journaled.assign(data.data(), data.data() + data.size());
+
+		vector<unsigned char> header(journalMagic, journalMagic + strlen(journalMagic));
+		putJournalValue(header, data.size(), 4);
+		putJournalValue(header, saveFingerprint, 8);
+		fd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+		if(fd < 0 || ::write(fd, header.data(), header.size()) != (ssize_t)header.size() || fdatasync(fd) != 0){
+			throw SaveError(SaveErrorCode::fileError, "could not write edit journal");
+		}
+		syncDirectory(journalPath);
+		return;
+	}
+
+	fd = ::open(journalPath.c_str(), O_WRONLY | O_APPEND);
+	if(fd < 0 || (end < log.size() && ftruncate(fd, end) != 0)){
+		throw SaveError(SaveErrorCode::fileError, "could not write edit journal");
+	}
+
+	// Uncommitted edits go into the save like fresh ones, the next commit writes them
+	for(size_t i = 0; i < journaled.size(); ){
+		if(journaled[i] == data.data()[i]){ i++; continue; }
+		size_t j = i + 1;
+		while(j < journaled.size() && journaled[j] != data.data()[j]){ j++; }
+		memcpy(data.writable(i, j - i), journaled.data() + i, j - i);
+		i = j;
+	}
+}
+
+// Forget the edits that were undone, a new edit replaces them
+void EditJournal::dropUndone(){
+	if(appliedCount == history.size()){ return; }
+	const JournalEntry& first = history[appliedCount];
+	if(first.runCount){ runBytes.resize(runs[first.firstRun].bytes); }
+	runs.resize(first.firstRun);
+	history.resize(appliedCount);
+}
+
+// Update the history with one record, 'state' (if set) gets the bytes the record changes
+void EditJournal::applyRecord(span<const unsigned char> payload, unsigned char* state){
+	size_t pos = 0;
+	int type = getJournalValue(payload, pos, 1);
+	int64_t time = getJournalValue(payload, pos, 8);
+
+	if(type == journalEdit){
+		dropUndone();
+		JournalEntry entry = {"", time, runs.size(), 0, 0};
+		size_t labelLength = getJournalValue(payload, pos, 2);
+		if(pos + labelLength > payload.size()){ throw SaveError(SaveErrorCode::invalidSave, "edit journal is corrupt"); }
+		entry.label.assign((const char*)payload.data() + pos, labelLength);
+		pos += labelLength;
+
+		entry.runCount = getJournalValue(payload, pos, 4);
+		for(size_t i = 0; i < entry.runCount; i++){
+			Run run;
+			run.offset = getJournalValue(payload, pos, 4);
+			run.length = getJournalValue(payload, pos, 2);
+			run.bytes = runBytes.size();
+			if(pos + 2 * run.length > payload.size() || run.offset + run.length > data.size()){
+				throw SaveError(SaveErrorCode::invalidSave, "edit journal is corrupt");
+			}
+			runBytes.insert(runBytes.end(), payload.begin() + pos, payload.begin() + pos + 2 * run.length);
+			if(state){ memcpy(state + run.offset, payload.data() + pos + run.length, run.length); }
+			pos += 2 * run.length;
+			entry.changedBytes += run.length;
+			runs.push_back(run);
+		}
+		history.push_back(move(entry));
+		appliedCount++;
+		return;
+	}
+
+	bool undoing = type == journalUndo;
+	if(type == journalCommit){ return; }
+	if(type != journalRedo && !undoing){ throw SaveError(SaveErrorCode::invalidSave, "edit journal is corrupt"); }
+	if(undoing ? appliedCount == 0 : appliedCount == history.size()){ throw SaveError(SaveErrorCode::invalidSave, "edit journal is corrupt"); }
+
+	const JournalEntry& entry = history[undoing ? appliedCount - 1 : appliedCount];
+	appliedCount += undoing ? -1 : 1;
+	if(!state){ return; }
+	for(size_t i = entry.firstRun; i < entry.firstRun + entry.runCount; i++){
+		memcpy(state + runs[i].offset, &runBytes[runs[i].bytes + (undoing ? 0 : runs[i].length)], runs[i].length);
+	}
+}
+
+// Write the old (undo) or new (redo) bytes of 'entry' to the save
+void EditJournal::applyEntry(const JournalEntry& entry, bool redoing){
+	for(size_t i = entry.firstRun; i < entry.firstRun + entry.runCount; i++){
+		const Run& run = runs[i];
+		const unsigned char* src = &runBytes[run.bytes + (redoing ? run.length : 0)];
+		memcpy(data.writable(run.offset, run.length), src, run.length);
+		memcpy(&journaled[run.offset], src, run.length);
+	}
+}
+
+// Length prefix, payload and its checksum in one write, synced so an edit survives a crash
+void EditJournal::append(const vector<unsigned char>& payload){
+	vector<unsigned char> record;
+	record.reserve(payload.size() + 6);
+	putJournalValue(record, payload.size(), 4);
+	record.insert(record.end(), payload.begin(), payload.end());
+	putJournalValue(record, crc16ccitt(payload), 2);
+
+	size_t done = 0;
+	while(done < record.size()){
+		ssize_t n = ::write(fd, record.data() + done, record.size() - done);
+		if(n < 0 && errno == EINTR){ continue; }
+		if(n <= 0){ throw SaveError(SaveErrorCode::fileError, "could not write edit journal"); }
+		done += n;
+	}
+	if(fdatasync(fd) != 0){ throw SaveError(SaveErrorCode::fileError, "could not write edit journal"); }
+}
+
+bool EditJournal::record(string_view label){
+
+	// Changed bytes can only be in the dirty ranges, runs never cross a range
+	vector<pair<size_t, size_t>> changed;
+	const unsigned char* now = data.data();
+	for(const DirtyRange& r : data.dirtyRanges()){
+		size_t rangeEnd = r.offset + r.length;
+		for(size_t i = r.offset; i < rangeEnd; ){
+			if(now[i] == journaled[i]){ i++; continue; }
+			size_t last = i + 1;
+			for(size_t j = i + 1; j < rangeEnd && j - i < 0xffff && j - last < journalMergeGap; j++){
+				if(now[j] != journaled[j]){ last = j + 1; }
+			}
+			changed.push_back({i, last - i});
+			i = last;
+		}
+	}
+	if(changed.empty()){ return false; }
+
+	label = label.substr(0, 0xffff);
+	int64_t now64 = ::time(nullptr);
+	vector<unsigned char> payload;
+	putJournalValue(payload, journalEdit, 1);
+	putJournalValue(payload, now64, 8);
+	putJournalValue(payload, label.size(), 2);
+	payload.insert(payload.end(), label.begin(), label.end());
+	putJournalValue(payload, changed.size(), 4);
+	for(auto& c : changed){
+		putJournalValue(payload, c.first, 4);
+		putJournalValue(payload, c.second, 2);
+		payload.insert(payload.end(), journaled.begin() + c.first, journaled.begin() + c.first + c.second);
+		payload.insert(payload.end(), now + c.first, now + c.first + c.second);
+	}
+	append(payload);
+
+	applyRecord(payload, journaled.data());
+	return true;
+}
+
+bool EditJournal::undo(){
+	if(appliedCount == 0){ return false; }
+	vector<unsigned char> payload;
+	putJournalValue(payload, journalUndo, 1);
+	putJournalValue(payload, ::time(nullptr), 8);
+	append(payload);
+	applyEntry(history[--appliedCount], false);
+	return true;
+}
+
+bool EditJournal::redo(){
+	if(appliedCount == history.size()){ return false; }
+	vector<unsigned char> payload;
+	putJournalValue(payload, journalRedo, 1);
+	putJournalValue(payload, ::time(nullptr), 8);
+	append(payload);
+	applyEntry(history[appliedCount++], true);
+	return true;
+}
+
+size_t EditJournal::commit(){
+	if(!data.isDirty()){ return 0; }
+	vector<unsigned char> payload;
+	putJournalValue(payload, journalCommit, 1);
+	putJournalValue(payload, ::time(nullptr), 8);
+	putJournalValue(payload, getFingerprint(journaled), 8);
+	append(payload);
+	return data.commit();
+}
+
+
+// - - - Synthetic Save Generator - - - //
+
+/* Notes:
+	-> Builds a save image for any version without a real game: both save slots with trainer data, a full party and
+	   PC boxes, all pokemon encrypted and every block checksum valid
+	-> The same version and seed always give the same image (the generator is the pokemon LCG), so benchmarks and tests
+	   can run offline
+	-> Save slot 1 is the newer one (more play time, higher big block save counter)
+*/
+
+// Fill 'record' (decoded, 136 bytes) with a random pokemon owned by 'tid'/'sid'
+void generatePokemon(SaveGeneratorRandom& rng, unsigned char* record, uint16_t tid, uint16_t sid){
+	memset(record, 0, pokemonRecordSize);
+	bool modified = false;
+	PokemonRecord mon(record, &modified);
+
+	mon.setPersonalityValue(rng.next());
+	int species = 1 + rng.below(speciesKeys.size());
+	mon.setSpecies(species);
+	mon.setOtId(tid);
+	mon.setOtSecretId(sid);
+	mon.setAbility(1 + rng.below(abilityKeys.size()));
+	for(int slot = 1; slot <= 4; slot++){
+		int move = 1 + rng.below(moveKeys.size());
+		mon.setMove(slot, move);
+		mon.setPP(slot, getMovePP(move));
+	}
+	mon.setIVs(rng.next() & 0x3fffffff);
+
+	string name(getSpeciesName(species));
+	for(char& c : name){ c = toupper(c); }
+	mon.setNickname(name.substr(0, nicknameChars));
+}
+
+template <typename Layout>
+static vector<unsigned char> generateLayoutSave(uint32_t seed, int boxFillPercent){
+	vector<unsigned char> save(generatedSaveSize, 0xff);
+	SaveGeneratorRandom rng = {seed};
+	uint16_t tid = rng.next(), sid = rng.next();
+	unsigned char decoded[pokemonRecordSize];
+
+	for(int block = 1; block <= 2; block++){
+		size_t smallOffset = getSmallBlockOffset(block);
+		unsigned char* image = save.data();
+		memset(image + smallOffset, 0, Layout::smallChecksum(0) + 2);
+
+		unsigned char name[trainerNameChars * 2];
+		encodeGameText("BENCH", name, trainerNameChars);
+		memcpy(image + Layout::trainerName(smallOffset), name, sizeof(name));
+		unsigned char* id = image + Layout::trainerIdPos(smallOffset);
+		id[0] = tid & 0xff; id[1] = tid >> 8;
+		id = image + Layout::secretIdPos(smallOffset);
+		id[0] = sid & 0xff; id[1] = sid >> 8;
+
+		// Play time: hours (16 bits), minutes, seconds
+		unsigned char* time = image + Layout::playTime(smallOffset);
+		time[0] = (block == 1) ? 12 : 11; time[1] = 0;
+		time[2] = 30; time[3] = 15;
+
+		image[Layout::partyCount(smallOffset)] = partySize;
+		for(int slot = 0; slot < partySize; slot++){
+			unsigned char* record = image + Layout::partySlot(smallOffset, slot);
+			generatePokemon(rng, decoded, tid, sid);
+			encodePokemon(decoded, record);
+
+			// Battle stats: level 50, the rest stays zero
+			unsigned char* stats = record + pokemonRecordSize;
+			memset(stats, 0, pokemonBattleStatsSize);
+			stats[4] = 50;
+			prng(stats, record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24), pokemonBattleStatsSize);
+		}
+		int smallCrc = crc16ccitt(span<const unsigned char>(image + smallOffset, Layout::smallLength));
+		image[Layout::smallChecksum(smallOffset)] = smallCrc & 0xff;
+		image[Layout::smallChecksum(smallOffset) + 1] = smallCrc >> 8;
+
+		size_t bigOffset = Layout::bigBlock(smallOffset);
+		memset(image + bigOffset, 0, Layout::bigChecksum(0) + 2);
+		for(int box = 0; box < boxCount; box++){
+			for(int slot = 0; slot < boxSlotCount; slot++){
+				if((int)rng.below(100) >= boxFillPercent){ continue; }
+				generatePokemon(rng, decoded, tid, sid);
+				encodePokemon(decoded, image + Layout::boxSlot(bigOffset, box, slot));
+			}
+		}
+		uint32_t counter = (block == 1) ? 2 : 1;
+		for(int i = 0; i < 4; i++){ image[Layout::bigCounter(bigOffset) + i] = counter >> (8 * i); }
+		int bigCrc = crc16ccitt(span<const unsigned char>(image + bigOffset, Layout::bigLength));
+		image[Layout::bigChecksum(bigOffset)] = bigCrc & 0xff;
+		image[Layout::bigChecksum(bigOffset) + 1] = bigCrc >> 8;
+	}
+	return save;
+}
+
+// Generate a complete save image for 'version'
+vector<unsigned char> generateSave(int version, uint32_t seed, int boxFillPercent){
+	return withVersionLayout(version, [&](auto layout){ return generateLayoutSave<decltype(layout)>(seed, boxFillPercent); });
+}
+
+
@@ -2,736 +2,2245 @@
 	Notes:
 		 -> (!) Program assumes file in argv[1] is a valid save file for 4th gen NDS pokemon games
 		 -> Program has only been tested on the desmume emulator on linux
+		 -> Command line front end, the save handling itself is in libsaveditor (saveditor.h)
 */
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
 #include <climits>
-#include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <map>
-#include <string>
-#include <vector>
-
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include <errno.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "saveditor.h"
+#include "saveditor_internal.h"
 
 using namespace std;
 
-// - - - Lables for ease of use - - - //
-
-// General Offset Lables
-#define trainerNameOffset 0
-#define trainerId 1
-#define secretId 2
-#define smallBlockChecksumOffset 3
-#define checksumValueOffset 4
-#define leadPokemonOffset 5
-#define totalTime 6
-
-// Version Lables for General Offsets
-#define diamond 0
-#define pearl 0
-#define platinum 1
-#define heartgold 2
-#define soulsilver 2
-
-// Pokemon Data Structure Offset Lables
-#define personalityValueOffset 0
-#define skipPokemonChecksumOffset 1
-#define pokemonChecksumOffset 2
-#define speciesID 3
-#define heldItem 4
-#define otid 5
-#define otSecretID 6
-#define ability 7
-#define moveset 8
-#define movePP 9
-#define movePPup 10
-#define IVs 11
-#define nickname 12
-
-// --- Block Addresses --- //
+// - - - Stats Report Functions - - - //
 
 /* Notes:
-	-> Small block contains trainer data (name, id, money etc) and party pokemon data (species, ability, EVs, etc)
-	-> Big blocks contain data of pokemon stored in the PC boxes (untested)
+	-> '--stats path' (batch mode and '--check') attaches a SaveStats to every file while it is processed and writes
+	   one row per file and the total to 'path' when the run is done, as CSV if the name ends in '.csv' and JSON otherwise
+	-> Allocations are counted by replacing the global operator new, only while stats are attached to the thread
 */
-int smallBlock1 = 0x00000;
-int bigBlock1 = 0xcf2c;
-int smallBlock2 = 0x40000;
-int bigBlock2 = 0x4cf2c;
-
-
-// --- Small Block Offset for each version --- //
-
-// Offsets for Diamond and Pearl versions
-int dp[] = {
-	0x64, // trainerNameOffset
-	0x74, // trainerID
-	0x76, // secretID
-	0xc0ec, // smallBlockChecksumOffset
-	0xc0fe, // checksumValueOffset
-	0x98, // leadPokemonOffset
-	0x86 // totalTime - hours: 16bits; minutes: 8bits; seconds: 8bits
-};
 
-// Offsets for Platinum versions
-int p[] = {
-	0x68, // trainerNameOffset
-	0x78, // trainerID
-	0x7a, // secretID
-	0xcf18, // smallBlockChecksumOffset
-	0xcf2a, // checksumValueOffset
-	0xa0, // leadPokemonOffset
-	0x8a // totalTime - hours: 16bits; minutes: 8bits; seconds: 8bits
-};
+#ifndef SAVEDITOR_NO_STATS
+void* operator new(size_t size){
+	if(activeStats){
+		activeStats->allocations++;
+		activeStats->allocatedBytes += size;
+	}
+	void* p = malloc(size ? size : 1);
+	if(!p){ throw bad_alloc(); }
+	return p;
+}
 
-// Offsets for Heartgold and Soulsilver versions
-int hgss[] = {
-	0x64, // trainerNameOffset
-	0x74, // trainerID
-	0x76, // secretID
-	0xf618, // smallBlockChecksumOffset
-	0xf626, // checksumValueOffset
-	0x98, // leadPokemonOffset
-	0x86 // totalTime - hours: 16bits; minutes: 8bits; seconds: 8bits
-};
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+#endif
+
+// Run 'job' with 'stats' (if set) attached to the calling thread and add its wall time
+template <typename F>
+void runWithStats(SaveStats* stats, F&& job){
+	if(!stats){
+		job();
+		return;
+	}
+	StatsScope scope(*stats);
+	auto start = chrono::steady_clock::now();
+	job();
+	stats->nanoseconds += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+string jsonString(const string& s){
+	string out = "\"";
+	for(char c : s){
+		if(c == '"' || c == '\\'){ out += '\\'; out += c; }
+		else if((unsigned char)c < 0x20){
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out += escaped;
+		}
+		else{ out += c; }
+	}
+	return out + "\"";
+}
 
-// - - - Mapping version names to respective offsets - - - //
-int* versionNames[] = { {dp}, {p}, {hgss} };
+string csvString(const string& s){
+	if(s.find_first_of(",\"\n") == string::npos){ return s; }
+	string out = "\"";
+	for(char c : s){
+		if(c == '"'){ out += '"'; }
+		out += c;
+	}
+	return out + "\"";
+}
 
+void writeStatsJson(ostream& out, const SaveStats& stats){
+	out << "\"total_ns\": " << stats.nanoseconds << ", \"allocations\": " << stats.allocations << ", \"allocated_bytes\": " << stats.allocatedBytes << ", \"phases\": {";
+	for(int i = 0; i < statPhaseCount; i++){
+		const PhaseStats& p = stats.phases[i];
+		out << (i ? ", " : "") << "\"" << statPhaseNames[i] << "\": {\"calls\": " << p.calls << ", \"ns\": " << p.nanoseconds << ", \"bytes\": " << p.bytes << "}";
+	}
+	out << "}";
+}
 
-// - - - Offsets for the Pokemon data structure - - - //
-int pokemon[] = {
+void writeStatsCsv(ostream& out, const string& name, const SaveStats& stats){
+	out << csvString(name) << "," << stats.nanoseconds << "," << stats.allocations << "," << stats.allocatedBytes;
+	for(const PhaseStats& p : stats.phases){ out << "," << p.calls << "," << p.nanoseconds << "," << p.bytes; }
+	out << "\n";
+}
 
-	// Unencrypted Pokemon block offsets
-	0x00, // personalityValueOffset
-	0x04, // skipPokemonChecksumOffset ( "Bit 0-1: If set, skip checksum checks" ( <- this does not seem to work); "Bit 2: Bad egg flag"; )
-	0x06, // pokemonChecksumOffset
+// Write the stats of every file and their total to 'path'
+void writeStatsReport(const string& path, const vector<string>& files, const vector<SaveStats>& stats){
+	SaveStats total;
+	for(const SaveStats& s : stats){ total.add(s); }
+
+	ofstream out(path);
+	if(path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0){
+		out << "path,total_ns,allocations,allocated_bytes";
+		for(string_view name : statPhaseNames){ out << "," << name << "_calls," << name << "_ns," << name << "_bytes"; }
+		out << "\n";
+		for(size_t i = 0; i < files.size(); i++){ writeStatsCsv(out, files[i], stats[i]); }
+		writeStatsCsv(out, "total", total);
+	}
+	else{
+		out << "{\n  \"stats_enabled\": " << (StatsPolicy::enabled ? "true" : "false") << ",\n  \"files\": [\n";
+		for(size_t i = 0; i < files.size(); i++){
+			out << "    {\"path\": " << jsonString(files[i]) << ", ";
+			writeStatsJson(out, stats[i]);
+			out << "}" << (i + 1 < files.size() ? "," : "") << "\n";
+		}
+		out << "  ],\n  \"total\": {";
+		writeStatsJson(out, total);
+		out << "}\n}\n";
+	}
+	if(!out){ throw SaveError(SaveErrorCode::fileError, "could not write stats report '" + path + "'"); }
+}
 
-	// Encrypted Pokemon block offsets
 
-	// Block A
-	0x08, // speciesID
-	0x0a, // heldItem
-	0x0c, // otid
-	0x0e, // otSecretID
-	0x15, // ability
+// - - - Batch Mode Functions - - - //
 
-	// Block B (untested)
-	0x08, // moveset (8 bytes)
-	0x10, // Move PP (4 bytes)
-	0x14, // Move PP ups (4 bytes)
-	0x18, // IVs (4 bytes)
+/* Notes:
+	-> Batch mode applies the same edit script to every save file given on the command line
+	-> Directories are searched recursively for '.sav' and '.dsv' files
+	-> Edit script format (one edit per line, lines starting with '#' are ignored):
+		name <NewName>
+		species <PokemonName>
+		ability <AbilityName>
+		move <Slot 1-4> <MoveName>
+		shiny
+		maxpp
+	-> Pokemon edits apply to the lead pokemon, prefixed with 'party' they apply to every pokemon in the party
+	   (for example 'party shiny' or 'party move 1 Surf')
+*/
 
-	// Block C
-	0x08 // nickname (0x08 - 0x1d)
+// Single edit from an edit script, 'option' uses the same numbering as editPokemon (0 edits the player name)
+struct EditOp {
+	int option;
+	string value;
+	int moveSlot;
+	bool wholeParty;
 };
 
+// Outcome of processing a single save file in batch mode
+struct BatchResult {
+	string path;
+	bool ok;
+	string message;
+	unsigned long long bytes;
+	unsigned long long written;
+};
 
-// - - - Handle data from savefile - - - //
-
-// Reading save file data into char vector
-void readFile(const char* filename, vector<unsigned char>& data){
-	ifstream savefile(filename, ios::binary );
-	if(savefile){
-		data.assign(istreambuf_iterator<char>(savefile), {});
-		savefile.close();
-		return;
-	}
-	savefile.close();
-	cout << "Error: could not read file" << endl;
-	exit(EXIT_FAILURE);
+// Remove leading and trailing whitespace
+string trim(const string& s){
+	size_t start = s.find_first_not_of(" \t\r\n");
+	if(start == string::npos){ return ""; }
+	size_t end = s.find_last_not_of(" \t\r\n");
+	return s.substr(start, end - start + 1);
 }
 
-// Partition data from save file and return partition as char vector
-vector<unsigned char> getSubVector(vector<unsigned char>& original, int lowerBound, int upperBound){
-	auto start = original.begin() + lowerBound;
-	auto end = original.begin() + upperBound + 1;
-	vector<unsigned char> subVector(upperBound - lowerBound + 1);
-	copy(start, end, subVector.begin());
-	return subVector;
+// Convert a version name from the command line into a version index, returns -1 if the name is unknown
+int parseVersion(const string& v){
+	if(v.compare("diamond") == 0){ return diamond; }
+	else if(v.compare("pearl") == 0){ return pearl; }
+	else if(v.compare("platinum") == 0){ return platinum; }
+	else if(v.compare("heartgold") == 0){ return heartgold; }
+	else if(v.compare("soulsilver") == 0){ return soulsilver; }
+	return -1;
 }
 
-// Write data to savefile from char vector
-void writeFile(const char* filename, vector<unsigned char> data){
-	ofstream savefile(filename, ios::out | ios::binary );
-	if(savefile){
-		savefile.write((char*)&data[0], data.size() * sizeof(unsigned char));
-		savefile.close();
-		return;
-	}
-	savefile.close();
-	cout << "Error: could not write to file" << endl;
-	exit(EXIT_FAILURE);
-
-}
-
-// - - - Small Block Functions - - - //
-
-// Calculate savefile checksum for given small block data
-int crc16ccitt(vector<unsigned char> dataChunk){
-
-	int table[256] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
-			0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
-			0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
-			0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
-			0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
-			0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
-			0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
-			0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
-			0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
-			0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
-			0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
-			0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
-			0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
-			0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
-			0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
-			0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
-			0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
-			0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
-			0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
-			0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
-			0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
-			0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
-			0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
-			0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
-			0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
-			0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
-			0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
-			0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
-			0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
-			0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
-			0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
-			0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0};
-
-	int sum = 0xffff;
-	for(unsigned long i = 0; i < (dataChunk.size()-1); i++){
-		sum = ( (sum & 0xffff) << 8) ^ table[ ( dataChunk[i] ^ ( (sum >> 8) & 0xff) ) & 0xff  ];
-	}
-
-	return (sum & 0xffff);
-}
-
-// Update checksum bytes with 'newValue'
-void updateChecksum(vector<unsigned char>& data, int newValue, int block, int version){
-	if(block == 1){
-		int curBlockOffset = smallBlock1;
-		data[curBlockOffset + versionNames[version][checksumValueOffset] ] = newValue & 0xff;
-		data[curBlockOffset + versionNames[version][checksumValueOffset] + 1] = newValue >> 8;
-	}
-	else if(block == 2){
-		int curBlockOffset = smallBlock2;
-		data[curBlockOffset + versionNames[version][checksumValueOffset] ] = newValue & 0xff;
-		data[curBlockOffset + versionNames[version][checksumValueOffset] + 1] = newValue >> 8;
+// 'auto' as the version name, the version of every save is detected when it is opened
+#define autoVersion -2
 
-	}
-	else{
-		cout << "Error: could not update Savefile Checksum" << endl;
-		exit(EXIT_FAILURE);
-	}
+// Like parseVersion, but also accepts 'auto' (for the modes that resolve the version per save)
+int parseVersionOrAuto(const string& v){
+	return (v == "auto") ? autoVersion : parseVersion(v);
 }
 
-// Find out in which block the last save was stored
-int getCurBlock(vector<unsigned char> data, int version){
-
-	int block1 = data[smallBlock1 + versionNames[version][totalTime]+1];
-	int block2 = data[smallBlock2 + versionNames[version][totalTime]+1];
+const char* versionProfileNames[] = { "diamond", "platinum", "heartgold" };
 
-	if(block1 == 0xff){
-		cout << "Error: save the game at least twice before editing" << endl;
-		exit(EXIT_FAILURE);
+// Version to edit 'data' with: 'version', or the detected one if it is autoVersion
+int resolveVersion(const SaveBuffer& data, int version){
+	if(version != autoVersion){ return version; }
+	VersionDetection detection = detectVersion(data);
+	if(detection.version < 0){
+		const VersionScore& best = detection.ranked[0];
+		throw SaveError(SaveErrorCode::invalidSave, "could not detect the version (best guess " + string(versionProfileNames[best.version]) + " with score " + to_string(best.score) + ")");
 	}
-
-	block1 = block1 << 8; block1 += data[smallBlock1 + versionNames[version][totalTime]];
-	block1 *= 60*60;
-	block1 += data[smallBlock1 + versionNames[version][totalTime]+3];
-	block1 += data[smallBlock1 + versionNames[version][totalTime]+2]*60;
-	block2 = block2 << 8; block2 += data[smallBlock2 + versionNames[version][totalTime]];
-	block2 *= 60*60;
-	block2 += data[smallBlock2 + versionNames[version][totalTime]+3];
-	block2 += data[smallBlock2 + versionNames[version][totalTime]+2]*60;
-	if(block1 > block2){ return 1; }
-	else if(block1 < block2){ return 2; }
-	else{ return 2;}
+	return detection.version;
 }
 
-// - - - Handle Pokemon Data Functions - - - //
-
-// Get the Pokemon's 'Personality Value'
-int getPersonalityValue(vector<unsigned char> data, int block, int version){
-	if(block == 1){
-		int leadPokemon = smallBlock1 + versionNames[version][leadPokemonOffset];
-		return (data[leadPokemon+3] << 24) + (data[leadPokemon+2] << 16) + (data[leadPokemon+1] << 8) + data[leadPokemon];
+// Parse one line of an edit script, returns false for blank lines and comments
+bool parseEditLine(const string& rawLine, EditOp& op){
+	string line = trim(rawLine);
+	if(line.empty() || line[0] == '#'){ return false; }
+
+	size_t split = line.find_first_of(" \t");
+	string command = line.substr(0, split);
+	string arg = (split == string::npos) ? "" : trim(line.substr(split));
+
+	bool wholeParty = false;
+	if(command == "party"){
+		wholeParty = true;
+		split = arg.find_first_of(" \t");
+		command = arg.substr(0, split);
+		arg = (split == string::npos) ? "" : trim(arg.substr(split));
 	}
-	else if(block == 2){
-		int leadPokemon = smallBlock2 + versionNames[version][leadPokemonOffset];
-		return (data[leadPokemon+3] << 24) + (data[leadPokemon+2] << 16) + (data[leadPokemon+1] << 8) + data[leadPokemon]; 
+
+	op = {-1, arg, 0, wholeParty};
+	if(command == "name" && !wholeParty){ op.option = 0; }
+	else if(command == "species"){ op.option = 1; }
+	else if(command == "ability"){ op.option = 2; }
+	else if(command == "move"){
+		op.option = 3;
+		size_t slotEnd = arg.find_first_of(" \t");
+		string slot = arg.substr(0, slotEnd);
+		if(slot.size() != 1 || slot[0] < '1' || slot[0] > '4' || slotEnd == string::npos){
+			throw SaveError(SaveErrorCode::invalidArgument, "move needs a slot [1-4] and a move name: '" + line + "'");
+		}
+		op.moveSlot = slot[0] - '0';
+		op.value = trim(arg.substr(slotEnd));
 	}
+	else if(command == "shiny"){ op.option = 4; }
+	else if(command == "maxpp"){ op.option = 5; }
 	else{
-		cout << "Error: could not get Pokemon Personality Value" << endl;
-		exit(EXIT_FAILURE);
+		throw SaveError(SaveErrorCode::invalidArgument, "unknown edit '" + (wholeParty ? "party " + command : command) + "'");
 	}
-}
-
-// - - - Character Encoding/Decoding Functions - - - //
 
-int toGameEncoding(char c){
-
-	// Try to return encoding if c is alpha numeric
-	if( (c >= 48 && c <= 57) || (c >= 65  && c <= 90) ||  (c >= 97  && c <= 122) ){
-		map<char, int> encoding = { {'0', 33,}, {'1', 34,},{'2', 35,},{'3', 36,},{'4', 37,},{'5', 38,},{'6', 39,},{'7', 40,},{'8', 41,},{'9', 42,},{'A', 43,},{'B', 44,},{'C', 45,},{'D', 46,},{'E', 47,},{'F', 48,},{'G', 49,},{'H', 50,},{'I', 51,},{'J', 52,},{'K', 53,},{'L', 54,},{'M', 55,},{'N', 56,},{'O', 57,},{'P', 58,},{'Q', 59,},{'R', 60,},{'S', 61,},{'T', 62,},{'U', 63,},{'V', 64,},{'W', 65,},{'X', 66,},{'Y', 67,},{'Z', 68,},{'a', 69,},{'b', 70,},{'c', 71,},{'d', 72,},{'e', 73,},{'f', 74,},{'g', 75,},{'h', 76,},{'i', 77,},{'j', 78,},{'k', 79,},{'l', 80,},{'m', 81,},{'n', 82,},{'o', 83,},{'p', 84,},{'q', 85,},{'r', 86,},{'s', 87,},{'t', 88,},{'u', 89,},{'v', 90,},{'w', 91,},{'x', 92,},{'y', 93,},{'z', 94,} };
-		return encoding[c];
-	}
-	else{
-		// Exits if c is not a valid character
-		cout << "Error: invalid characters detected" << endl;
-		exit(EXIT_FAILURE);
+	if(op.value.empty() && op.option != 4 && op.option != 5){
+		throw SaveError(SaveErrorCode::invalidArgument, "missing value for edit '" + command + "'");
 	}
+	return true;
 }
 
-char fromGameEncoding(int n){
+// Read an edit script from 'filename'
+vector<EditOp> parseEditScript(const char* filename){
+	ifstream script(filename);
+	if(!script){
+		throw SaveError(SaveErrorCode::fileError, string("could not read edit script '") + filename + "'");
+	}
 
-	// Try to return encoding if n is withing the game encoding range
-	if(n >= 33 && n <= 94){
-		map<int, char> encoding = { {33, '0',}, {34, '1',}, {35, '2',}, {36, '3',}, {37, '4',}, {38, '5',}, {39, '6',}, {40, '7',}, {41, '8',}, {42, '9',}, {43, 'A',}, {44, 'B',}, {45, 'C',}, {46, 'D',}, {47, 'E',}, {48, 'F',}, {49, 'G',}, {50, 'H',}, {51, 'I',}, {52, 'J',}, {53, 'K',}, {54, 'L',}, {55, 'M',}, {56, 'N',}, {57, 'O',}, {58, 'P',}, {59, 'Q',}, {60, 'R',}, {61, 'S',}, {62, 'T',}, {63, 'U',}, {64, 'V',}, {65, 'W',}, {66, 'X',}, {67, 'Y',}, {68, 'Z',}, {69, 'a',}, {70, 'b',}, {71, 'c',}, {72, 'd',}, {73, 'e',}, {74, 'f',}, {75, 'g',}, {76, 'h',}, {77, 'i',}, {78, 'j',}, {79, 'k',}, {80, 'l',}, {81, 'm',}, {82, 'n',}, {83, 'o',}, {84, 'p',}, {85, 'q',}, {86, 'r',}, {87, 's',}, {88, 't',}, {89, 'u',}, {90, 'v',}, {91, 'w',}, {92, 'x',}, {93, 'y',}, {94, 'z',} };
-		return encoding[n];
+	vector<EditOp> ops;
+	string line;
+	int lineNumber = 0;
+	while(getline(script, line)){
+		lineNumber++;
+		EditOp op;
+		try{
+			if(parseEditLine(line, op)){ ops.push_back(op); }
+		}
+		catch(const SaveError& e){
+			throw SaveError(e.code(), "edit script line " + to_string(lineNumber) + ": " + e.what());
+		}
 	}
-	else{
-		// Exits if n is not a valid character
-		cout << "Error: invalid characters detected" << endl;
-		exit(EXIT_FAILURE);
+	if(ops.empty()){
+		throw SaveError(SaveErrorCode::invalidArgument, "edit script contains no edits");
 	}
+	return ops;
 }
 
+// Apply every edit in 'ops' to the save data
+// All pokemon edits share one decrypt/encrypt cycle of the party and the small block checksum is updated once at the end
+void applyEdits(SaveBuffer& data, Party& party, const vector<EditOp>& ops, int block, int version){
+	for(const EditOp& op : ops){
+		if(op.option == 0){
+			setPlayerName(data, op.value, block, version);
+		}
+		else if(op.wholeParty){
+			editParty(party, op.value, op.value, op.value, op.moveSlot, op.option);
+		}
+		else{
+			PokemonRecord lead = party.at(0);
+			editPokemon(lead, op.value, op.value, op.value, op.moveSlot, op.option);
+		}
+	}
 
-// - - - Handle Pokemon Encryption Functions - - - //
-
-// Pokemon data is divided into 4 shuffled blocks of data, this function returns a vector of offsets to each block such that:
-	// -> the offset to block A is at index 0
-	// -> the offset to block B is at index 1
-	// -> the offset to block C is at index 2
-	// -> the offset to block D is at index 3
+	party.commit();
+	updateSmallBlockChecksum(data, block, version);
+}
 
-vector<int> getBlockOffsets(int pv){
+void applyEdits(SaveBuffer& data, const vector<EditOp>& ops, int version){
+	int block = getCurBlock(data, version);
+	Party party(data, block, version);
+	applyEdits(data, party, ops, block, version);
+}
 
-	// Note: pv stands for Personality Value
+// Expand the paths given on the command line into a sorted list of files, directories are searched for 'extensions'
+vector<string> collectFiles(const vector<string>& paths, initializer_list<string_view> extensions){
+	vector<string> files;
+	for(const string& path : paths){
+		error_code ec;
+		if(filesystem::is_directory(path, ec)){
+			for(auto it = filesystem::recursive_directory_iterator(path, ec); !ec && it != filesystem::recursive_directory_iterator(); it.increment(ec)){
+				if(!it->is_regular_file(ec)){ continue; }
+				string ext = it->path().extension().string();
+				transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+				if(find(extensions.begin(), extensions.end(), ext) != extensions.end()){ files.push_back(it->path().string()); }
+			}
+		}
+		else{
+			// Explicitly named files are always processed, missing ones are reported as failures
+			files.push_back(path);
+		}
+	}
+	sort(files.begin(), files.end());
+	return files;
+}
 
-	vector<int> ret = {0,0,0,0};
+// Expand the paths given on the command line into a sorted list of save files
+vector<string> collectSaveFiles(const vector<string>& paths){
+	return collectFiles(paths, {".sav", ".dsv"});
+}
 
-	int orderTable[24][4] = {
+// Run 'job(i)' for every i in [0, jobCount) on 'threads' workers
+// Every worker owns a deque of job indices and pops from its back, idle workers steal from the front of the other deques
+void runWorkStealing(size_t jobCount, unsigned threads, const function<void(size_t)>& job){
+	if(threads == 0){ threads = 1; }
+	if(threads > jobCount){ threads = jobCount ? jobCount : 1; }
+
+	vector<deque<size_t>> queues(threads);
+	vector<mutex> locks(threads);
+	for(size_t i = 0; i < jobCount; i++){ queues[i % threads].push_back(i); }
+
+	auto worker = [&](unsigned self){
+		while(true){
+			size_t next = 0;
+			bool found = false;
+
+			{
+				lock_guard<mutex> guard(locks[self]);
+				if(!queues[self].empty()){
+					next = queues[self].back();
+					queues[self].pop_back();
+					found = true;
+				}
+			}
 
-			// A offset -> index 0; B offset -> index 1; C offset -> index 2; D offset -> index 3
+			for(unsigned k = 1; !found && k < threads; k++){
+				unsigned victim = (self + k) % threads;
+				lock_guard<mutex> guard(locks[victim]);
+				if(!queues[victim].empty()){
+					next = queues[victim].front();
+					queues[victim].pop_front();
+					found = true;
+				}
+			}
 
-			{0,32,64,96}, //ABCD
-			{0,32,96,64}, //ABDC
-			{0,64,32,96}, //ACBD
-			{0,96,32,64}, //ACDB
-			{0,64,96,32}, //ADBC
-			{0,96,64,32}, //ADCB
-			{32,0,64,96}, //BACD
-			{32,0,96,64}, //BADC
-			{64,0,32,96}, //BCAD
-			{96,0,32,64}, //BCDA
-			{64,0,96,32}, //BDAC
-			{96,0,64,32}, //BDCA
-			{32,64,0,96}, //CABD
-			{32,96,0,64}, //CADB
-			{64,32,0,96}, //CBAD
-			{96,32,0,64}, //CBDA
-			{64,96,0,32}, //CDAB
-			{96,64,0,32}, //CDBA
-			{32,64,96,0}, //DABC
-			{32,96,64,0}, //DACB
-			{64,32,96,0}, //DBAC
-			{96,32,64,0}, //DBCA
-			{64,96,64,0}, //DCAB
-			{96,64,32,0}  //DCBA
+			// Jobs are never added once started, so empty queues everywhere means we're done
+			if(!found){ return; }
+			job(next);
+		}
 	};
-	int offset = ((pv & 0x3e000) >> 0xd) % 24;
-	for(int i = 0; i<4; i++){ ret[i] = orderTable[offset][i];}
-	return ret;
 
+	vector<thread> pool;
+	for(unsigned t = 1; t < threads; t++){ pool.emplace_back(worker, t); }
+	worker(0);
+	for(thread& t : pool){ t.join(); }
 }
 
-// Encrypt/Decrypt pokemon data blocks (linear congruential generator)
-void prng(vector<unsigned char>& data, long long seed, int block, int version){
-	if(block == 1){
-		for(int i = 0; i < 128; i += 2){
-			seed = ( (0x41C64E6D * seed) + 0x00006073 ) & 0xffffffff;
-			data[smallBlock1+versionNames[version][leadPokemonOffset] + 0x08 + i] ^= (seed >> 16) & 0xff;
-			data[smallBlock1+versionNames[version][leadPokemonOffset] + 0x08 + i + 1] ^= (seed >> 24) & 0xff;
+// Read, edit and write back a single save file, errors are reported in the result instead of exiting
+BatchResult processSaveFile(const string& path, const vector<EditOp>& ops, int version, bool verifyChecksums, SaveStats* stats){
+	BatchResult result = {path, false, "", 0, 0};
+	runWithStats(stats, [&](){
+		try{
+			SaveBuffer data;
+			data.setVerifyChecksums(verifyChecksums);
+			readFile(path.c_str(), data);
+			applyEdits(data, ops, resolveVersion(data, version));
+			result.written = writeFile(path.c_str(), data);
+			result.ok = true;
+			result.bytes = data.size();
 		}
-	}
-	else if(block == 2){
-		for(int i = 0; i < 128; i += 2){
-			seed = ( (0x41C64E6D * seed) + 0x00006073 ) & 0xffffffff;
-			data[smallBlock2+versionNames[version][leadPokemonOffset] + 0x08 + i ] ^= (seed >> 16) & 0xff;
-			data[smallBlock2+versionNames[version][leadPokemonOffset] + 0x08 + i + 1] ^= (seed >> 24) & 0xff;
+		catch(const exception& e){
+			result.message = e.what();
 		}
-	}
-	else{
-		cout << "Error: could not decrypt Pokemon Data Block" << endl;
-		exit(EXIT_FAILURE);
-	}
+	});
+	return result;
 }
 
-// Get the current checksum value of the lead pokemon from the save file data
-int getPokemonChecksum(vector<unsigned char> data, int block, int version){
-	int ret = 0;
-	if(block == 1){
-		ret += data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset] + 1] << 8;
-		ret += data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset]];
-		return ret;
-	}
-	else if(block == 2){
-		ret += data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset] + 1] << 8;
-		ret += data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset]];
-		return ret;
+// Entry point for '--batch', returns the process exit status
+int runBatch(const char* scriptPath, int version, const vector<string>& paths, unsigned threads, bool verifyChecksums, const string& statsPath){
+	vector<EditOp> ops = parseEditScript(scriptPath);
+	vector<string> files = collectSaveFiles(paths);
+	if(files.empty()){
+		cout << "Error: no save files found" << endl;
+		return EXIT_FAILURE;
 	}
-	else{
-		cout << "Error: could not get Pokemon Checksum" << endl;
-		exit(EXIT_FAILURE);
+	vector<SaveStats> stats(statsPath.empty() ? 0 : files.size());
+
+	mutex outputLock;
+	atomic<size_t> failed(0);
+	atomic<unsigned long long> totalBytes(0);
+	atomic<unsigned long long> totalWritten(0);
+
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		BatchResult result = processSaveFile(files[i], ops, version, verifyChecksums, stats.empty() ? nullptr : &stats[i]);
+		totalBytes += result.bytes;
+		totalWritten += result.written;
+		if(!result.ok){ failed++; }
+
+		lock_guard<mutex> guard(outputLock);
+		if(result.ok){ cout << "OK   " << result.path << "\n"; }
+		else{ cout << "FAIL " << result.path << ": " << result.message << "\n"; }
+	});
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	size_t total = files.size();
+	cout << "-------------------------------\n";
+	cout << "Processed " << total << " files (" << (total - failed) << " ok, " << failed << " failed) in " << fixed << setprecision(3) << seconds << " s\n";
+	if(seconds > 0){
+		cout << "Throughput: " << setprecision(1) << (total / seconds) << " files/s, " << (totalBytes / seconds / (1024.0 * 1024.0)) << " MiB/s of save data" << endl;
 	}
+	cout << "Written: " << totalWritten << " bytes" << endl;
+	if(!statsPath.empty()){ writeStatsReport(statsPath, files, stats); }
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-// Recalculate the checksum value of current lead pokemon so that it can be changed after file is edited
-int calcPokemonChecksum(vector<unsigned char> dataChunk){
-	int sum = 0;
-	for(unsigned long i = 0; i < dataChunk.size() - 1; i += 2){
-		sum += (dataChunk[i+1] << 8) + dataChunk[i];
+
+// - - - Pipeline Mode Functions - - - //
+
+/* Notes:
+	-> Pipeline mode reads saves from stdin (or any file descriptor), applies edits and writes them to stdout,
+	   so the editor can sit between e.g. 'zstd -d' and 'zstd' without temporary files
+	-> Edits come from an edit script (same format as batch mode) and/or '--edit' arguments with one script line each
+	-> A plain stream holds a single save (everything until end of input). With '--framed' the stream is any number of
+	   frames, each a 4 byte little endian length followed by that many bytes of save data; the output uses the same framing
+	-> Each save is read straight into one reusable buffer, edited in place (SaveBuffer::borrow) and written from it
+	-> Output is data only, errors go to stderr. A save that can't be edited stops the pipeline unless '--pass-invalid'
+	   is given, then it is written unchanged
+*/
+
+#define pipeFrameHeaderSize 4
+#define pipeMaxFrameSize (64u << 20)
+
+struct PipeOptions {
+	int version;
+	vector<EditOp> ops;
+	int inFd = STDIN_FILENO;
+	int outFd = STDOUT_FILENO;
+	bool framed = false;
+	bool passInvalid = false;
+};
+
+// Read exactly 'count' bytes, returns the number read (less only at end of input)
+size_t readFully(int fd, unsigned char* out, size_t count){
+	size_t done = 0;
+	while(done < count){
+		ssize_t n = read(fd, out + done, count - done);
+		if(n < 0 && errno == EINTR){ continue; }
+		if(n < 0){ throw SaveError(SaveErrorCode::fileError, "could not read input"); }
+		if(n == 0){ break; }
+		done += n;
 	}
-	return sum & 0xffff;
+	return done;
 }
 
-// Write the new pokemon checksum value to the data vector
-void updatePokemonChecksum(vector<unsigned char>& data, int newValue, int block, int version){
-	if(block == 1){
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset]] = newValue & 0xff;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset] + 1] = newValue >> 8;
+void writeFully(int fd, const unsigned char* src, size_t count){
+	while(count > 0){
+		ssize_t n = write(fd, src, count);
+		if(n < 0 && errno == EINTR){ continue; }
+		if(n <= 0){ throw SaveError(SaveErrorCode::fileError, "could not write output"); }
+		src += n; count -= n;
 	}
-	else if(block == 2){
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset]] = newValue & 0xff;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[pokemonChecksumOffset] + 1] = newValue >> 8;
+}
+
+// Read one save into 'buffer', returns false once the input is exhausted
+bool readPipeSave(const PipeOptions& options, vector<unsigned char>& buffer, size_t& length){
+	if(options.framed){
+		unsigned char header[pipeFrameHeaderSize];
+		size_t got = readFully(options.inFd, header, sizeof(header));
+		if(got == 0){ return false; }
+		if(got != sizeof(header)){ throw SaveError(SaveErrorCode::invalidSave, "truncated frame header"); }
+
+		length = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+		if(length > pipeMaxFrameSize){ throw SaveError(SaveErrorCode::invalidSave, "frame is too large to be a save file"); }
+		if(buffer.size() < length){ buffer.resize(length); }
+		if(readFully(options.inFd, buffer.data(), length) != length){
+			throw SaveError(SaveErrorCode::invalidSave, "truncated frame");
+		}
+		return true;
 	}
-	else{
-		cout << "Error: could not update Pokemon Checksum" << endl;
-		exit(EXIT_FAILURE);
+
+	// Unframed: everything up to the end of input is one save
+	length = 0;
+	if(buffer.size() < generatedSaveSize){ buffer.resize(generatedSaveSize); }
+	while(true){
+		length += readFully(options.inFd, buffer.data() + length, buffer.size() - length);
+		if(length < buffer.size()){ break; }
+		if(length >= pipeMaxFrameSize){ throw SaveError(SaveErrorCode::invalidSave, "input is too large to be a save file"); }
+		buffer.resize(buffer.size() * 2);
 	}
+	return length > 0;
 }
 
+void writePipeSave(const PipeOptions& options, const unsigned char* data, size_t length){
+	if(options.framed){
+		unsigned char header[pipeFrameHeaderSize];
+		for(int i = 0; i < pipeFrameHeaderSize; i++){ header[i] = (length >> (8 * i)) & 0xff; }
+		writeFully(options.outFd, header, sizeof(header));
+	}
+	writeFully(options.outFd, data, length);
+}
 
-// - - - Player Editing Functions - - - //
-
-void changePlayerName(vector<unsigned char>& data, string newName, int block, int version){
-	int len = newName.length();
-	if(len <= 7 ){
-		if(block == 1){
-			for(int i = 0; i<16; i++){
-				data[smallBlock1 + versionNames[version][trainerNameOffset]+0] = 0;
-			}
-			for(int i = 0; i<(len*2); i += 2){
-				data[smallBlock1 + versionNames[version][trainerNameOffset] + i] = toGameEncoding(newName[i/2]);
-				data[smallBlock1 + versionNames[version][trainerNameOffset] + i + 1] = 1;
-			}
-			data[smallBlock1 + versionNames[version][trainerNameOffset] + len*2] = 0xff;
-			data[smallBlock1 + versionNames[version][trainerNameOffset] + len*2+1] = 0xff;
+// Entry point for '--pipe', returns the process exit status
+int runPipeline(const PipeOptions& options){
+	vector<unsigned char> buffer;
+	SaveBuffer save;
+	size_t length = 0;
+	size_t count = 0, failed = 0;
+
+	while(readPipeSave(options, buffer, length)){
+		count++;
+		try{
+			save.borrow(span<unsigned char>(buffer.data(), length));
+			applyEdits(save, options.ops, resolveVersion(save, options.version));
 		}
-		else if(block == 2){
-			for(int i = 0; i<16; i++){
-				data[smallBlock2 + versionNames[version][trainerNameOffset]+0] = 0;
+		catch(const SaveError& e){
+			if(!options.passInvalid){
+				cerr << "Error: save " << count << ": " << e.what() << endl;
+				return EXIT_FAILURE;
 			}
-			for(int i = 0; i<(len*2); i += 2){
-				data[smallBlock2 + versionNames[version][trainerNameOffset] + i] = toGameEncoding(newName[i/2]);
-				data[smallBlock2 + versionNames[version][trainerNameOffset] + i + 1] = 1;
+
+			// Undo a partly applied edit so the save goes out exactly as it came in
+			for(const DirtyRange& r : save.dirtyRanges()){
+				memcpy(buffer.data() + r.offset, save.originalBytes(r), r.length);
 			}
-			data[smallBlock2 + versionNames[version][trainerNameOffset] + len*2] = 0xff;
-			data[smallBlock2 + versionNames[version][trainerNameOffset] + len*2+1] = 0xff;
-		}
-		else{
-			cout << "Error: couldn't change player name"  << endl;
-			exit(EXIT_FAILURE);
+			cerr << "Warning: save " << count << " passed through unchanged: " << e.what() << endl;
+			failed++;
 		}
-	}
-	else{
-		cout << "Invalid name\nMake sure the deisred name is 7 characters long and consists of only alphanumerics." << endl;
-		exit(EXIT_FAILURE);
+		save.close();
+		writePipeSave(options, buffer.data(), length);
 	}
 
-	// Update save file checksum
-	vector<unsigned char> tmp = getSubVector(data, smallBlock1, smallBlock1 + versionNames[version][smallBlockChecksumOffset]);
-	int sum =  crc16ccitt(tmp);
-	updateChecksum(data, sum, block, version);
+	if(count == 0){
+		cerr << "Error: no save data on input" << endl;
+		return EXIT_FAILURE;
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 
-// - - - Pokemon Editing Functions - - - //
+// - - - Save Patch Functions - - - //
 
-// Edit the species of lead pokemon
-void editPokemonSpecies(vector<unsigned char>& data, string pokemonName, vector<int> blockOffsets, int block, int version){
+/* Notes:
+	-> '--diff' writes the structure-aware patch between two snapshots of a save (see diffSaves)
+	-> '--patch' applies one patch to many saves in place, in parallel like batch mode; only the bytes the patch
+	   changes are written back (crash safe, see SaveBuffer::commit)
+*/
 
+// Read the whole file at 'path'
+vector<unsigned char> readPatchFile(const string& path){
+	ifstream file(path, ios::binary);
+	if(!file){ throw SaveError(SaveErrorCode::fileError, "could not read patch '" + path + "'"); }
+	return vector<unsigned char>((istreambuf_iterator<char>(file)), {});
+}
 
-	// Get Pokemon Species ID for given 'pokemonName'
-	map<string, int> pokedex = { {"Bulbasaur", 1,}, {"Ivysaur", 2,}, {"Venusaur", 3,}, {"Charmander", 4,}, {"Charmeleon", 5,}, {"Charizard", 6,}, {"Squirtle", 7,}, {"Wartortle", 8,}, {"Blastoise", 9,}, {"Caterpie", 10,}, {"Metapod", 11,}, {"Butterfree", 12,}, {"Weedle", 13,}, {"Kakuna", 14,}, {"Beedrill", 15,}, {"Pidgey", 16,}, {"Pidgeotto", 17,}, {"Pidgeot", 18,}, {"Rattata", 19,}, {"Raticate", 20,}, {"Spearow", 21,}, {"Fearow", 22,}, {"Ekans", 23,}, {"Arbok", 24,}, {"Pikachu", 25,}, {"Raichu", 26,}, {"Sandshrew", 27,}, {"Sandslash", 28,}, {"NidoranF", 29,}, {"Nidorina", 30,}, {"Nidoqueen", 31,}, {"NidoranM", 32,}, {"Nidorino", 33,}, {"Nidoking", 34,}, {"Clefairy", 35,}, {"Clefable", 36,}, {"Vulpix", 37,}, {"Ninetales", 38,}, {"Jigglypuff", 39,}, {"Wigglytuff", 40,}, {"Zubat", 41,}, {"Golbat", 42,}, {"Oddish", 43,}, {"Gloom", 44,}, {"Vileplume", 45,}, {"Paras", 46,}, {"Parasect", 47,}, {"Venonat", 48,}, {"Venomoth", 49,}, {"Diglett", 50,}, {"Dugtrio", 51,}, {"Meowth", 52,}, {"Persian", 53,}, {"Psyduck", 54,}, {"Golduck", 55,}, {"Mankey", 56,}, {"Primeape", 57,}, {"Growlithe", 58,}, {"Arcanine", 59,}, {"Poliwag", 60,}, {"Poliwhirl", 61,}, {"Poliwrath", 62,}, {"Abra", 63,}, {"Kadabra", 64,}, {"Alakazam", 65,}, {"Machop", 66,}, {"Machoke", 67,}, {"Machamp", 68,}, {"Bellsprout", 69,}, {"Weepinbell", 70,}, {"Victreebel", 71,}, {"Tentacool", 72,}, {"Tentacruel", 73,}, {"Geodude", 74,}, {"Graveler", 75,}, {"Golem", 76,}, {"Ponyta", 77,}, {"Rapidash", 78,}, {"Slowpoke", 79,}, {"Slowbro", 80,}, {"Magnemite", 81,}, {"Magneton", 82,}, {"Farfetch'd", 83,}, {"Doduo", 84,}, {"Dodrio", 85,}, {"Seel", 86,}, {"Dewgong", 87,}, {"Grimer", 88,}, {"Muk", 89,}, {"Shellder", 90,}, {"Cloyster", 91,}, {"Gastly", 92,}, {"Haunter", 93,}, {"Gengar", 94,}, {"Onix", 95,}, {"Drowzee", 96,}, {"Hypno", 97,}, {"Krabby", 98,}, {"Kingler", 99,}, {"Voltorb", 100,}, {"Electrode", 101,}, {"Exeggcute", 102,}, {"Exeggutor", 103,}, {"Cubone", 104,}, {"Marowak", 105,}, {"Hitmonlee", 106,}, {"Hitmonchan", 107,}, {"Lickitung", 108,}, {"Koffing", 109,}, {"Weezing", 110,}, {"Rhyhorn", 111,}, {"Rhydon", 112,}, {"Chansey", 113,}, {"Tangela", 114,}, {"Kangaskhan", 115,}, {"Horsea", 116,}, {"Seadra", 117,}, {"Goldeen", 118,}, {"Seaking", 119,}, {"Staryu", 120,}, {"Starmie", 121,}, {"Mr. Mime", 122,}, {"Scyther", 123,}, {"Jynx", 124,}, {"Electabuzz", 125,}, {"Magmar", 126,}, {"Pinsir", 127,}, {"Tauros", 128,}, {"Magikarp", 129,}, {"Gyarados", 130,}, {"Lapras", 131,}, {"Ditto", 132,}, {"Eevee", 133,}, {"Vaporeon", 134,}, {"Jolteon", 135,}, {"Flareon", 136,}, {"Porygon", 137,}, {"Omanyte", 138,}, {"Omastar", 139,}, {"Kabuto", 140,}, {"Kabutops", 141,}, {"Aerodactyl", 142,}, {"Snorlax", 143,}, {"Articuno", 144,}, {"Zapdos", 145,}, {"Moltres", 146,}, {"Dratini", 147,}, {"Dragonair", 148,}, {"Dragonite", 149,}, {"Mewtwo", 150,}, {"Mew", 151,}, {"Chikorita", 152,}, {"Bayleef", 153,}, {"Meganium", 154,}, {"Cyndaquil", 155,}, {"Quilava", 156,}, {"Typhlosion", 157,}, {"Totodile", 158,}, {"Croconaw", 159,}, {"Feraligatr", 160,}, {"Sentret", 161,}, {"Furret", 162,}, {"Hoothoot", 163,}, {"Noctowl", 164,}, {"Ledyba", 165,}, {"Ledian", 166,}, {"Spinarak", 167,}, {"Ariados", 168,}, {"Crobat", 169,}, {"Chinchou", 170,}, {"Lanturn", 171,}, {"Pichu", 172,}, {"Cleffa", 173,}, {"Igglybuff", 174,}, {"Togepi", 175,}, {"Togetic", 176,}, {"Natu", 177,}, {"Xatu", 178,}, {"Mareep", 179,}, {"Flaaffy", 180,}, {"Ampharos", 181,}, {"Bellossom", 182,}, {"Marill", 183,}, {"Azumarill", 184,}, {"Sudowoodo", 185,}, {"Politoed", 186,}, {"Hoppip", 187,}, {"Skiploom", 188,}, {"Jumpluff", 189,}, {"Aipom", 190,}, {"Sunkern", 191,}, {"Sunflora", 192,}, {"Yanma", 193,}, {"Wooper", 194,}, {"Quagsire", 195,}, {"Espeon", 196,}, {"Umbreon", 197,}, {"Murkrow", 198,}, {"Slowking", 199,}, {"Misdreavus", 200,}, {"Unown", 201,}, {"Wobbuffet", 202,}, {"Girafarig", 203,}, {"Pineco", 204,}, {"Forretress", 205,}, {"Dunsparce", 206,}, {"Gligar", 207,}, {"Steelix", 208,}, {"Snubbull", 209,}, {"Granbull", 210,}, {"Qwilfish", 211,}, {"Scizor", 212,}, {"Shuckle", 213,}, {"Heracross", 214,}, {"Sneasel", 215,}, {"Teddiursa", 216,}, {"Ursaring", 217,}, {"Slugma", 218,}, {"Magcargo", 219,}, {"Swinub", 220,}, {"Piloswine", 221,}, {"Corsola", 222,}, {"Remoraid", 223,}, {"Octillery", 224,}, {"Delibird", 225,}, {"Mantine", 226,}, {"Skarmory", 227,}, {"Houndour", 228,}, {"Houndoom", 229,}, {"Kingdra", 230,}, {"Phanpy", 231,}, {"Donphan", 232,}, {"Porygon2", 233,}, {"Stantler", 234,}, {"Smeargle", 235,}, {"Tyrogue", 236,}, {"Hitmontop", 237,}, {"Smoochum", 238,}, {"Elekid", 239,}, {"Magby", 240,}, {"Miltank", 241,}, {"Blissey", 242,}, {"Raikou", 243,}, {"Entei", 244,}, {"Suicune", 245,}, {"Larvitar", 246,}, {"Pupitar", 247,}, {"Tyranitar", 248,}, {"Lugia", 249,}, {"Ho-Oh", 250,}, {"Celebi", 251,}, {"Treecko", 252,}, {"Grovyle", 253,}, {"Sceptile", 254,}, {"Torchic", 255,}, {"Combusken", 256,}, {"Blaziken", 257,}, {"Mudkip", 258,}, {"Marshtomp", 259,}, {"Swampert", 260,}, {"Poochyena", 261,}, {"Mightyena", 262,}, {"Zigzagoon", 263,}, {"Linoone", 264,}, {"Wurmple", 265,}, {"Silcoon", 266,}, {"Beautifly", 267,}, {"Cascoon", 268,}, {"Dustox", 269,}, {"Lotad", 270,}, {"Lombre", 271,}, {"Ludicolo", 272,}, {"Seedot", 273,}, {"Nuzleaf", 274,}, {"Shiftry", 275,}, {"Taillow", 276,}, {"Swellow", 277,}, {"Wingull", 278,}, {"Pelipper", 279,}, {"Ralts", 280,}, {"Kirlia", 281,}, {"Gardevoir", 282,}, {"Surskit", 283,}, {"Masquerain", 284,}, {"Shroomish", 285,}, {"Breloom", 286,}, {"Slakoth", 287,}, {"Vigoroth", 288,}, {"Slaking", 289,}, {"Nincada", 290,}, {"Ninjask", 291,}, {"Shedinja", 292,}, {"Whismur", 293,}, {"Loudred", 294,}, {"Exploud", 295,}, {"Makuhita", 296,}, {"Hariyama", 297,}, {"Azurill", 298,}, {"Nosepass", 299,}, {"Skitty", 300,}, {"Delcatty", 301,}, {"Sableye", 302,}, {"Mawile", 303,}, {"Aron", 304,}, {"Lairon", 305,}, {"Aggron", 306,}, {"Meditite", 307,}, {"Medicham", 308,}, {"Electrike", 309,}, {"Manectric", 310,}, {"Plusle", 311,}, {"Minun", 312,}, {"Volbeat", 313,}, {"Illumise", 314,}, {"Roselia", 315,}, {"Gulpin", 316,}, {"Swalot", 317,}, {"Carvanha", 318,}, {"Sharpedo", 319,}, {"Wailmer", 320,}, {"Wailord", 321,}, {"Numel", 322,}, {"Camerupt", 323,}, {"Torkoal", 324,}, {"Spoink", 325,}, {"Grumpig", 326,}, {"Spinda", 327,}, {"Trapinch", 328,}, {"Vibrava", 329,}, {"Flygon", 330,}, {"Cacnea", 331,}, {"Cacturne", 332,}, {"Swablu", 333,}, {"Altaria", 334,}, {"Zangoose", 335,}, {"Seviper", 336,}, {"Lunatone", 337,}, {"Solrock", 338,}, {"Barboach", 339,}, {"Whiscash", 340,}, {"Corphish", 341,}, {"Crawdaunt", 342,}, {"Baltoy", 343,}, {"Claydol", 344,}, {"Lileep", 345,}, {"Cradily", 346,}, {"Anorith", 347,}, {"Armaldo", 348,}, {"Feebas", 349,}, {"Milotic", 350,}, {"Castform", 351,}, {"Kecleon", 352,}, {"Shuppet", 353,}, {"Banette", 354,}, {"Duskull", 355,}, {"Dusclops", 356,}, {"Tropius", 357,}, {"Chimecho", 358,}, {"Absol", 359,}, {"Wynaut", 360,}, {"Snorunt ", 361,}, {"Glalie", 362,}, {"Spheal", 363,}, {"Sealeo", 364,}, {"Walrein", 365,}, {"Clamperl", 366,}, {"Huntail", 367,}, {"Gorebyss", 368,}, {"Relicanth", 369,}, {"Luvdisc", 370,}, {"Bagon", 371,}, {"Shelgon", 372,}, {"Salamence", 373,}, {"Beldum", 374,}, {"Metang", 375,}, {"Metagross", 376,}, {"Regirock", 377,}, {"Regice", 378,}, {"Registeel", 379,}, {"Latias", 380,}, {"Latios", 381,}, {"Kyogre", 382,}, {"Groudon", 383,}, {"Rayquaza", 384,}, {"Jirachi", 385,}, {"Deoxys", 386,}, {"Turtwig", 387,}, {"Grotle", 388,}, {"Torterra", 389,}, {"Chimchar", 390,}, {"Monferno", 391,}, {"Infernape", 392,}, {"Piplup", 393,}, {"Prinplup", 394,}, {"Empoleon", 395,}, {"Starly", 396,}, {"Staravia", 397,}, {"Staraptor", 398,}, {"Bidoof", 399,}, {"Bibarel", 400,}, {"Kricketot", 401,}, {"Kricketune", 402,}, {"Shinx", 403,}, {"Luxio", 404,}, {"Luxray", 405,}, {"Budew", 406,}, {"Roserade", 407,}, {"Cranidos", 408,}, {"Rampardos", 409,}, {"Shieldon", 410,}, {"Bastiodon", 411,}, {"Burmy", 412,}, {"Wormadam", 413,}, {"Mothim", 414,}, {"Combee", 415,}, {"Vespiquen", 416,}, {"Pachirisu", 417,}, {"Buizel", 418,}, {"Floatzel", 419,}, {"Cherubi", 420,}, {"Cherrim", 421,}, {"Shellos", 422,}, {"Gastrodon", 423,}, {"Ambipom", 424,}, {"Drifloon", 425,}, {"Drifblim", 426,}, {"Buneary", 427,}, {"Lopunny", 428,}, {"Mismagius", 429,}, {"Honchkrow", 430,}, {"Glameow", 431,}, {"Purugly", 432,}, {"Chingling", 433,}, {"Stunky", 434,}, {"Skuntank", 435,}, {"Bronzor", 436,}, {"Bronzong", 437,}, {"Bonsly", 438,}, {"Mime Jr.", 439,}, {"Happiny", 440,}, {"Chatot", 441,}, {"Spiritomb", 442,}, {"Gible", 443,}, {"Gabite", 444,}, {"Garchomp", 445,}, {"Munchlax", 446,}, {"Riolu", 447,}, {"Lucario", 448,}, {"Hippopotas", 449,}, {"Hippowdon", 450,}, {"Skorupi", 451,}, {"Drapion", 452,}, {"Croagunk", 453,}, {"Toxicroak", 454,}, {"Carnivine", 455,}, {"Finneon", 456,}, {"Lumineon", 457,}, {"Mantyke", 458,}, {"Snover", 459,}, {"Abomasnow", 460,}, {"Weavile", 461,}, {"Magnezone", 462,}, {"Lickilicky", 463,}, {"Rhyperior", 464,}, {"Tangrowth", 465,}, {"Electivire", 466,}, {"Magmortar", 467,}, {"Togekiss", 468,}, {"Yanmega", 469,}, {"Leafeon", 470,}, {"Glaceon", 471,}, {"Gliscor", 472,}, {"Mamoswine", 473,}, {"Porygon-Z", 474,}, {"Gallade", 475,}, {"Probopass", 476,}, {"Dusknoir", 477,}, {"Froslass", 478,}, {"Rotom", 479,}, {"Uxie", 480,}, {"Mesprit", 481,}, {"Azelf", 482,}, {"Dialga", 483,}, {"Palkia", 484,}, {"Heatran", 485,}, {"Regigigas", 486,}, {"Giratina", 487,}, {"Cresselia", 488,}, {"Phione", 489,}, {"Manaphy", 490,}, {"Darkrai", 491,}, {"Shaymin", 492,}, {"Arceus", 493,} };
-	int id = pokedex[pokemonName];
-	if(!id){
-		cout << "Error: invalid Pokemon name" << endl;
-		exit(EXIT_FAILURE);
+// Entry point for '--diff', returns the process exit status
+int runDiff(const char* basePath, const char* targetPath, int version, const char* patchPath){
+	SaveBuffer base, target;
+	readFile(basePath, base, true);
+	readFile(targetPath, target, true);
+
+	auto start = chrono::steady_clock::now();
+	vector<unsigned char> patch = diffSaves(base.view(0, base.size()), target.view(0, target.size()), version);
+	double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+	ofstream out(patchPath, ios::binary);
+	out.write((const char*)patch.data(), patch.size());
+	if(!out){ throw SaveError(SaveErrorCode::fileError, string("could not write patch '") + patchPath + "'"); }
+	cout << "Patch: " << patch.size() << " bytes for a " << target.size() << " byte save, diffed in " << fixed << setprecision(1) << micros << " us" << endl;
+	return EXIT_SUCCESS;
+}
+
+// Entry point for '--patch', returns the process exit status
+int runPatch(const char* patchPath, const vector<string>& paths, unsigned threads){
+	vector<unsigned char> patch = readPatchFile(patchPath);
+	getPatchVersion(patch);
+	vector<string> files = collectSaveFiles(paths);
+	if(files.empty()){
+		cout << "Error: no save files found" << endl;
+		return EXIT_FAILURE;
 	}
 
-	// Update pokemon species
-	if(block == 1){
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[speciesID] ] = id & 0xff;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[speciesID] + 1] = id >> 8;
+	mutex outputLock;
+	atomic<size_t> failed(0);
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		string message;
+		try{
+			SaveBuffer data;
+			readFile(files[i].c_str(), data);
+			applySavePatch(data, patch);
+			data.commit();
+		}
+		catch(const exception& e){
+			message = e.what();
+			failed++;
+		}
+
+		lock_guard<mutex> guard(outputLock);
+		if(message.empty()){ cout << "OK   " << files[i] << "\n"; }
+		else{ cout << "FAIL " << files[i] << ": " << message << "\n"; }
+	});
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "-------------------------------\n";
+	cout << "Patched " << (files.size() - failed) << " of " << files.size() << " files in " << fixed << setprecision(3) << seconds << " s" << endl;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+// - - - Integrity Check Functions - - - //
+
+/* Notes:
+	-> '--check' runs checkSaveIntegrity on many save files, one file per worker at a time: files are mapped read only,
+	   so memory use does not grow with the size of the corpus
+	-> Only files with problems are reported unless '--all' is given, results are printed as files finish
+*/
+
+const char* blockStatusNames[] = { "ok", "unused", "corrupt" };
+const char* recordProblemNames[] = { "ok", "bad egg", "bad checksum", "impossible species or level" };
+
+// One line per problem of a checked save, empty if there are none and 'all' is not set
+string describeIntegrity(const string& path, const SaveIntegrity& check, bool all){
+	ostringstream out;
+	out << (check.ok() ? "OK   " : "BAD  ") << path << ": ";
+	if(check.currentBlock){ out << "save slot " << check.currentBlock << " loads"; }
+	else{ out << "no valid save slot"; }
+	if(check.newestBlock != check.currentBlock){ out << " (slot " << check.newestBlock << " is newer but " << blockStatusNames[check.smallBlocks[check.newestBlock - 1].status] << ")"; }
+	out << ", " << check.records << " pokemon, " << check.issues.size() << " problems\n";
+	if(check.ok() && !all){ return ""; }
+
+	for(int block = 1; block <= 2; block++){
+		const BlockIntegrity* blocks[] = { &check.smallBlocks[block - 1], &check.bigBlocks[block - 1] };
+		for(int big = 0; big < 2; big++){
+			const BlockIntegrity& b = *blocks[big];
+			if(b.status != blockValid || all){
+				out << "     " << (big ? "Big" : "Small") << " block " << block << ": " << blockStatusNames[b.status];
+				if(b.status == blockCorrupt){ out << hex << setfill('0') << " (stored 0x" << setw(4) << b.storedChecksum << ", computed 0x" << setw(4) << b.checksum << ")" << dec << setfill(' '); }
+				out << "\n";
+			}
+		}
+		if(check.partyCount[block - 1] > partySize){ out << "     Save slot " << block << ": party count " << check.partyCount[block - 1] << "\n"; }
 	}
-	else if(block == 2){
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[speciesID] ] = id & 0xff;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[speciesID] + 1] = id >> 8;
+	if(!check.currentBigBlock){ out << "     No valid box data\n"; }
+	for(const RecordIssue& issue : check.issues){
+		out << "     Save slot " << issue.block << ", ";
+		if(issue.box < 0){ out << "party slot " << issue.slot + 1; }
+		else{ out << "box " << issue.box + 1 << " slot " << issue.slot + 1; }
+		out << ": " << recordProblemNames[issue.problem] << "\n";
 	}
-	else{
-		cout << "Error: could not edit pokemon" << endl;
-		exit(EXIT_FAILURE);
+	return out.str();
+}
+
+// Entry point for '--check', fails if any save has a problem
+int runIntegrityCheck(int version, const vector<string>& paths, unsigned threads, bool all, const string& statsPath){
+	vector<string> files = collectSaveFiles(paths);
+	if(files.empty()){
+		cout << "Error: no save files found" << endl;
+		return EXIT_FAILURE;
 	}
+	vector<SaveStats> stats(statsPath.empty() ? 0 : files.size());
+
+	mutex outputLock;
+	atomic<size_t> bad(0), failed(0), records(0);
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		string report;
+		runWithStats(stats.empty() ? nullptr : &stats[i], [&](){
+			try{
+				SaveBuffer data;
+				readFile(files[i].c_str(), data, true);
+				SaveIntegrity check = checkSaveIntegrity(data, resolveVersion(data, version));
+				records += check.records;
+				if(!check.ok()){ bad++; }
+				report = describeIntegrity(files[i], check, all);
+			}
+			catch(const exception& e){
+				failed++;
+				report = "FAIL " + files[i] + ": " + e.what() + "\n";
+			}
+		});
+		if(report.empty()){ return; }
+		lock_guard<mutex> guard(outputLock);
+		cout << report;
+	});
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "-------------------------------\n";
+	cout << "Checked " << files.size() << " files (" << records << " pokemon) in " << fixed << setprecision(3) << seconds << " s: " << (files.size() - bad - failed) << " ok, " << bad << " with problems, " << failed << " unreadable" << endl;
+	if(!statsPath.empty()){ writeStatsReport(statsPath, files, stats); }
+	return (bad || failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
-	// Update pokemon name
-	for(unsigned long i = 0; i<pokemonName.size(); i++){ pokemonName[i] = toupper(pokemonName[i]);}
-	if(block == 1){
-		for(int i = 0; i<22; i++){
-			data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + i ] = 0;
-		}
-		for(unsigned long i = 0; i<(pokemonName.size()*2); i+=2){
-			data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + i ] = toGameEncoding(pokemonName[i/2]);
-			data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + i + 1] = 1;
+
+// - - - Version Detection Functions - - - //
+
+/* Notes:
+	-> '--detect' prints the version of many save files (one file per worker at a time, mapped read only) with the score
+	   of the best profile and the signals it matched, files whose version can't be told apart are listed as unknown
+	-> 'auto' instead of a version name detects the version of every save in batch mode, pipe mode, '--check' and
+	   the interactive editor
+*/
+
+const char* signalNames[] = { "small block", "big block", "footer", "trainer", "party" };
+
+// One line with the verdict for 'path' and the score of the best two profiles
+string describeDetection(const string& path, const VersionDetection& detection){
+	const VersionScore& best = detection.ranked[0];
+	const VersionScore& next = detection.ranked[1];
+	ostringstream out;
+	out << left << setw(10) << ((detection.version < 0) ? "unknown" : versionProfileNames[detection.version]) << right << setw(4) << best.score << "  " << path << " (";
+	if(detection.version < 0){ out << "best " << versionProfileNames[best.version] << ", "; }
+	bool first = true;
+	for(int i = 0; i < (int)(sizeof(signalNames) / sizeof(signalNames[0])); i++){
+		if(best.signals & (1 << i)){
+			out << (first ? "" : " ") << signalNames[i];
+			first = false;
 		}
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + pokemonName.size()*2] = 0xff;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + pokemonName.size()*2 + 1] = 0xff;
 	}
-	else if(block == 2){
-		for(int i = 0; i<22; i++){
-			data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + i ] = 0;
-		}
-		for(unsigned long i = 0; i<(pokemonName.size()*2); i+=2){
-			data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + i ] = toGameEncoding(pokemonName[i/2]);
-			data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + i + 1] = 1;
-		}
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + pokemonName.size()*2] = 0xff;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[2] + pokemon[nickname] + pokemonName.size()*2 + 1] = 0xff;
+	if(first){ out << "no signals"; }
+	out << "; next " << versionProfileNames[next.version] << " " << next.score << ")\n";
+	return out.str();
+}
+
+// Entry point for '--detect', fails if the version of any save could not be detected
+int runDetect(const vector<string>& paths, unsigned threads){
+	vector<string> files = collectSaveFiles(paths);
+	if(files.empty()){
+		cout << "Error: no save files found" << endl;
+		return EXIT_FAILURE;
 	}
-	else{
-		cout << "Error: could not edit pokemon" << endl;
-		exit(EXIT_FAILURE);
-		}
 
+	mutex outputLock;
+	atomic<size_t> found[versionProfileCount] = {}, unknown(0), failed(0);
+	atomic<long long> detectNanoseconds(0);
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		string report;
+		try{
+			SaveBuffer data;
+			readFile(files[i].c_str(), data, true);
+			auto detectStart = chrono::steady_clock::now();
+			VersionDetection detection = detectVersion(data);
+			detectNanoseconds += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - detectStart).count();
+			if(detection.version < 0){ unknown++; }
+			else{ found[detection.version]++; }
+			report = describeDetection(files[i], detection);
+		}
+		catch(const exception& e){
+			failed++;
+			report = "FAIL " + files[i] + ": " + e.what() + "\n";
+		}
+		lock_guard<mutex> guard(outputLock);
+		cout << report;
+	});
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "-------------------------------\n";
+	cout << "Detected " << (files.size() - unknown - failed) << " of " << files.size() << " files in " << fixed << setprecision(3) << seconds << " s ("
+		<< setprecision(1) << detectNanoseconds / 1000.0 / files.size() << " us of probing per file):";
+	for(int version = 0; version < versionProfileCount; version++){ cout << " " << found[version] << " " << versionProfileNames[version] << ","; }
+	cout << " " << unknown << " unknown, " << failed << " unreadable" << endl;
+	return (unknown || failed) ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-// Edit the ability of lead pokemon
-void editPokemonAbility(vector<unsigned char>& data, string abilityName, vector<int> blockOffsets, int block, int version){
 
-	// Get the Ability ID for given 'abilityName'
+// - - - Corpus Index Functions - - - //
 
-	map<string, int> abilityMap= { {"Adaptability", 91,},{"Aftermath", 106,},{"Air Lock", 76,},{"Anger Point", 83,},{"Anticipation", 107,},{"Arena Trap", 71,},{"Bad Dreams", 123,},{"Battle Armor", 4,},{"Blaze", 66,},{"Chlorophyll", 34,},{"Clear Body", 29,},{"Cloud Nine", 13,},{"Color Change", 16,},{"Compound Eyes", 14,},{"Cute Charm", 56,},{"Damp", 6,},{"Download", 88,},{"Drizzle", 2,},{"Drought", 70,},{"Dry Skin", 87,},{"Early Bird", 48,},{"Effect Spore", 27,},{"Filter", 111,},{"Flame Body", 49,},{"Flash Fire", 18,},{"Flower Gift", 122,},{"Forecast", 59,},{"Forewarn", 108,},{"Frisk", 119,},{"Gluttony", 82,},{"Guts", 62,},{"Heatproof", 85,},{"Honey Gather", 118,},{"Huge Power", 37,},{"Hustle", 55,},{"Hydration", 93,},{"Hyper Cutter", 52,},{"Ice Body", 115,},{"Illuminate", 35,},{"Immunity", 17,},{"Inner Focus", 39,},{"Insomnia", 15,},{"Intimidate", 22,},{"Iron Fist", 89,},{"Keen Eye", 51,},{"Klutz", 103,},{"Leaf Guard", 102,},{"Levitate", 26,},{"Lightning Rod", 31,},{"Limber", 7,},{"Liquid Ooze", 64,},{"Magic Guard", 98,},{"Magma Armor", 40,},{"Magnet Pull", 42,},{"Marvel Scale", 63,},{"Minus", 58,},{"Mold Breaker", 104,},{"Motor Drive", 78,},{"Multitype", 121,},{"Natural Cure", 30,},{"No Guard", 99,},{"Normalize", 96,},{"Oblivious", 12,},{"Overgrow", 65,},{"Own Tempo", 20,},{"Pickup", 53,},{"Plus", 57,},{"Poison Heal", 90,},{"Poison Point", 38,},{"Pressure", 46,},{"Pure Power", 74,},{"Quick Feet", 95,},{"Rain Dish", 44,},{"Reckless", 120,},{"Rivalry", 79,},{"Rock Head", 69,},{"Rough Skin", 24,},{"Run Away", 50,},{"Sand Stream", 45,},{"Sand Veil", 8,},{"Scrappy", 113,},{"Serene Grace", 32,},{"Shadow Tag", 23,},{"Shed Skin", 61,},{"Shell Armor", 75,},{"Shield Dust", 19,},{"Simple", 86,},{"Skill Link", 92,},{"Slow Start", 112,},{"Sniper", 97,},{"Snow Cloak", 81,},{"Snow Warning", 117,},{"Solar Power", 94,},{"Solid Rock", 116,},{"Soundproof", 43,},{"Speed Boost", 3,},{"Stall", 100,},{"Static", 9,},{"Steadfast", 80,},{"Stench", 1,},{"Sticky Hold", 60,},{"Storm Drain", 114,},{"Sturdy", 5,},{"Suction Cups", 21,},{"Super Luck", 105,},{"Swarm", 68,},{"Swift Swim", 33,},{"Synchronize", 28,},{"Tangled Feet", 77,},{"Technician", 101,},{"Thick Fat", 47,},{"Tinted Lens", 110,},{"Torrent", 67,},{"Trace", 36,},{"Truant", 54,},{"Unaware", 109,},{"Unburden", 84,},{"Vital Spirit", 72,},{"Volt Absorb", 10,},{"Water Absorb", 11,},{"Water Veil", 41,},{"White Smoke", 73,},{"Wonder Guard", 25,} };
-	int id = abilityMap[abilityName];
-	if(!id){
-		cout << "Error: invalid Ability name" << endl;
-		exit(EXIT_FAILURE);
-	}
+/* Notes:
+	-> '--index' decodes the trainer data, the party and all PC boxes of many save files (in parallel) into one index file,
+	   '--query' filters the index without opening any save file
+	-> The index is columnar: every field of every indexed pokemon is stored as its own array, so a query only
+	   touches the columns it filters on
+	-> Rebuilding an index reuses the rows of every file whose size, modification time and version did not change
+	-> Index file layout (all values little endian):
+		"PSEIDX01", u32 file count, u32 row count
+		per file: u16 path length, path, i64 mtime (ns), u64 size, u8 version, u8 name length, trainer name (UTF-8),
+		          u16 trainer id, u16 secret id, u32 play time (s), u32 first row, u32 row count
+		columns: file (u32), box (u8, 0 = party), slot (u8), species (u16), ability (u8), move 1 - 4 (u16 each),
+		         IVs (u32), OT id (u16), OT secret id (u16), shiny (u8)
+*/
 
+#define indexMagic "PSEIDX01"
+
+struct IndexedFile {
+	string path;
+	int64_t mtime;
+	uint64_t size;
+	int version;
+	string trainerName;
+	uint16_t tid;
+	uint16_t sid;
+	uint32_t playTime;
+	uint32_t firstRow;
+	uint32_t rowCount;
+};
 
-	// Update pokemon ability
-	if(block == 1){
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[ability] ] = id;
+struct PokemonIndex {
+	vector<IndexedFile> files;
+	vector<uint32_t> file;
+	vector<uint8_t> box;
+	vector<uint8_t> slot;
+	vector<uint16_t> species;
+	vector<uint8_t> abilities;
+	array<vector<uint16_t>, 4> moves;
+	vector<uint32_t> ivs;
+	vector<uint16_t> otId;
+	vector<uint16_t> otSecretId;
+	vector<uint8_t> shiny;
+
+	size_t rows() const { return species.size(); }
+
+	void addRow(uint32_t fileIndex, int boxNumber, int slotNumber, const PokemonRecord& mon){
+		file.push_back(fileIndex);
+		box.push_back(boxNumber);
+		slot.push_back(slotNumber);
+		species.push_back(mon.getSpecies());
+		abilities.push_back(mon.getAbility());
+		for(int m = 0; m < 4; m++){ moves[m].push_back(mon.getMove(m + 1)); }
+		ivs.push_back(mon.getIVs());
+		otId.push_back(mon.getOtId());
+		otSecretId.push_back(mon.getOtSecretId());
+		shiny.push_back(mon.isShiny());
 	}
-	else if(block == 2){
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[ability] ] = id;
-	}
-	else{
-		cout << "Error: could not edit pokemon" << endl;
-		exit(EXIT_FAILURE);
+
+	// Append rows [first, first + count) of 'other', their file column is set to 'fileIndex'
+	void appendRows(const PokemonIndex& other, size_t first, size_t count, uint32_t fileIndex){
+		file.insert(file.end(), count, fileIndex);
+		auto copy = [&](auto& to, const auto& from){ to.insert(to.end(), from.begin() + first, from.begin() + first + count); };
+		copy(box, other.box);
+		copy(slot, other.slot);
+		copy(species, other.species);
+		copy(abilities, other.abilities);
+		for(int m = 0; m < 4; m++){ copy(moves[m], other.moves[m]); }
+		copy(ivs, other.ivs);
+		copy(otId, other.otId);
+		copy(otSecretId, other.otSecretId);
+		copy(shiny, other.shiny);
 	}
+};
 
+// Little endian encoding of index values
+template <typename T>
+void putIndexValue(string& out, T value){
+	for(size_t i = 0; i < sizeof(T); i++){ out.push_back((char)((uint64_t)value >> (8 * i))); }
 }
 
-// Edit the moves of lead pokemon
-void editPokemonMove(vector<unsigned char>& data, string moveName, int moveSlot, vector<int> blockOffsets, int block, int version){
+template <typename T>
+T getIndexValue(const string& in, size_t& pos){
+	if(pos + sizeof(T) > in.size()){
+		throw SaveError(SaveErrorCode::invalidSave, "index file is truncated");
+	}
+	uint64_t value = 0;
+	for(size_t i = 0; i < sizeof(T); i++){ value |= (uint64_t)(unsigned char)in[pos + i] << (8 * i); }
+	pos += sizeof(T);
+	return (T)value;
+}
 
-	int moveSlotOffset = -1;
+template <typename T>
+void putIndexColumn(string& out, const vector<T>& column){
+	for(T value : column){ putIndexValue(out, value); }
+}
 
-	// Make sure the value of 'moveSlot' is valid
-	if(moveSlot == 1 || moveSlot == 2 || moveSlot == 3 || moveSlot == 4){
+template <typename T>
+void getIndexColumn(const string& in, size_t& pos, vector<T>& column, size_t rows){
+	column.resize(rows);
+	for(T& value : column){ value = getIndexValue<T>(in, pos); }
+}
 
-		// Since each move is 2 bytes of memory the value of 'moveSlot' is adjusted to it can be used more intuitively
-		moveSlotOffset = moveSlot*2 - 2;
-	}
-	else{
-		cout << "Error: could not edit pokemon" << endl;
-		exit(EXIT_FAILURE);
+// Write 'index' to 'path', a temporary file is renamed over the old index so readers never see half of it
+void saveIndex(const PokemonIndex& index, const string& path){
+	string out = indexMagic;
+	putIndexValue<uint32_t>(out, index.files.size());
+	putIndexValue<uint32_t>(out, index.rows());
+
+	for(const IndexedFile& f : index.files){
+		putIndexValue<uint16_t>(out, f.path.size());
+		out += f.path;
+		putIndexValue<int64_t>(out, f.mtime);
+		putIndexValue<uint64_t>(out, f.size);
+		putIndexValue<uint8_t>(out, f.version);
+		putIndexValue<uint8_t>(out, f.trainerName.size());
+		out += f.trainerName;
+		putIndexValue(out, f.tid);
+		putIndexValue(out, f.sid);
+		putIndexValue(out, f.playTime);
+		putIndexValue(out, f.firstRow);
+		putIndexValue(out, f.rowCount);
 	}
 
-	// Get Move ID and PP amount for given 'moveName'
+	putIndexColumn(out, index.file);
+	putIndexColumn(out, index.box);
+	putIndexColumn(out, index.slot);
+	putIndexColumn(out, index.species);
+	putIndexColumn(out, index.abilities);
+	for(int m = 0; m < 4; m++){ putIndexColumn(out, index.moves[m]); }
+	putIndexColumn(out, index.ivs);
+	putIndexColumn(out, index.otId);
+	putIndexColumn(out, index.otSecretId);
+	putIndexColumn(out, index.shiny);
+
+	string temp = path + ".tmp";
+	{
+		ofstream file(temp, ios::binary | ios::trunc);
+		if(!file.write(out.data(), out.size())){
+			throw SaveError(SaveErrorCode::fileError, "could not write index file '" + temp + "'");
+		}
+	}
+	if(rename(temp.c_str(), path.c_str()) != 0){
+		throw SaveError(SaveErrorCode::fileError, "could not write index file '" + path + "'");
+	}
+}
 
-	map<string, int> moveMap = { {"Pound", 291,},{"Karate Chop", 537,},{"Double Slap", 778,},{"Comet Punch", 1039,},{"Mega Punch", 1300,},{"Pay Day", 1556,},{"Fire Punch", 1807,},{"Ice Punch", 2063,},{"Thunder Punch", 2319,},{"Scratch", 2595,},{"Vise Grip", 2846,},{"Guillotine", 3077,},{"Razor Wind", 3338,},{"Swords Dance", 3604,},{"Cut", 3870,},{"Gust", 4131,},{"Wing Attack", 4387,},{"Whirlwind", 4628,},{"Fly", 4879,},{"Bind", 5140,},{"Slam", 5396,},{"Vine", 5657,},{"Stomp", 5908,},{"Double Kick", 6174,},{"Mega Kick", 6405,},{"Jump Kick", 6666,},{"Rolling Kick", 6927,},{"Sand Attack", 7183,},{"Headbutt", 7439,},{"Horn Attack", 7705,},{"Fury Attack", 7956,},{"Horn Drill", 8197,},{"Tackle", 8483,},{"Body Slam", 8719,},{"Wrap", 8980,},{"Take Down", 9236,},{"Thrash", 9482,},{"Double-Edge", 9743,},{"Tail Whip", 10014,},{"Poison Sting", 10275,},{"Twineedle", 10516,},{"Pin Missile", 10772,},{"Leer", 11038,},{"Bite", 11289,},{"Growl", 11560,},{"Roar", 11796,},{"Sing", 12047,},{"Supersonic", 12308,},{"Sonic Boom", 12564,},{"Disable", 12820,},{"Acid", 13086,},{"Ember", 13337,},{"Flamethrower", 13583,},{"Mist", 13854,},{"Water Gun", 14105,},{"Hydro Pump", 14341,},{"Surf", 14607,},{"Ice Beam", 14858,},{"Blizzard", 15109,},{"Psybeam", 15380,},{"Bubble Beam", 15636,},{"Aurora Beam", 15892,},{"Hyper Beam", 16133,},{"Peck", 16419,},{"Drill Peck", 16660,},{"Submission", 16916,},{"Low Kick", 17172,},{"Counter", 17428,},{"Seismic Toss", 17684,},{"Strength", 17935,},{"Absorb", 18181,},{"Mega Drain", 18447,},{"Leech Seed", 18698,},{"Growth", 18964,},{"Razor Leaf", 19225,},{"Solar Beam", 19466,},{"Poison Powder", 19747,},{"Stun Spore", 19998,},{"Sleep Powder", 20239,},{"Petal Dance", 20490,},{"String Shot", 20776,},{"Dragon Rage", 21002,},{"Fire Spin", 21263,},{"Thunder Shock", 21534,},{"Thunderbolt", 21775,},{"Thunder Wave", 22036,},{"Thunder", 22282,},{"Rock Throw", 22543,},{"Earthquake", 22794,},{"Fissure", 23045,},{"Dig", 23306,},{"Toxic", 23562,},{"Confusion", 23833,},{"Psychic", 24074,},{"Hypnosis", 24340,},{"Meditate", 24616,},{"Agility", 24862,},{"Quick Attack", 25118,},{"Rage", 25364,},{"Teleport", 25620,},{"Night Shade", 25871,},{"Mimic", 26122,},{"Screech", 26408,},{"Double Team", 26639,},{"Recover", 26890,},{"Harden", 27166,},{"Minimize", 27402,},{"Smokescreen", 27668,},{"Confuse Ray", 27914,},{"Withdraw", 28200,},{"Defense Curl", 28456,},{"Barrier", 28692,},{"Light Screen", 28958,},{"Haze", 29214,},{"Reflect", 29460,},{"Focus Energy", 29726,},{"Bide", 29962,},{"Metronome", 30218,},{"Mirror Move", 30484,},{"Self-Destruct", 30725,},{"Egg Bomb", 30986,},{"Lick", 31262,},{"Smog", 31508,},{"Sludge", 31764,},{"Bone Club", 32020,},{"Fire Blast", 32261,},{"Waterfall", 32527,},{"Clamp", 32783,},{"Swift", 33044,},{"Skull Bash", 33290,},{"Spike Cannon", 33551,},{"Constrict", 33827,},{"Amnesia", 34068,},{"Kinesis", 34319,},{"Soft-Boiled", 34570,},{"High Jump Kick", 34826,},{"Glare", 35102,},{"Dream Eater", 35343,},{"Poison Gas", 35624,},{"Barrage", 35860,},{"Leech Life", 36106,},{"Lovely Kiss", 36362,},{"Sky Attack", 36613,},{"Transform", 36874,},{"Bubble", 37150,},{"Dizzy Punch", 37386,},{"Spore", 37647,},{"Flash", 37908,},{"Psywave", 38159,},{"Splash", 38440,},{"Acid Armor", 38676,},{"Crabhammer", 38922,},{"Explosion", 39173,},{"Fury Swipes", 39439,},{"Bonemerang", 39690,},{"Rest", 39946,},{"Rock Slide", 40202,},{"Hyper Fang", 40463,},{"Sharpen", 40734,},{"Conversion", 40990,},{"Tri Attack", 41226,},{"Super Fang", 41482,},{"Slash", 41748,},{"Substitute", 41994,},{"Struggle", 42241,},{"Sketch", 42497,},{"Triple Kick", 42762,},{"Thief", 43033,},{"Spider Web", 43274,},{"Mind Reader", 43525,},{"Nightmare", 43791,},{"Flame Wheel", 44057,},{"Snore", 44303,},{"Curse", 44554,},{"Flail", 44815,},{"Conversion 2", 45086,},{"Aeroblast", 45317,},{"Cotton Spore", 45608,},{"Reversal", 45839,},{"Spite", 46090,},{"Powder Snow", 46361,},{"Protect", 46602,},{"Mach Punch", 46878,},{"Scary Face", 47114,},{"Feint Attack", 47380,},{"Sweet Kiss", 47626,},{"Belly Drum", 47882,},{"Sludge Bomb", 48138,},{"Mud-Slap", 48394,},{"Octazooka", 48650,},{"Spikes", 48916,},{"Zap Cannon", 49157,},{"Foresight", 49448,},{"Destiny Bond", 49669,},{"Perish Song", 49925,},{"Icy Wind", 50191,},{"Detect", 50437,},{"Bone Rush", 50698,},{"Lock-On", 50949,},{"Outrage", 51210,},{"Sandstorm", 51466,},{"Giga Drain", 51722,},{"Endure", 51978,},{"Charm", 52244,},{"Rollout", 52500,},{"False Swipe", 52776,},{"Swagger", 53007,},{"Milk Drink", 53258,},{"Spark", 53524,},{"Fury Cutter", 53780,},{"Steel Wing", 54041,},{"Mean Look", 54277,},{"Attract", 54543,},{"Sleep Talk", 54794,},{"Heal Bell", 55045,},{"Return", 55316,},{"Present", 55567,},{"Frustration", 55828,},{"Safeguard", 56089,},{"Pain Split", 56340,},{"Sacred Fire", 56581,},{"Magnitude", 56862,},{"Dynamic Punch", 57093,},{"Megahorn", 57354,},{"Dragon Breath", 57620,},{"Baton Pass", 57896,},{"Encore", 58117,},{"Pursuit", 58388,},{"Rapid Spin", 58664,},{"Sweet Scent", 58900,},{"Iron Tail", 59151,},{"Metal Claw", 59427,},{"Vital Throw", 59658,},{"Morning Sun", 59909,},{"Synthesis", 60165,},{"Moonlight", 60421,},{"Hidden Power", 60687,},{"Cross Chop", 60933,},{"Twister", 61204,},{"Rain Dance", 61445,},{"Sunny Day", 61701,},{"Crunch", 61967,},{"Mirror Coat", 62228,},{"Psych Up", 62474,},{"Extreme Speed", 62725,},{"Ancient Power", 62981,},{"Shadow Ball", 63247,},{"Future Sight", 63498,},{"Rock Smash", 63759,},{"Whirlpool", 64015,},{"Beat Up", 64266,},{"Fake Out", 64522,},{"Uproar", 64778,},{"Stockpile", 65044,},{"Spit Up", 65290,},{"Swallow", 65546,},{"Heat Wave", 65802,},{"Hail", 66058,},{"Torment", 66319,},{"Flatter", 66575,},{"Will-O-Wisp", 66831,},{"Memento", 67082,},{"Facade", 67348,},{"Focus Punch", 67604,},{"Smelling Salts", 67850,},{"Follow Me", 68116,},{"Nature Power", 68372,},{"Charge", 68628,},{"Taunt", 68884,},{"Helping Hand", 69140,},{"Trick", 69386,},{"Role Play", 69642,},{"Wish", 69898,},{"Assist", 70164,},{"Ingrain", 70420,},{"Superpower", 70661,},{"Magic Coat", 70927,},{"Recycle", 71178,},{"Revenge", 71434,},{"Brick Break", 71695,},{"Yawn", 71946,},{"Knock Off", 72212,},{"Endeavor", 72453,},{"Eruption", 72709,},{"Skill Swap", 72970,},{"Imprison", 73226,},{"Refresh", 73492,},{"Grudge", 73733,},{"Snatch", 73994,},{"Secret Power", 74260,},{"Dive", 74506,},{"Arm Thrust", 74772,},{"Camouflage", 75028,},{"Tail Glow", 75284,},{"Luster Purge", 75525,},{"Mist Ball", 75781,},{"Feather Dance", 76047,},{"Teeter Dance", 76308,},{"Blaze Kick", 76554,},{"Mud Sport", 76815,},{"Ice Ball", 77076,},{"Needle Arm", 77327,},{"Slack Off", 77578,},{"Hyper Voice", 77834,},{"Poison Fang", 78095,},{"Crush Claw", 78346,},{"Blast Burn", 78597,},{"Hydro Cannon", 78853,},{"Meteor Mash", 79114,},{"Astonish", 79375,},{"Weather Ball", 79626,},{"Aromatherapy", 79877,},{"Fake Tears", 80148,},{"Air Cutter", 80409,},{"Overheat", 80645,},{"Odor Sleuth", 80936,},{"Rock Tomb", 81167,},{"Silver Wind", 81413,},{"Metal Sound", 81704,},{"Grass Whistle", 81935,},{"Tickle", 82196,},{"Cosmic Power", 82452,},{"Water Spout", 82693,},{"Signal Beam", 82959,},{"Shadow Punch", 83220,},{"Extrasensory", 83476,},{"Sky Uppercut", 83727,},{"Sand Tomb", 83983,},{"Sheer Cold", 84229,},{"Muddy Water", 84490,},{"Bullet Seed", 84766,},{"Aerial Ace", 85012,},{"Icicle Spear", 85278,},{"Iron Defense", 85519,},{"Block", 85765,},{"Howl", 86056,},{"Dragon Claw", 86287,},{"Frenzy Plant", 86533,},{"Bulk Up", 86804,},{"Bounce", 87045,},{"Mud Shot", 87311,},{"Poison Tail", 87577,},{"Covet", 87833,},{"Volt Tackle", 88079,},{"Magical Leaf", 88340,},{"Water Sport", 88591,},{"Calm Mind", 88852,},{"Leaf Blade", 89103,},{"Dragon Dance", 89364,},{"Rock Blast", 89610,},{"Shock Wave", 89876,},{"Water Pulse", 90132,},{"Doom Desire", 90373,},{"Psycho Boost", 90629,},{"Roost", 90890,},{"Gravity", 91141,},{"Miracle Eye", 91432,},{"Wake-Up Slap", 91658,},{"Hammer Arm", 91914,},{"Gyro Ball", 92165,},{"Healing Wish", 92426,},{"Brine", 92682,},{"Natural Gift", 92943,},{"Feint", 93194,},{"Pluck", 93460,},{"Tailwind", 93711,},{"Acupressure", 93982,},{"Metal Burst", 94218,},{"U-turn", 94484,},{"Close Combat", 94725,},{"Payback", 94986,},{"Assurance", 95242,},{"Embargo", 95503,},{"Fling", 95754,},{"Psycho Shift", 96010,},{"Trump Card", 96261,},{"Heal Block", 96527,},{"Wring Out", 96773,},{"Power Trick", 97034,},{"Gastro Acid", 97290,},{"Lucky Chant", 97566,},{"Me First", 97812,},{"Copycat", 98068,},{"Power Swap", 98314,},{"Guard Swap", 98570,},{"Punishment", 98821,},{"Last Resort", 99077,},{"Worry Seed", 99338,},{"Sucker Punch", 99589,},{"Toxic Spikes", 99860,},{"Heart Swap", 100106,},{"Aqua Ring", 100372,},{"Magnet Rise", 100618,},{"Flare Blitz", 100879,},{"Force Palm", 101130,},{"Aura Sphere", 101396,},{"Rock Polish", 101652,},{"Poison Jab", 101908,},{"Dark Pulse", 102159,},{"Night Slash", 102415,},{"Aqua Tail", 102666,},{"Seed Bomb", 102927,},{"Air Slash", 103183,},{"X-Scissor", 103439,},{"Bug Buzz", 103690,},{"Dragon Pulse", 103946,},{"Dragon Rush", 104202,},{"Power Gem", 104468,},{"Drain Punch", 104714,},{"Vacuum Wave", 104990,},{"Focus Blast", 105221,},{"Energy Ball", 105482,},{"Brave Bird", 105743,},{"Earth Power", 105994,},{"Switcheroo", 106250,},{"Giga Impact", 106501,},{"Nasty Plot", 106772,},{"Bullet Punch", 107038,},{"Avalanche", 107274,},{"Ice Shard", 107550,},{"Shadow Claw", 107791,},{"Thunder Fang", 108047,},{"Ice Fang", 108303,},{"Fire Fang", 108559,},{"Shadow Sneak", 108830,},{"Mud Bomb", 109066,},{"Psycho Cut", 109332,},{"Zen Headbutt", 109583,},{"Mirror Shot", 109834,},{"Flash Cannon", 110090,},{"Rock Climb", 110356,},{"Defog", 110607,},{"Trick Room", 110853,},{"Draco Meteor", 111109,},{"Discharge", 111375,},{"Lava Plume", 111631,},{"Leaf Storm", 111877,},{"Power Whip", 112138,},{"Rock Wrecker", 112389,},{"Cross Poison", 112660,},{"Gunk Shot", 112901,},{"Iron Head", 113167,},{"Magnet Bomb", 113428,},{"Stone Edge", 113669,},{"Captivate", 113940,},{"Stealth Rock", 114196,},{"Grass Knot", 114452,},{"Chatter", 114708,},{"Judgment", 114954,},{"Bug Bite", 115220,},{"Charge Beam", 115466,},{"Wood Hammer", 115727,},{"Aqua Jet", 115988,},{"Attack Order", 116239,},{"Defend Order", 116490,},{"Heal Order", 116746,},{"Head Smash", 116997,},{"Double Hit", 117258,},{"Roar of Time", 117509,},{"Spacial Rend", 117765,},{"Lunar Dance", 118026,},{"Crush Grip", 118277,},{"Magma Storm", 118533,},{"Dark Void", 118794,},{"Seed Flare", 119045,},{"Ominous Wind", 119301,},{"Shadow Force", 119557,}  };
-	int id = moveMap[moveName];
-	int pp = moveMap[moveName];
-	if(!id){
-		cout << "Error: invalid Move name" << endl;
-		exit(EXIT_FAILURE);
+// Read an index written by saveIndex
+PokemonIndex loadIndex(const string& path){
+	ifstream file(path, ios::binary);
+	if(!file){
+		throw SaveError(SaveErrorCode::fileError, "could not read index file '" + path + "'");
 	}
-	else{
-		id = moveMap[moveName] >> 8;
-		pp = moveMap[moveName] & 0xff;
+	string in((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	if(in.compare(0, strlen(indexMagic), indexMagic) != 0){
+		throw SaveError(SaveErrorCode::invalidSave, "'" + path + "' is not an index file");
 	}
 
-	// Update pokemon move for given slot
-	if(block == 1){
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[moveset] + moveSlotOffset] = id & 0xff;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[moveset] + moveSlotOffset + 1] = id >> 8;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[movePP] + moveSlot] = pp;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[movePP] + moveSlot + 1] = pp;
+	PokemonIndex index;
+	size_t pos = strlen(indexMagic);
+	uint32_t fileCount = getIndexValue<uint32_t>(in, pos);
+	uint32_t rows = getIndexValue<uint32_t>(in, pos);
+
+	for(uint32_t i = 0; i < fileCount; i++){
+		IndexedFile f;
+		size_t length = getIndexValue<uint16_t>(in, pos);
+		f.path = in.substr(pos, length); pos += length;
+		f.mtime = getIndexValue<int64_t>(in, pos);
+		f.size = getIndexValue<uint64_t>(in, pos);
+		f.version = getIndexValue<uint8_t>(in, pos);
+		length = getIndexValue<uint8_t>(in, pos);
+		f.trainerName = in.substr(pos, length); pos += length;
+		f.tid = getIndexValue<uint16_t>(in, pos);
+		f.sid = getIndexValue<uint16_t>(in, pos);
+		f.playTime = getIndexValue<uint32_t>(in, pos);
+		f.firstRow = getIndexValue<uint32_t>(in, pos);
+		f.rowCount = getIndexValue<uint32_t>(in, pos);
+		if(pos > in.size() || (uint64_t)f.firstRow + f.rowCount > rows){
+			throw SaveError(SaveErrorCode::invalidSave, "index file is corrupted");
+		}
+		index.files.push_back(f);
 	}
-	else if(block == 2){
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[moveset] + moveSlotOffset] = id & 0xff;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[moveset] + moveSlotOffset + 1] = id >> 8;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[movePP] + moveSlot] = pp;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[1] + pokemon[movePP] + moveSlot + 1] = pp;
+
+	getIndexColumn(in, pos, index.file, rows);
+	// Queries index the file table with the file column, every row has to point at a file whose row range holds it
+	for(uint32_t row = 0; row < rows; row++){
+		if(index.file[row] >= index.files.size()){
+			throw SaveError(SaveErrorCode::invalidSave, "index file is corrupted");
+		}
 	}
-	else{
-		cout << "Error: could not edit pokemon" << endl;
-		exit(EXIT_FAILURE);
+	for(size_t i = 0; i < index.files.size(); i++){
+		const IndexedFile& f = index.files[i];
+		for(uint32_t row = f.firstRow; row < f.firstRow + f.rowCount; row++){
+			if(index.file[row] != i){
+				throw SaveError(SaveErrorCode::invalidSave, "index file is corrupted");
+			}
+		}
 	}
+	getIndexColumn(in, pos, index.box, rows);
+	getIndexColumn(in, pos, index.slot, rows);
+	getIndexColumn(in, pos, index.species, rows);
+	getIndexColumn(in, pos, index.abilities, rows);
+	for(int m = 0; m < 4; m++){ getIndexColumn(in, pos, index.moves[m], rows); }
+	getIndexColumn(in, pos, index.ivs, rows);
+	getIndexColumn(in, pos, index.otId, rows);
+	getIndexColumn(in, pos, index.otSecretId, rows);
+	getIndexColumn(in, pos, index.shiny, rows);
+	return index;
 }
 
-// Make lead pokemon shiny
-void makePokemonShiny(vector<unsigned char>& data, vector<int> blockOffsets, int block, int version){
-
-	int pv;
-	if(block == 1){
+// Size and modification time (ns) of a file, returns false if it can't be read
+bool getFileStamp(const string& path, int64_t& mtime, uint64_t& size){
+	struct stat info;
+	if(stat(path.c_str(), &info) != 0){ return false; }
+	mtime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+	size = info.st_size;
+	return true;
+}
 
-		// Get the personality value for the pokemon
-		pv = data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]];
-		pv += (data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]+1] << 8);
-		pv += (data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]+2] << 16);
-		pv += (data[smallBlock1 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]+3] << 24);
+// Decode the trainer data, party and boxes of one save file into 'rows' (file column 0)
+IndexedFile indexSaveFile(const string& path, int version, PokemonIndex& rows){
+	IndexedFile entry = {path, 0, 0, version, "", 0, 0, 0, 0, 0};
+	if(!getFileStamp(path, entry.mtime, entry.size)){
+		throw SaveError(SaveErrorCode::fileError, "could not read file");
+	}
 
-		// Edit Pokemon OTID and SecretID to lower and upper bytes of pv
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otid]] = pv;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otid]+1] = (pv >> 8) & 0xff;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otSecretID]] = (pv >> 16) & 0xff;
-		data[smallBlock1 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otSecretID]+1] = pv >> 24;
+	SaveBuffer data;
+	readFile(path.c_str(), data, true);
+	int block = getCurBlock(data, version);
+	size_t blockOffset = getSmallBlockOffset(block);
+
+	withVersionLayout(version, [&](auto layout){
+		char name[trainerNameChars * 4 + 1];
+		decodeGameText(data.view(layout.trainerName(blockOffset), trainerNameChars * 2).data(), trainerNameChars, name, sizeof(name));
+		entry.trainerName = name;
+		entry.tid = data[layout.trainerIdPos(blockOffset)] | (data[layout.trainerIdPos(blockOffset) + 1] << 8);
+		entry.sid = data[layout.secretIdPos(blockOffset)] | (data[layout.secretIdPos(blockOffset) + 1] << 8);
+		const unsigned char* time = data.view(layout.playTime(blockOffset), 4).data();
+		entry.playTime = (time[0] | (time[1] << 8)) * 3600 + time[2] * 60 + time[3];
+	});
+
+	Party party(data, block, version);
+	for(int slot = 0; slot < party.count(); slot++){
+		PokemonRecord mon = party.at(slot);
+		if(mon.getSpecies()){ rows.addRow(0, 0, slot, mon); }
+	}
 
+	BoxStorage boxes(data, version);
+	for(int box = 0; box < boxCount; box++){
+		for(int slot = 0; slot < boxSlotCount; slot++){
+			if(boxes.isEmpty(box, slot)){ continue; }
+			PokemonRecord mon = boxes.at(box, slot);
+			if(mon.getSpecies()){ rows.addRow(0, box + 1, slot, mon); }
+		}
 	}
-	else if(block == 2){
+	entry.rowCount = rows.rows();
+	return entry;
+}
 
-		// Get the personality value for the pokemon
-		pv = data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]];
-		pv += (data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]+1] << 8);
-		pv += (data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]+2] << 16);
-		pv += (data[smallBlock2 + versionNames[version][leadPokemonOffset] + pokemon[personalityValueOffset]+3] << 24);
+// Entry point for '--index', builds or refreshes the index at 'indexPath' from the save files in 'paths'
+int runIndex(const string& indexPath, int version, const vector<string>& paths, unsigned threads){
+	vector<string> files = collectSaveFiles(paths);
 
-		// Edit Pokemon OTID and SecretID to lower and upper bytes of pv
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otid]] = pv;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otid]+1] = (pv >> 8) & 0xff;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otSecretID]] = (pv >> 16) & 0xff;
-		data[smallBlock2 + versionNames[version][leadPokemonOffset] + blockOffsets[0] + pokemon[otSecretID]+1] = pv >> 24;
+	PokemonIndex old;
+	unordered_map<string, size_t> oldFiles;
+	if(filesystem::exists(indexPath)){
+		old = loadIndex(indexPath);
+		for(size_t i = 0; i < old.files.size(); i++){ oldFiles[old.files[i].path] = i; }
+	}
 
+	// Files that did not change since the last run keep their rows
+	vector<long> reuse(files.size(), -1);
+	for(size_t i = 0; i < files.size(); i++){
+		auto it = oldFiles.find(files[i]);
+		int64_t mtime; uint64_t size;
+		if(it != oldFiles.end() && getFileStamp(files[i], mtime, size)){
+			const IndexedFile& f = old.files[it->second];
+			if(f.mtime == mtime && f.size == size && f.version == version){ reuse[i] = it->second; }
+		}
 	}
-	else{
-		cout << "Error: could not edit pokemon" << endl;
-		exit(EXIT_FAILURE);
+
+	vector<IndexedFile> entries(files.size());
+	vector<PokemonIndex> decoded(files.size());
+	vector<string> errors(files.size());
+	atomic<size_t> decodedCount(0);
+
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		if(reuse[i] >= 0){ return; }
+		try{
+			entries[i] = indexSaveFile(files[i], version, decoded[i]);
+			decodedCount++;
+		}
+		catch(const exception& e){
+			errors[i] = e.what();
+		}
+	});
+
+	// Merge in file order, failed files are left out of the index
+	PokemonIndex index;
+	size_t failed = 0;
+	for(size_t i = 0; i < files.size(); i++){
+		if(!errors[i].empty()){
+			cout << "FAIL " << files[i] << ": " << errors[i] << "\n";
+			failed++;
+			continue;
+		}
+		IndexedFile entry = (reuse[i] >= 0) ? old.files[reuse[i]] : entries[i];
+		const PokemonIndex& source = (reuse[i] >= 0) ? old : decoded[i];
+		size_t first = (reuse[i] >= 0) ? entry.firstRow : 0;
+
+		uint32_t fileIndex = index.files.size();
+		entry.firstRow = index.rows();
+		index.appendRows(source, first, entry.rowCount, fileIndex);
+		index.files.push_back(entry);
 	}
+	saveIndex(index, indexPath);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
+	cout << "Indexed " << index.files.size() << " files (" << decodedCount << " decoded, " << (index.files.size() - decodedCount) << " unchanged, " << failed << " failed), ";
+	cout << index.rows() << " pokemon in " << fixed << setprecision(3) << seconds << " s" << endl;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-// Function that handles the encryption and calls specified pokemon edit function
-void editPokemon(vector<unsigned char>& data, string pokemonName, string abilityName, string moveName, int moveSlot, vector<int> blockOffsets, int block, int version, int option){
-
-    cout << block << endl;
-
-	// Get the current pokemon checksum do decrypt the pokemon data block
-	int curPokemonChecksum = getPokemonChecksum(data, block, version);
+// Single filter of a query, 'field=value' on the command line ('shiny' has no value)
+struct IndexPredicate {
+	string field;
+	string value;
+};
 
-	// Decrypt pokemon data block
-	prng(data, curPokemonChecksum, block, version);
+// Rows of 'index' that match every predicate, in index order
+vector<uint32_t> queryIndex(const PokemonIndex& index, const vector<IndexPredicate>& predicates){
+	vector<uint32_t> selection(index.rows());
+	for(size_t i = 0; i < selection.size(); i++){ selection[i] = i; }
 
+	// Every predicate narrows the selection down, reading only its own column
+	auto filter = [&](auto keep){
+		size_t kept = 0;
+		for(uint32_t row : selection){
+			if(keep(row)){ selection[kept++] = row; }
+		}
+		selection.resize(kept);
+	};
+	auto lookup = [](int id, const IndexPredicate& p){
+		if(!id){ throw SaveError(SaveErrorCode::invalidArgument, "unknown " + p.field + " '" + p.value + "'"); }
+		return id;
+	};
 
-	// Apply changes to pokemon data block
-	switch(option){
-		case 1:
-			// Edit Pokemon Species
-			editPokemonSpecies(data, pokemonName, blockOffsets, block, version);
-			break;
-		case 2:
-			// Edit Pokemon Ability
-			editPokemonAbility(data, abilityName, blockOffsets, block, version);
-			break;
-		case 3:
-			// Edit Pokemon Name
-			editPokemonMove(data, moveName, moveSlot, blockOffsets, block, version);
-			break;
-		case 4:
-			// Make Pokemon Shiny
-			makePokemonShiny(data, blockOffsets, block, version);
-			break;
-		default:
-			cout << "Error: could not edit pokemon" << endl;
-			exit(EXIT_FAILURE);
+	for(const IndexPredicate& p : predicates){
+		if(p.field == "species"){
+			uint16_t id = lookup(getSpeciesID(p.value), p);
+			filter([&](uint32_t row){ return index.species[row] == id; });
+		}
+		else if(p.field == "ability"){
+			uint8_t id = lookup(getAbilityID(p.value), p);
+			filter([&](uint32_t row){ return index.abilities[row] == id; });
+		}
+		else if(p.field == "move"){
+			uint16_t id = lookup(getMoveID(p.value), p);
+			filter([&](uint32_t row){
+				return index.moves[0][row] == id || index.moves[1][row] == id || index.moves[2][row] == id || index.moves[3][row] == id;
+			});
+		}
+		else if(p.field == "shiny"){
+			filter([&](uint32_t row){ return index.shiny[row] != 0; });
+		}
+		else if(p.field == "minivs"){
+			int minimum = atoi(p.value.c_str());
+			filter([&](uint32_t row){
+				for(int stat = 0; stat < 6; stat++){
+					if((int)((index.ivs[row] >> (5 * stat)) & 0x1f) < minimum){ return false; }
+				}
+				return true;
+			});
+		}
+		else if(p.field == "otid"){
+			int id = atoi(p.value.c_str());
+			filter([&](uint32_t row){ return index.otId[row] == id; });
+		}
+		else if(p.field == "trainer" || p.field == "tid"){
+			// File level predicates are evaluated once per file
+			vector<char> match(index.files.size());
+			for(size_t f = 0; f < index.files.size(); f++){
+				match[f] = (p.field == "trainer") ? index.files[f].trainerName == p.value : index.files[f].tid == atoi(p.value.c_str());
+			}
+			filter([&](uint32_t row){ return match[index.file[row]] != 0; });
+		}
+		else{
+			throw SaveError(SaveErrorCode::invalidArgument, "unknown query field '" + p.field + "'");
+		}
 	}
+	return selection;
+}
 
+// Entry point for '--query', prints every matching pokemon
+int runQuery(const string& indexPath, const vector<string>& args){
+	vector<IndexPredicate> predicates;
+	for(const string& arg : args){
+		size_t split = arg.find('=');
+		if(split == string::npos){ predicates.push_back({arg, ""}); }
+		else{ predicates.push_back({arg.substr(0, split), arg.substr(split + 1)}); }
+	}
 
-	// Create chunk of data to calculate new pokemon checksum
-	vector<unsigned char> chunk;
-	if(block == 1){
-		chunk = getSubVector(data, smallBlock1+versionNames[version][leadPokemonOffset]+0x08, smallBlock1+versionNames[version][leadPokemonOffset]+0x88);
-		int newPokemonChecksum = calcPokemonChecksum(chunk);
+	PokemonIndex index = loadIndex(indexPath);
+	auto start = chrono::steady_clock::now();
+	vector<uint32_t> rows = queryIndex(index, predicates);
+	double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+	for(uint32_t row : rows){
+		const IndexedFile& f = index.files[index.file[row]];
+		cout << f.path << ": ";
+		if(index.box[row] == 0){ cout << "Party slot " << index.slot[row] + 1; }
+		else{ cout << "Box " << (int)index.box[row] << " slot " << index.slot[row] + 1; }
+		cout << ", " << getSpeciesName(index.species[row]) << ", " << getAbilityName(index.abilities[row]) << " |";
+		for(int m = 0; m < 4; m++){
+			if(index.moves[m][row]){ cout << " " << getMoveName(index.moves[m][row]); }
+		}
+		if(index.shiny[row]){ cout << " | shiny"; }
+		cout << " | OT " << index.otId[row] << " | trainer " << f.trainerName << " (" << f.tid << ")\n";
+	}
+	cout << rows.size() << " of " << index.rows() << " pokemon in " << index.files.size() << " files match (" << fixed << setprecision(1) << micros << " us)" << endl;
+	return EXIT_SUCCESS;
+}
 
-		// Update pokemon checksum
-		updatePokemonChecksum(data, newPokemonChecksum, block, version);
 
-		// Encrypt pokemon data block
-		prng(data, newPokemonChecksum, block, version);
+// - - - Export Functions - - - //
 
+/* Notes:
+	-> '--export' writes one row per party and PC pokemon of many save files (the current save slot of each) as CSV,
+	   JSON Lines or columns, files are decoded in parallel (one per worker at a time) and mapped read only
+	-> Every file is formatted into an ExportChunk taken from a pool, its buffers keep their capacity when the chunk
+	   is reused, so rows are formatted without allocating
+	-> Chunks are written in the order the files were given unless '--unordered' is set, then a chunk is written as
+	   soon as its file is done (a slow file doesn't hold back the ones after it)
+	-> Columnar format (all values little endian):
+		"PSECOL01", then one row group per file:
+		u16 path length, path, u32 row count, then every column for the rows of that file:
+		box (u8, 0 = party), slot (u8, counted from 1), species (u16), ability (u8), move 1 - 4 (u16 each),
+		PP 1 - 4 (u8 each), IVs (u32, packed like in the record), OT id (u16), OT secret id (u16), shiny (u8),
+		nickname lengths (u8 each), nicknames (UTF-8, back to back)
+*/
 
-		// Update save file checksum
-		vector<unsigned char> tmp = getSubVector(data, smallBlock1, smallBlock1 + versionNames[version][smallBlockChecksumOffset]);
-		int sum =  crc16ccitt(tmp);
-		updateChecksum(data, sum, block, version);
+#define exportCsv 0
+#define exportJsonLines 1
+#define exportColumns 2
+#define exportMagic "PSECOL01"
+
+const char* ivNames[] = { "hp", "atk", "def", "spe", "spa", "spd" };
+
+// Output of one file, reused for the next file once it is written
+struct ExportChunk {
+	string text;
+	size_t rows;
+
+	// Columns (exportColumns only)
+	vector<uint8_t> box, slot, abilities, shiny, nicknameLengths;
+	vector<uint16_t> species, otId, otSecretId;
+	array<vector<uint16_t>, 4> moves;
+	array<vector<uint8_t>, 4> pp;
+	vector<uint32_t> ivs;
+	string nicknames;
+
+	void clear(){
+		text.clear();
+		rows = 0;
+		for(auto* column : {&box, &slot, &abilities, &shiny, &nicknameLengths}){ column->clear(); }
+		for(auto* column : {&species, &otId, &otSecretId}){ column->clear(); }
+		for(int m = 0; m < 4; m++){
+			moves[m].clear();
+			pp[m].clear();
+		}
+		ivs.clear();
+		nicknames.clear();
 	}
-	else if (block == 2){
-		chunk = getSubVector(data, smallBlock2+versionNames[version][leadPokemonOffset]+0x08, smallBlock2+versionNames[version][leadPokemonOffset]+0x88);
-		int newPokemonChecksum = calcPokemonChecksum(chunk);
+};
 
-		// Update pokemon checksum
-		updatePokemonChecksum(data, newPokemonChecksum, block, version);
+void appendNumber(string& out, unsigned value){
+	char digits[12];
+	char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+	out.append(digits, end);
+}
 
-		// Encrypt pokemon data block
-		prng(data, newPokemonChecksum, block, version);
+// Append 's' as a CSV field, quoted only if it has to be
+void appendCsvField(string& out, string_view s){
+	if(s.find_first_of(",\"\n\r") == string_view::npos){
+		out += s;
+		return;
+	}
+	out += '"';
+	for(char c : s){
+		if(c == '"'){ out += '"'; }
+		out += c;
+	}
+	out += '"';
+}
 
+// Append 's' as a JSON string
+void appendJsonString(string& out, string_view s){
+	out += '"';
+	for(char c : s){
+		if(c == '"' || c == '\\'){
+			out += '\\';
+			out += c;
+		}
+		else if((unsigned char)c < 0x20){
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out += escaped;
+		}
+		else{ out += c; }
+	}
+	out += '"';
+}
 
-		// Update save file checksum
-		vector<unsigned char> tmp = getSubVector(data, smallBlock2, smallBlock2 + versionNames[version][smallBlockChecksumOffset]);
-		int sum =  crc16ccitt(tmp);
-		updateChecksum(data, sum, block, version);
+void appendExportHeader(string& out, int format){
+	if(format == exportColumns){
+		out += exportMagic;
+		return;
 	}
-	else{
-		cout << "Error: could not update pokemon checksum" << endl;
-		exit(EXIT_FAILURE);
+	if(format == exportCsv){
+		out += "file,box,slot,species,nickname,ability,move1,move2,move3,move4,pp1,pp2,pp3,pp4";
+		for(const char* iv : ivNames){ out += ",iv_"; out += iv; }
+		out += ",ot_id,ot_secret_id,shiny\n";
 	}
 }
 
+// Append the row of 'mon', 'file' is the path already escaped for the format (unused for columns)
+void appendExportRow(ExportChunk& chunk, int format, string_view file, int box, int slot, const PokemonRecord& mon){
+	char nicknameText[nicknameChars * 4 + 1];
+	size_t nicknameLength = mon.getNickname(nicknameText, sizeof(nicknameText));
+	chunk.rows++;
+
+	if(format == exportColumns){
+		chunk.box.push_back(box);
+		chunk.slot.push_back(slot);
+		chunk.species.push_back(mon.getSpecies());
+		chunk.abilities.push_back(mon.getAbility());
+		for(int m = 0; m < 4; m++){
+			chunk.moves[m].push_back(mon.getMove(m + 1));
+			chunk.pp[m].push_back(mon.getPP(m + 1));
+		}
+		chunk.ivs.push_back(mon.getIVs());
+		chunk.otId.push_back(mon.getOtId());
+		chunk.otSecretId.push_back(mon.getOtSecretId());
+		chunk.shiny.push_back(mon.isShiny());
+		chunk.nicknameLengths.push_back(nicknameLength);
+		chunk.nicknames.append(nicknameText, nicknameLength);
+		return;
+	}
 
-// - - - Menu Handling Functions - - - //
+	string& out = chunk.text;
+	string_view name(nicknameText, nicknameLength);
+	if(format == exportCsv){
+		out += file; out += ',';
+		appendNumber(out, box); out += ',';
+		appendNumber(out, slot); out += ',';
+		appendCsvField(out, getSpeciesName(mon.getSpecies())); out += ',';
+		appendCsvField(out, name); out += ',';
+		appendCsvField(out, getAbilityName(mon.getAbility()));
+		for(int m = 1; m <= 4; m++){ out += ','; appendCsvField(out, getMoveName(mon.getMove(m))); }
+		for(int m = 1; m <= 4; m++){ out += ','; appendNumber(out, mon.getPP(m)); }
+		for(int stat = 0; stat < 6; stat++){ out += ','; appendNumber(out, mon.getIV(stat)); }
+		out += ','; appendNumber(out, mon.getOtId());
+		out += ','; appendNumber(out, mon.getOtSecretId());
+		out += mon.isShiny() ? ",1\n" : ",0\n";
+		return;
+	}
 
-// Prints a menu to the console for user interaction
-void printMenu(string title, vector<string> options){
+	out += "{\"file\":"; out += file;
+	out += ",\"box\":"; appendNumber(out, box);
+	out += ",\"slot\":"; appendNumber(out, slot);
+	out += ",\"species\":"; appendJsonString(out, getSpeciesName(mon.getSpecies()));
+	out += ",\"nickname\":"; appendJsonString(out, name);
+	out += ",\"ability\":"; appendJsonString(out, getAbilityName(mon.getAbility()));
+	out += ",\"moves\":[";
+	for(int m = 1; m <= 4; m++){
+		if(m > 1){ out += ','; }
+		appendJsonString(out, getMoveName(mon.getMove(m)));
+	}
+	out += "],\"pp\":[";
+	for(int m = 1; m <= 4; m++){
+		if(m > 1){ out += ','; }
+		appendNumber(out, mon.getPP(m));
+	}
+	out += "],\"ivs\":{";
+	for(int stat = 0; stat < 6; stat++){
+		out += (stat ? ",\"" : "\""); out += ivNames[stat]; out += "\":";
+		appendNumber(out, mon.getIV(stat));
+	}
+	out += "},\"ot_id\":"; appendNumber(out, mon.getOtId());
+	out += ",\"ot_secret_id\":"; appendNumber(out, mon.getOtSecretId());
+	out += mon.isShiny() ? ",\"shiny\":true}\n" : ",\"shiny\":false}\n";
+}
 
-	unsigned long len = title.size();
+// Move the columns of a file into the chunk text as one row group
+void finishColumnChunk(ExportChunk& chunk, const string& path){
+	string& out = chunk.text;
+	putIndexValue<uint16_t>(out, path.size());
+	out += path;
+	putIndexValue<uint32_t>(out, chunk.rows);
+	putIndexColumn(out, chunk.box);
+	putIndexColumn(out, chunk.slot);
+	putIndexColumn(out, chunk.species);
+	putIndexColumn(out, chunk.abilities);
+	for(int m = 0; m < 4; m++){ putIndexColumn(out, chunk.moves[m]); }
+	for(int m = 0; m < 4; m++){ putIndexColumn(out, chunk.pp[m]); }
+	putIndexColumn(out, chunk.ivs);
+	putIndexColumn(out, chunk.otId);
+	putIndexColumn(out, chunk.otSecretId);
+	putIndexColumn(out, chunk.shiny);
+	putIndexColumn(out, chunk.nicknameLengths);
+	out += chunk.nicknames;
+}
 
-	for(unsigned long i = 0; i < (len + 8); i++){ cout << "-"; } cout << "\n    ";
-	cout << title << endl;
-	for(unsigned long i = 0; i < (len + 8); i++){ cout << "-"; } cout << "\n";
+// Decode the party and boxes of the save at 'path' into 'chunk', returns the size of the save
+size_t exportSaveFile(const string& path, int version, int format, ExportChunk& chunk){
+	SaveBuffer data;
+	readFile(path.c_str(), data, true);
+	version = resolveVersion(data, version);
 
+	string file;
+	if(format == exportCsv){ appendCsvField(file, path); }
+	else if(format == exportJsonLines){ appendJsonString(file, path); }
 
-	for(unsigned long i = 1; i <= options.size(); i++){
-		cout << char(i + 48) << ") " << options[i-1] << endl;
+	int block = getCurBlock(data, version);
+	Party party(data, block, version);
+	for(int slot = 0; slot < party.count(); slot++){
+		PokemonRecord mon = party.at(slot);
+		if(mon.getSpecies()){ appendExportRow(chunk, format, file, 0, slot + 1, mon); }
+	}
+
+	BoxStorage boxes(data, version);
+	for(int box = 0; box < boxCount; box++){
+		for(int slot = 0; slot < boxSlotCount; slot++){
+			if(boxes.isEmpty(box, slot)){ continue; }
+			PokemonRecord mon = boxes.at(box, slot);
+			if(mon.getSpecies()){ appendExportRow(chunk, format, file, box + 1, slot + 1, mon); }
+		}
+	}
+	if(format == exportColumns){ finishColumnChunk(chunk, path); }
+	return data.size();
+}
+
+// Entry point for '--export', rows go to 'outPath' (stdout if empty), the summary to stderr
+int runExport(int format, int version, const vector<string>& paths, const string& outPath, unsigned threads, bool ordered){
+	vector<string> files = collectSaveFiles(paths);
+	if(files.empty()){
+		cerr << "Error: no save files found" << endl;
+		return EXIT_FAILURE;
+	}
+
+	ofstream file;
+	if(!outPath.empty()){
+		file.open(outPath, ios::binary | ios::trunc);
+		if(!file){ throw SaveError(SaveErrorCode::fileError, "could not open '" + outPath + "'"); }
+	}
+	ostream& out = outPath.empty() ? cout : file;
+	string header;
+	appendExportHeader(header, format);
+	out.write(header.data(), header.size());
+
+	// Chunks are only written while holding outputLock, 'pending' holds finished chunks waiting for their turn
+	mutex outputLock;
+	vector<unique_ptr<ExportChunk>> pool;
+	vector<unique_ptr<ExportChunk>> pending(ordered ? files.size() : 0);
+	size_t nextFile = 0;
+	atomic<size_t> rows(0), failed(0);
+	atomic<unsigned long long> bytes(0);
+
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		unique_ptr<ExportChunk> chunk;
+		{
+			lock_guard<mutex> guard(outputLock);
+			if(!pool.empty()){
+				chunk = move(pool.back());
+				pool.pop_back();
+			}
+		}
+		if(!chunk){ chunk = make_unique<ExportChunk>(); }
+		chunk->clear();
+
+		try{
+			bytes += exportSaveFile(files[i], version, format, *chunk);
+			rows += chunk->rows;
+		}
+		catch(const exception& e){
+			chunk->clear();
+			failed++;
+			lock_guard<mutex> guard(outputLock);
+			cerr << "Error: " << files[i] << ": " << e.what() << endl;
+		}
+
+		lock_guard<mutex> guard(outputLock);
+		if(!ordered){
+			out.write(chunk->text.data(), chunk->text.size());
+			pool.push_back(move(chunk));
+			return;
+		}
+		pending[i] = move(chunk);
+		for(; nextFile < files.size() && pending[nextFile]; nextFile++){
+			out.write(pending[nextFile]->text.data(), pending[nextFile]->text.size());
+			pool.push_back(move(pending[nextFile]));
+		}
+	});
+	out.flush();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	if(!out){ throw SaveError(SaveErrorCode::fileError, "could not write the export"); }
+	cerr << "Exported " << rows << " pokemon from " << (files.size() - failed) << " of " << files.size() << " files in " << fixed << setprecision(3) << seconds << " s ("
+		<< setprecision(1) << bytes / (1024.0 * 1024.0) / seconds << " MiB/s of save data)" << endl;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+// - - - PKM Import/Export Functions - - - //
+
+/* Notes:
+	-> '--pkm-export' writes every party and PC pokemon of a save (current save slot) as one .pkm file each, decrypted
+	   unless '--encrypted' is given: party_<slot>_<species>.pkm (236 bytes) and box<box>_<slot>_<species>.pkm (136 bytes)
+	-> '--pkm-import' reads and validates every .pkm file first, the save is not touched if one of them is invalid or
+	   there are not enough free slots. Records go to the free PC slots from box 1 slot 1 on, with '--party' records
+	   with battle stats fill the free party slots first
+	-> Records are placed in the decoded party and PC, commit() encrypts each placed record once and every block
+	   checksum is updated once for the whole import (a full PC of 540 records is one pass over the big block)
+*/
+
+// Read a .pkm file and decode its record, errors name the file
+PkmRecord readPkmFile(const string& path){
+	unsigned char bytes[pokemonPartyRecordSize + 1];
+	ifstream file(path, ios::binary);
+	if(!file){ throw SaveError(SaveErrorCode::fileError, "could not read '" + path + "'"); }
+	file.read((char*)bytes, sizeof(bytes));
+	try{
+		return parsePkm(span<const unsigned char>(bytes, file.gcount()));
+	}
+	catch(const SaveError& e){
+		throw SaveError(e.code(), path + ": " + e.what());
+	}
+}
+
+// Entry point for '--pkm-export'
+int runPkmExport(const string& savePath, int version, const string& outDir, bool encrypted){
+	auto start = chrono::steady_clock::now();
+	SaveBuffer data;
+	readFile(savePath.c_str(), data, true);
+	version = resolveVersion(data, version);
+	int block = getCurBlock(data, version);
+	Party party(data, block, version);
+	BoxStorage boxes(data, version);
+
+	error_code ec;
+	filesystem::create_directories(outDir, ec);
+	if(ec){ throw SaveError(SaveErrorCode::fileError, "could not create '" + outDir + "'"); }
+
+	unsigned char bytes[pokemonPartyRecordSize];
+	char name[64];
+	auto writePkmFile = [&](const unsigned char* decoded, const unsigned char* stats){
+		size_t size = writePkm(decoded, stats, encrypted, bytes);
+		string path = (filesystem::path(outDir) / name).string();
+		ofstream file(path, ios::binary | ios::trunc);
+		if(!file.write((const char*)bytes, size)){
+			throw SaveError(SaveErrorCode::fileError, "could not write '" + path + "'");
+		}
+	};
+
+	size_t partyCount = 0, boxCountWritten = 0;
+	for(int slot = 0; slot < party.count(); slot++){
+		PokemonRecord mon = party.at(slot);
+		if(!mon.getSpecies()){ continue; }
+		snprintf(name, sizeof(name), "party_%d_%s.pkm", slot + 1, string(getSpeciesName(mon.getSpecies())).c_str());
+		writePkmFile(party.decoded(slot), party.getBattleStats(slot));
+		partyCount++;
+	}
+	for(int box = 0; box < boxCount; box++){
+		for(int slot = 0; slot < boxSlotCount; slot++){
+			if(boxes.isEmpty(box, slot)){ continue; }
+			PokemonRecord mon = boxes.at(box, slot);
+			if(!mon.getSpecies()){ continue; }
+			snprintf(name, sizeof(name), "box%02d_%02d_%s.pkm", box + 1, slot + 1, string(getSpeciesName(mon.getSpecies())).c_str());
+			writePkmFile(boxes.decoded(box, slot), nullptr);
+			boxCountWritten++;
+		}
+	}
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "Exported " << partyCount + boxCountWritten << " pokemon (" << partyCount << " from the party, " << boxCountWritten << " from the PC) to "
+		<< outDir << " as " << (encrypted ? "encrypted" : "decrypted") << " .pkm files in " << fixed << setprecision(1) << ms << " ms" << endl;
+	return EXIT_SUCCESS;
+}
+
+// Entry point for '--pkm-import'
+int runPkmImport(const string& savePath, int version, const vector<string>& paths, bool toParty){
+	auto start = chrono::steady_clock::now();
+	vector<string> files = collectFiles(paths, {".pkm"});
+	if(files.empty()){
+		cout << "Error: no .pkm files found" << endl;
+		return EXIT_FAILURE;
+	}
+	vector<PkmRecord> records;
+	records.reserve(files.size());
+	for(const string& file : files){ records.push_back(readPkmFile(file)); }
+
+	SaveBuffer data;
+	readFile(savePath.c_str(), data);
+	version = resolveVersion(data, version);
+	int block = getCurBlock(data, version);
+	Party party(data, block, version);
+	BoxStorage boxes(data, version);
+
+	// Find a slot for every record before changing anything
+	vector<int> placement(records.size()); // Party slot, or partySize + PC slot
+	int nextPartySlot = party.count();
+	size_t nextBoxSlot = 0;
+	for(size_t i = 0; i < records.size(); i++){
+		if(toParty && records[i].hasBattleStats && nextPartySlot < partySize){
+			placement[i] = nextPartySlot++;
+			continue;
+		}
+		while(nextBoxSlot < pcSlotCount && !boxes.isEmpty(nextBoxSlot / boxSlotCount, nextBoxSlot % boxSlotCount)){ nextBoxSlot++; }
+		if(nextBoxSlot == pcSlotCount){
+			throw SaveError(SaveErrorCode::invalidArgument, "not enough free slots for " + to_string(records.size()) + " pokemon");
+		}
+		placement[i] = partySize + nextBoxSlot++;
+	}
+
+	size_t toPartyCount = 0;
+	for(size_t i = 0; i < records.size(); i++){
+		if(placement[i] < partySize){
+			party.set(placement[i], records[i].record, records[i].battleStats);
+			toPartyCount++;
+		}
+		else{
+			int slot = placement[i] - partySize;
+			boxes.set(slot / boxSlotCount, slot % boxSlotCount, records[i].record);
+		}
+	}
+
+	if(party.commit()){ updateSmallBlockChecksum(data, block, version); }
+	boxes.commit();
+	unsigned long long written = writeFile(savePath.c_str(), data);
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "Imported " << records.size() << " pokemon (" << toPartyCount << " to the party, " << records.size() - toPartyCount << " to the PC) in "
+		<< fixed << setprecision(1) << ms << " ms, " << written << " bytes written" << endl;
+	return EXIT_SUCCESS;
+}
+
+
+// - - - Seed Scan Functions - - - //
+
+/* Notes:
+	-> '--scan-seeds' runs findGenerationSeeds on every party and PC pokemon of many save files and flags the ones that
+	   no Method 1/J/K seed produces
+	-> Eggs are skipped, bred, traded-in and event pokemon are not generated by these methods and get flagged as well
+*/
+
+struct SeedScanResult {
+	string report;
+	size_t scanned;
+	size_t flagged;
+};
+
+// Describe one pokemon and where it is stored
+string describeSeedHit(const string& path, int box, int slot, const PokemonRecord& mon){
+	ostringstream out;
+	out << path << ": ";
+	if(box == 0){ out << "Party slot " << slot + 1; }
+	else{ out << "Box " << box << " slot " << slot + 1; }
+	out << ", " << getSpeciesName(mon.getSpecies()) << ", PV 0x" << hex << setw(8) << setfill('0') << mon.getPersonalityValue() << dec << setfill(' ') << ", IVs ";
+	const int displayOrder[] = {0, 1, 2, 4, 5, 3};
+	for(int i = 0; i < 6; i++){ out << (i ? "/" : "") << mon.getIV(displayOrder[i]); }
+	return out.str();
+}
+
+// Check every pokemon of one save file, 'all' also reports the seeds of the pokemon that were not flagged
+SeedScanResult scanSaveSeeds(const string& path, int version, int maxFrames, bool all){
+	SeedScanResult result = {"", 0, 0};
+	SaveBuffer data;
+	readFile(path.c_str(), data, true);
+	int block = getCurBlock(data, version);
+	Party party(data, block, version);
+	BoxStorage boxes(data, version);
+
+	auto check = [&](int box, int slot, PokemonRecord mon){
+		if(!mon.getSpecies() || (mon.getIVs() & (1u << 30))){ return; }
+		result.scanned++;
+		vector<SeedHit> hits = findGenerationSeeds(mon.getPersonalityValue(), mon.getIVs(), version, maxFrames);
+		if(hits.empty()){
+			result.flagged++;
+			result.report += "FLAG " + describeSeedHit(path, box, slot, mon) + ": no Method 1/" + (version == heartgold ? "K" : "J") + " seed\n";
+			return;
+		}
+		if(!all){ return; }
+		ostringstream out;
+		out << "OK   " << describeSeedHit(path, box, slot, mon) << ":";
+		for(const SeedHit& hit : hits){
+			out << " " << methodNames[hit.method] << " seed 0x" << hex << setw(8) << setfill('0') << hit.originSeed << dec << setfill(' ');
+			if(hit.frame >= 0){ out << " (frame " << hit.frame << " from 0x" << hex << setw(8) << setfill('0') << hit.initialSeed << dec << setfill(' ') << ")"; }
+			out << ";";
+		}
+		result.report += out.str() + "\n";
+	};
+
+	for(int slot = 0; slot < party.count(); slot++){ check(0, slot, party.at(slot)); }
+	for(int box = 0; box < boxCount; box++){
+		for(int slot = 0; slot < boxSlotCount; slot++){
+			if(!boxes.isEmpty(box, slot)){ check(box + 1, slot, boxes.at(box, slot)); }
+		}
+	}
+	return result;
+}
+
+// Entry point for '--scan-seeds'
+int runSeedScan(int version, const vector<string>& paths, unsigned threads, int maxFrames, bool all){
+	vector<string> files = collectSaveFiles(paths);
+	if(files.empty()){
+		cout << "Error: no save files found" << endl;
+		return EXIT_FAILURE;
+	}
+
+	mutex outputLock;
+	atomic<size_t> scanned(0), flagged(0), failed(0);
+	auto start = chrono::steady_clock::now();
+	runWorkStealing(files.size(), threads, [&](size_t i){
+		try{
+			SeedScanResult result = scanSaveSeeds(files[i], version, maxFrames, all);
+			scanned += result.scanned;
+			flagged += result.flagged;
+			lock_guard<mutex> guard(outputLock);
+			cout << result.report;
+		}
+		catch(const exception& e){
+			failed++;
+			lock_guard<mutex> guard(outputLock);
+			cout << "FAIL " << files[i] << ": " << e.what() << "\n";
+		}
+	});
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "-------------------------------\n";
+	cout << "Scanned " << scanned << " pokemon in " << files.size() << " files (" << failed << " failed), " << flagged << " flagged in " << fixed << setprecision(3) << seconds << " s" << endl;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+// - - - Edit Daemon Functions - - - //
+
+/* Notes:
+	-> '--serve' keeps recently used saves opened and decoded (current block, party and PC boxes) in an LRU cache
+	   bounded by '--cache-mb', and answers requests on a Unix domain socket, so a hot save is edited without
+	   starting a process or parsing the file again
+	-> Requests and responses are frames like in pipeline mode (4 byte little endian length, then the payload).
+	   A request is a line '<command> <VersionName> <path>', for 'edit' followed by edit script lines (batch mode format).
+	   The response starts with a line 'ok' or 'error <message>', followed by the result. Commands:
+		info, party, boxes: query the save
+		edit: apply the edit script and write the save back (only the modified bytes)
+		evict <path>: drop the save from the cache
+		stats: cache statistics
+	-> Every cached save has a reader/writer lock: queries of a save run concurrently, edits of a save are serialised.
+	   A save is reloaded in place (under its write lock) when its file changed on disk, so there is never more than
+	   one open SaveBuffer per file; saves that are in use are not evicted
+	-> '--jobs' workers accept connections, a connection can send any number of requests
+*/
+
+#define daemonMaxRequest (1u << 20)
+
+struct CachedSave {
+	shared_mutex lock;
+	bool loaded = false;
+	int version = -1;
+	int block = 0;
+	int64_t mtime = 0;
+	uint64_t size = 0;
+	size_t cost = 0; // Bytes charged to the cache, guarded by the cache lock
+	SaveBuffer data;
+	optional<Party> party;
+	optional<BoxStorage> boxes;
+};
+
+struct SaveCache {
+	struct Slot {
+		shared_ptr<CachedSave> save;
+		list<string>::iterator lru;
+	};
+
+	mutex lock;
+	unordered_map<string, Slot> saves;
+	list<string> order; // Most recently used first
+	size_t bytes = 0;
+	size_t limit;
+	size_t hits = 0, misses = 0, evictions = 0;
+
+	// Entry for 'path', created empty if it isn't cached, saves nobody uses are evicted down to the limit
+	shared_ptr<CachedSave> acquire(const string& path){
+		lock_guard<mutex> guard(lock);
+		auto it = saves.find(path);
+		if(it == saves.end()){
+			order.push_front(path);
+			it = saves.emplace(path, Slot{make_shared<CachedSave>(), order.begin()}).first;
+		}
+		else{
+			order.splice(order.begin(), order, it->second.lru);
+		}
+		shared_ptr<CachedSave> save = it->second.save;
+		shrink();
+		return save;
+	}
+
+	// Evict from the least recently used end, skipping saves that are in use (also referenced outside the cache)
+	void shrink(){
+		for(auto it = order.end(); bytes > limit && it != order.begin(); ){
+			--it;
+			Slot& slot = saves[*it];
+			if(slot.save.use_count() > 1){ continue; }
+			bytes -= slot.save->cost;
+			evictions++;
+			saves.erase(*it);
+			it = order.erase(it);
+		}
+	}
+
+	void charge(CachedSave& save, size_t cost){
+		lock_guard<mutex> guard(lock);
+		bytes = bytes - save.cost + cost;
+		save.cost = cost;
+	}
+
+	void count(bool hit){
+		lock_guard<mutex> guard(lock);
+		(hit ? hits : misses)++;
+	}
+
+	bool evict(const string& path){
+		lock_guard<mutex> guard(lock);
+		auto it = saves.find(path);
+		if(it == saves.end() || it->second.save.use_count() > 1){ return false; }
+		bytes -= it->second.save->cost;
+		order.erase(it->second.lru);
+		saves.erase(it);
+		evictions++;
+		return true;
+	}
+};
+
+// (Re)load a cached save from its file, the caller holds its write lock
+void loadCachedSave(SaveCache& cache, CachedSave& save, const string& path, int version, int64_t mtime, uint64_t size){
+	save.loaded = false;
+	save.boxes.reset();
+	save.party.reset();
+	save.data.close();
+	cache.charge(save, 0);
+
+	readFile(path.c_str(), save.data);
+	save.version = version;
+	save.block = getCurBlock(save.data, version);
+	save.party.emplace(save.data, save.block, version);
+	save.boxes.emplace(save.data, version);
+	save.mtime = mtime;
+	save.size = size;
+	save.loaded = true;
+	cache.charge(save, sizeof(CachedSave) + save.data.size() + pcSlotCount * pokemonRecordSize);
+}
+
+// Run 'f' on the decoded save at 'path', with the save's write lock if 'write' is set and its read lock otherwise
+void useCachedSave(SaveCache& cache, const string& path, int version, bool write, const function<void(CachedSave&)>& f){
+	shared_ptr<CachedSave> save = cache.acquire(path);
+	int64_t mtime;
+	uint64_t size;
+	if(!getFileStamp(path, mtime, size)){ throw SaveError(SaveErrorCode::fileError, "could not read file"); }
+
+	if(!write){
+		shared_lock<shared_mutex> reader(save->lock);
+		if(save->loaded && save->version == version && save->mtime == mtime && save->size == size){
+			cache.count(true);
+			f(*save);
+			return;
+		}
+	}
+
+	// The file may have been written by an edit that finished in the meantime, check again under the write lock
+	unique_lock<shared_mutex> writer(save->lock);
+	if(!getFileStamp(path, mtime, size)){ throw SaveError(SaveErrorCode::fileError, "could not read file"); }
+	bool hit = save->loaded && save->version == version && save->mtime == mtime && save->size == size;
+	cache.count(hit);
+	if(!hit){ loadCachedSave(cache, *save, path, version, mtime, size); }
+	f(*save);
+}
+
+// Describe one decoded pokemon on a single line: species, nickname, ability, moves
+string describePokemon(const PokemonRecord& mon){
+	char name[nicknameChars * 4 + 1];
+	mon.getNickname(name, sizeof(name));
+	string line = string(getSpeciesName(mon.getSpecies())) + " '" + name + "', " + string(getAbilityName(mon.getAbility())) + " |";
+	for(int m = 1; m <= 4; m++){
+		if(mon.getMove(m)){ line += " " + string(getMoveName(mon.getMove(m))); }
+	}
+	if(mon.isShiny()){ line += " | shiny"; }
+	return line;
+}
+
+// Answer one request, errors are reported in the response
+string handleDaemonRequest(SaveCache& cache, const string& request){
+	try{
+		size_t lineEnd = request.find('\n');
+		string line = trim(request.substr(0, lineEnd));
+		size_t split = line.find_first_of(" \t");
+		string command = line.substr(0, split);
+		string arg = (split == string::npos) ? "" : trim(line.substr(split));
+
+		if(command == "stats"){
+			lock_guard<mutex> guard(cache.lock);
+			ostringstream out;
+			out << "ok\nsaves " << cache.saves.size() << "\nbytes " << cache.bytes << "\nlimit " << cache.limit << "\nhits " << cache.hits << "\nmisses " << cache.misses << "\nevictions " << cache.evictions << "\n";
+			return out.str();
+		}
+		if(command == "evict"){
+			return cache.evict(arg) ? "ok\n" : "error not cached or in use\n";
+		}
+
+		if(command != "edit" && command != "info" && command != "party" && command != "boxes"){
+			return "error unknown command '" + command + "'\n";
+		}
+		split = arg.find_first_of(" \t");
+		int version = parseVersion(arg.substr(0, split));
+		string path = (split == string::npos) ? "" : trim(arg.substr(split));
+		if(version == -1){ return "error version not found\n"; }
+		if(path.empty()){ return "error missing path\n"; }
+
+		ostringstream out;
+		out << "ok\n";
+		if(command == "edit"){
+			vector<EditOp> ops;
+			istringstream script(lineEnd == string::npos ? "" : request.substr(lineEnd + 1));
+			string scriptLine;
+			EditOp op;
+			while(getline(script, scriptLine)){
+				if(parseEditLine(scriptLine, op)){ ops.push_back(op); }
+			}
+			useCachedSave(cache, path, version, true, [&](CachedSave& save){
+				try{
+					applyEdits(save.data, *save.party, ops, save.block, save.version);
+					out << "written " << save.data.commit() << "\n";
+				}
+				catch(...){
+					// The decoded copies may be half edited, the next request loads the file again
+					save.loaded = false;
+					throw;
+				}
+				getFileStamp(path, save.mtime, save.size);
+			});
+		}
+		else if(command == "info"){
+			useCachedSave(cache, path, version, false, [&](CachedSave& save){
+				// Only the shared lock is held here, the non-const operator[] would mark the bytes dirty
+				const SaveBuffer& saveData = save.data;
+				size_t blockOffset = getSmallBlockOffset(save.block);
+				withVersionLayout(save.version, [&](auto layout){
+					char name[trainerNameChars * 4 + 1];
+					decodeGameText(saveData.view(layout.trainerName(blockOffset), trainerNameChars * 2).data(), trainerNameChars, name, sizeof(name));
+					out << "trainer " << name << "\ntid " << (saveData[layout.trainerIdPos(blockOffset)] | (saveData[layout.trainerIdPos(blockOffset) + 1] << 8));
+					out << "\nsid " << (saveData[layout.secretIdPos(blockOffset)] | (saveData[layout.secretIdPos(blockOffset) + 1] << 8));
+				});
+				out << "\nblock " << save.block << "\nparty " << save.party->count() << "\nboxed " << save.boxes->occupied() << "\n";
+			});
+		}
+		else if(command == "party"){
+			useCachedSave(cache, path, version, false, [&](CachedSave& save){
+				for(int slot = 0; slot < save.party->count(); slot++){
+					out << "Slot " << slot + 1 << ": " << describePokemon(save.party->at(slot)) << "\n";
+				}
+			});
+		}
+		else{
+			useCachedSave(cache, path, version, false, [&](CachedSave& save){
+				for(int box = 0; box < boxCount; box++){
+					for(int slot = 0; slot < boxSlotCount; slot++){
+						if(save.boxes->isEmpty(box, slot)){ continue; }
+						out << "Box " << box + 1 << " Slot " << slot + 1 << ": " << describePokemon(save.boxes->at(box, slot)) << "\n";
+					}
+				}
+			});
+		}
+		return out.str();
+	}
+	catch(const exception& e){
+		return string("error ") + e.what() + "\n";
+	}
+}
+
+// Read one frame, returns false once the other side closed the connection
+bool readFrame(int fd, string& payload){
+	unsigned char header[pipeFrameHeaderSize];
+	size_t got = readFully(fd, header, sizeof(header));
+	if(got == 0){ return false; }
+	if(got != sizeof(header)){ throw SaveError(SaveErrorCode::invalidArgument, "truncated frame header"); }
+	uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+	if(length > daemonMaxRequest){ throw SaveError(SaveErrorCode::invalidArgument, "request is too large"); }
+	payload.resize(length);
+	if(readFully(fd, (unsigned char*)payload.data(), length) != length){ throw SaveError(SaveErrorCode::invalidArgument, "truncated frame"); }
+	return true;
+}
+
+void writeFrame(int fd, const string& payload){
+	unsigned char header[pipeFrameHeaderSize];
+	for(int i = 0; i < pipeFrameHeaderSize; i++){ header[i] = (payload.size() >> (8 * i)) & 0xff; }
+	writeFully(fd, header, sizeof(header));
+	writeFully(fd, (const unsigned char*)payload.data(), payload.size());
+}
+
+// Address of the Unix domain socket at 'socketPath'
+sockaddr_un getSocketAddress(const string& socketPath){
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if(socketPath.size() >= sizeof(address.sun_path)){ throw SaveError(SaveErrorCode::invalidArgument, "socket path is too long"); }
+	memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+	return address;
+}
+
+// Entry point for '--serve', runs until the process is killed
+int runDaemon(const string& socketPath, size_t cacheBytes, unsigned threads){
+	signal(SIGPIPE, SIG_IGN);
+	sockaddr_un address = getSocketAddress(socketPath);
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath.c_str());
+	if(listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0){
+		cout << "Error: could not listen on '" << socketPath << "'" << endl;
+		return EXIT_FAILURE;
+	}
+
+	SaveCache cache;
+	cache.limit = cacheBytes;
+	cout << "Listening on " << socketPath << " (" << threads << " workers, " << (cacheBytes >> 20) << " MB cache)" << endl;
+
+	auto worker = [&](){
+		while(true){
+			int client = accept(listener, nullptr, nullptr);
+			if(client < 0){
+				if(errno == EINTR || errno == ECONNABORTED){ continue; }
+				return;
+			}
+			try{
+				string request;
+				while(readFrame(client, request)){ writeFrame(client, handleDaemonRequest(cache, request)); }
+			}
+			catch(const exception&){
+				// A broken connection only ends that connection
+			}
+			close(client);
+		}
+	};
+	vector<thread> pool;
+	for(unsigned t = 1; t < threads; t++){ pool.emplace_back(worker); }
+	worker();
+	for(thread& t : pool){ t.join(); }
+	close(listener);
+	return EXIT_FAILURE;
+}
+
+// Entry point for '--send': send one request to a daemon and print the response
+int runDaemonRequest(const string& socketPath, const vector<string>& lines){
+	sockaddr_un address = getSocketAddress(socketPath);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0){
+		if(fd >= 0){ close(fd); }
+		cout << "Error: could not connect to '" << socketPath << "'" << endl;
+		return EXIT_FAILURE;
+	}
+
+	string request, response;
+	for(const string& line : lines){ request += line + "\n"; }
+	try{
+		writeFrame(fd, request);
+		if(!readFrame(fd, response)){ throw SaveError(SaveErrorCode::fileError, "no response"); }
+	}
+	catch(const exception& e){
+		close(fd);
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	close(fd);
+	cout << response;
+	return response.compare(0, 3, "ok\n") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// - - - Benchmark Functions - - - //
+
+/* Notes:
+	-> Every benchmark runs its operation in batches until a batch takes at least benchMinTime, the best of benchRepeats
+	   batches is reported (the least disturbed one)
+	-> Results go to the console and, with --json, into a JSON file for regression tracking
+	-> Macro benchmarks work on generated saves, the file benchmark writes to a temporary directory
+*/
+
+#define benchMinTime 0.05
+#define benchRepeats 5
+
+struct BenchResult {
+	string name;
+	unsigned long long iterations;
+	double nsPerOp;
+	size_t bytesPerOp;
+};
+
+// Results have to be used or the compiler may drop the benchmarked code
+volatile uint64_t benchSink;
+
+template <typename F>
+BenchResult runBenchmark(const string& name, size_t bytesPerOp, F&& op){
+	unsigned long long iterations = 1;
+	double best = 1e300;
+	for(int repeat = 0; repeat < benchRepeats; ){
+		auto start = chrono::steady_clock::now();
+		for(unsigned long long i = 0; i < iterations; i++){ op(i); }
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		if(seconds < benchMinTime){
+			iterations *= (seconds > 0) ? max(2.0, min(100.0, 1.2 * benchMinTime / seconds)) : 100;
+			continue;
+		}
+		best = min(best, seconds / iterations);
+		repeat++;
+	}
+	return {name, iterations, best * 1e9, bytesPerOp};
+}
+
+// Run every benchmark whose name contains 'filter'
+vector<BenchResult> runBenchmarks(const string& filter){
+	vector<BenchResult> results;
+	auto add = [&](const string& name, size_t bytesPerOp, auto op){
+		if(name.find(filter) == string::npos){ return; }
+		results.push_back(runBenchmark(name, bytesPerOp, op));
+		const BenchResult& r = results.back();
+		cout << left << setw(32) << r.name << right << setw(14) << fixed << setprecision(1) << r.nsPerOp << " ns/op";
+		if(r.bytesPerOp){ cout << setw(12) << setprecision(1) << (r.bytesPerOp / r.nsPerOp * 1e9 / (1024.0 * 1024.0)) << " MiB/s"; }
+		cout << endl;
+	};
+
+	vector<unsigned char> image = generateSave(platinum, 1);
+	size_t smallLength = PtLayout::smallLength;
+
+	// Micro benchmarks
+	add("crc16ccitt/small-block", smallLength, [&](unsigned long long){
+		benchSink = crc16ccitt(span<const unsigned char>(image.data(), smallLength));
+	});
+
+	unsigned char payload[pokemonRecordSize - 8];
+	memcpy(payload, image.data() + PtLayout::partySlot(smallBlock1, 0) + 8, sizeof(payload));
+	add("prng/record", sizeof(payload), [&](unsigned long long i){
+		prng(payload, i, sizeof(payload));
+		benchSink = payload[0];
+	});
+
+	add("getBlockOffsets", 0, [&](unsigned long long i){
+		benchSink = getBlockOffsets(i * 0x2000)[0];
+	});
+
+	add("calcPokemonChecksum", sizeof(payload), [&](unsigned long long){
+		benchSink = calcPokemonChecksum(span<const unsigned char>(payload, sizeof(payload)));
+	});
+
+	const u32string text = U"Pokemon Trainer ÀÉÎõü ♂♀ 0123456789";
+	add("toGameEncoding/char", 0, [&](unsigned long long i){
+		benchSink = toGameEncoding(text[i % text.size()]);
+	});
+
+	add("getSpeciesID", 0, [&](unsigned long long i){
+		benchSink = getSpeciesID(getSpeciesName(1 + i % getSpeciesCount()));
+	});
+	add("getMoveID", 0, [&](unsigned long long i){
+		benchSink = getMoveID(getMoveName(1 + i % getMoveCount()));
+	});
+	add("getAbilityID", 0, [&](unsigned long long i){
+		benchSink = getAbilityID(getAbilityName(1 + i % getAbilityCount()));
+	});
+
+	// Macro benchmarks
+	SaveBuffer memory;
+	memory.assign(image);
+	int block = getCurBlock(memory, platinum);
+	add("editPokemon/species", 0, [&](unsigned long long i){
+		editPokemon(memory, getSpeciesName(1 + i % getSpeciesCount()), "", "", 0, block, platinum, 1);
+	});
+	add("editParty/maxpp", 0, [&](unsigned long long){
+		editParty(memory, "", "", "", 0, block, platinum, 5);
+	});
+	// The party (and the small block checksum) are copied back from the generated save first, an already shiny
+	// pokemon would skip the personality value search
+	size_t partyStart = PtLayout::partySlot(getSmallBlockOffset(block), 0);
+	size_t checksumPos = PtLayout::smallChecksum(getSmallBlockOffset(block));
+	add("editParty/shiny", 0, [&](unsigned long long){
+		memcpy(memory.writable(partyStart, partySize * pokemonPartyRecordSize), image.data() + partyStart, partySize * pokemonPartyRecordSize);
+		memcpy(memory.writable(checksumPos, 2), image.data() + checksumPos, 2);
+		editParty(memory, "", "", "", 0, block, platinum, 4);
+	});
+
+	add("BoxStorage/decode-pc", 0, [&](unsigned long long){
+		BoxStorage boxes(memory, platinum);
+		benchSink = boxes.getBlock();
+	});
+	add("detectVersion", 0, [&](unsigned long long){
+		benchSink = detectVersion(memory).version;
+	});
+
+	string directory = (filesystem::temp_directory_path() / ("saveditor-bench-" + to_string(getpid()))).string();
+	filesystem::create_directories(directory);
+	string path = directory + "/bench.sav";
+	{
+		ofstream file(path, ios::binary);
+		file.write((const char*)image.data(), image.size());
+	}
+	add("file/read-edit-write", 0, [&](unsigned long long i){
+		SaveBuffer data;
+		readFile(path.c_str(), data);
+		int current = getCurBlock(data, platinum);
+		editPokemon(data, "", "", getMoveName(1 + i % getMoveCount()), 1, current, platinum, 3);
+		benchSink = writeFile(path.c_str(), data);
+	});
+	filesystem::remove_all(directory);
+
+	return results;
+}
+
+// Write 'results' as JSON
+void writeBenchJson(const vector<BenchResult>& results, ostream& out){
+	out << "{\n  \"benchmarks\": [\n";
+	for(size_t i = 0; i < results.size(); i++){
+		const BenchResult& r = results[i];
+		out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << fixed << setprecision(2) << r.nsPerOp;
+		out << ", \"bytes_per_op\": " << r.bytesPerOp;
+		if(r.bytesPerOp){ out << ", \"mib_per_s\": " << setprecision(2) << (r.bytesPerOp / r.nsPerOp * 1e9 / (1024.0 * 1024.0)); }
+		out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+
+// - - - Menu Handling Functions - - - //
+
+// Prints a menu to the console for user interaction
+void printMenu(string title, vector<string> options){
+
+	unsigned long len = title.size();
+
+	for(unsigned long i = 0; i < (len + 8); i++){ cout << "-"; } cout << "\n    ";
+	cout << title << endl;
+	for(unsigned long i = 0; i < (len + 8); i++){ cout << "-"; } cout << "\n";
+
+
+	for(unsigned long i = 1; i <= options.size(); i++){
+		cout << char(i + 48) << ") " << options[i-1] << endl;
 	}
 	cout << "> ";
 }
@@ -772,46 +2281,681 @@ int readInt(int* op){
 	return 1;
 }
 
-// Main function parses command line arguments and lets the user select what they want to edit
+void printUsage(){
+	cout << "Usage: ./saveditor [path/to/savefile] [VersionName]" << endl;
+	cout << "       ./saveditor --batch [path/to/editscript] [VersionName] [--jobs N] [--verify-checksums] [--stats report.json|report.csv] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --pipe [VersionName] [--script path/to/editscript] [--edit 'script line']... [--framed] [--pass-invalid] [--in-fd N] [--out-fd N]" << endl;
+	cout << "       ./saveditor --diff [path/to/base] [path/to/target] [VersionName] [path/to/patch]" << endl;
+	cout << "       ./saveditor --patch [path/to/patch] [--jobs N] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --check [VersionName] [--jobs N] [--all] [--stats report.json|report.csv] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --serve [path/to/socket] [--jobs N] [--cache-mb N]" << endl;
+	cout << "       ./saveditor --send [path/to/socket] ['command VersionName path/to/savefile'] [edit script lines...]" << endl;
+	cout << "       ./saveditor --boxes [path/to/savefile] [VersionName]" << endl;
+	cout << "       ./saveditor --history [path/to/savefile]" << endl;
+	cout << "       ./saveditor --index [path/to/indexfile] [VersionName] [--jobs N] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --query [path/to/indexfile] [field=value or shiny...]" << endl;
+	cout << "       ./saveditor --find-seed [PV] [HP/Atk/Def/SpA/SpD/Spe] [VersionName] [--max-frames N]" << endl;
+	cout << "       ./saveditor --scan-seeds [VersionName] [--jobs N] [--max-frames N] [--all] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --gen-save [path/to/savefile] [VersionName] [Seed]" << endl;
+	cout << "       ./saveditor --bench [--filter Name] [--json path/to/results.json]" << endl;
+	cout << "       ./saveditor --find-pv [--shiny TID SID] [--nature Name] [--low-byte MIN-MAX] [--ability 0|1] [--shuffle 0-23] [--all] [--limit N] [--jobs N]" << endl;
+	cout << "       ./saveditor --detect [--jobs N] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --export [csv|jsonl|columns] [VersionName] [--out path/to/output] [--jobs N] [--unordered] [savefiles or directories...]" << endl;
+	cout << "       ./saveditor --pkm-export [path/to/savefile] [VersionName] [path/to/directory] [--encrypted]" << endl;
+	cout << "       ./saveditor --pkm-import [path/to/savefile] [VersionName] [--party] [pkm files or directories...]" << endl;
+	cout << "Versions available: 'diamond', 'pearl', 'platinum', 'heartgold', 'soulsilver'" << endl;
+	cout << "'auto' detects the version of every save (interactive editor, --batch, --pipe, --check, --export, --pkm-export and --pkm-import)" << endl;
+}
 
-int main(int argc, char *argv[]){
+// Handles '--batch' command line arguments
+int batchMain(int argc, char *argv[]){
+	if(argc < 5){
+		printUsage();
+		return EXIT_FAILURE;
+	}
 
-	if(argc != 3){
-		cout << "Usage: ./saveditor [path/to/savefile] [VersionName]" << endl;
-		cout << "Versions available: 'diamond', 'pearl', 'platinum', 'heartgold', 'soulsilver'" << endl;
-		exit(EXIT_FAILURE);
+	int version = parseVersionOrAuto(argv[3]);
+	if(version == -1){
+		cout << "Error: version not found" << endl;
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	unsigned threads = thread::hardware_concurrency();
+	bool verifyChecksums = false;
+	string statsPath;
+	vector<string> paths;
+	for(int i = 4; i < argc; i++){
+		string arg = argv[i];
+		if(arg == "--jobs" || arg == "-j"){
+			if(i + 1 >= argc || atoi(argv[i+1]) <= 0){
+				cout << "Error: --jobs needs a positive number" << endl;
+				return EXIT_FAILURE;
+			}
+			threads = atoi(argv[++i]);
+		}
+		else if(arg == "--verify-checksums"){
+			verifyChecksums = true;
+		}
+		else if(arg == "--stats" && i + 1 < argc){
+			statsPath = argv[++i];
+		}
+		else{
+			paths.push_back(arg);
+		}
 	}
 
-	// Attempt to read file from argv[1] and save it's contents to data
-	vector<unsigned char> data;
-	readFile(argv[1], data);
+	try{
+		return runBatch(argv[2], version, paths, threads, verifyChecksums, statsPath);
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
 
-	// Make sure the provided version is valid
-	string v = argv[2];
-	int version = -1;
-	if(v.compare("diamond") == 0){ version = diamond; }
-	else if(v.compare("pearl") == 0){ version = pearl; }
-	else if(v.compare("platinum") == 0){ version = platinum; }
-	else if(v.compare("heartgold") == 0){ version = heartgold; }
-	else if(v.compare("soulsilver") == 0){ version = soulsilver; }
-	else{
+// Handles '--pipe', edits saves read from stdin and writes them to stdout
+int pipeMain(int argc, char *argv[]){
+	if(argc < 3){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	PipeOptions options;
+	options.version = parseVersionOrAuto(argv[2]);
+	if(options.version == -1){
+		cerr << "Error: version not found" << endl;
+		return EXIT_FAILURE;
+	}
+
+	try{
+		for(int i = 3; i < argc; i++){
+			string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if(arg == "--script" && hasValue){
+				vector<EditOp> script = parseEditScript(argv[++i]);
+				options.ops.insert(options.ops.end(), script.begin(), script.end());
+			}
+			else if(arg == "--edit" && hasValue){
+				EditOp op;
+				if(parseEditLine(argv[++i], op)){ options.ops.push_back(op); }
+			}
+			else if(arg == "--framed"){ options.framed = true; }
+			else if(arg == "--pass-invalid"){ options.passInvalid = true; }
+			else if(arg == "--in-fd" && hasValue){ options.inFd = atoi(argv[++i]); }
+			else if(arg == "--out-fd" && hasValue){ options.outFd = atoi(argv[++i]); }
+			else{
+				cerr << "Error: unknown argument '" << arg << "'" << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		if(options.ops.empty()){
+			cerr << "Error: no edits given, use --script or --edit" << endl;
+			return EXIT_FAILURE;
+		}
+		return runPipeline(options);
+	}
+	catch(const exception& e){
+		cerr << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--diff' and '--patch' command line arguments
+int patchMain(int argc, char *argv[]){
+	string mode = argv[1];
+	try{
+		if(mode == "--diff"){
+			if(argc != 6){
+				printUsage();
+				return EXIT_FAILURE;
+			}
+			int version = parseVersion(argv[4]);
+			if(version == -1){
+				cout << "Error: version not found" << endl;
+				printUsage();
+				return EXIT_FAILURE;
+			}
+			return runDiff(argv[2], argv[3], version, argv[5]);
+		}
+
+		if(argc < 4){
+			printUsage();
+			return EXIT_FAILURE;
+		}
+		unsigned threads = thread::hardware_concurrency();
+		vector<string> paths;
+		for(int i = 3; i < argc; i++){
+			string arg = argv[i];
+			if(arg == "--jobs" || arg == "-j"){
+				if(i + 1 >= argc || atoi(argv[i+1]) <= 0){
+					cout << "Error: --jobs needs a positive number" << endl;
+					return EXIT_FAILURE;
+				}
+				threads = atoi(argv[++i]);
+			}
+			else{
+				paths.push_back(arg);
+			}
+		}
+		return runPatch(argv[2], paths, threads);
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--check' command line arguments
+int checkMain(int argc, char *argv[]){
+	if(argc < 4){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	int version = parseVersionOrAuto(argv[2]);
+	if(version == -1){
 		cout << "Error: version not found" << endl;
-		cout << "Versions available: 'diamond', 'pearl', 'platinum', 'heartgold', 'soulsilver'" << endl;
-		exit(EXIT_FAILURE);
+		printUsage();
+		return EXIT_FAILURE;
 	}
 
-	// Find which block should be edited
-	int block = getCurBlock(data, version);
+	unsigned threads = thread::hardware_concurrency();
+	bool all = false;
+	string statsPath;
+	vector<string> paths;
+	for(int i = 3; i < argc; i++){
+		string arg = argv[i];
+		if(arg == "--jobs" || arg == "-j"){
+			if(i + 1 >= argc || atoi(argv[i+1]) <= 0){
+				cout << "Error: --jobs needs a positive number" << endl;
+				return EXIT_FAILURE;
+			}
+			threads = atoi(argv[++i]);
+		}
+		else if(arg == "--all"){ all = true; }
+		else if(arg == "--stats" && i + 1 < argc){ statsPath = argv[++i]; }
+		else{ paths.push_back(arg); }
+	}
+
+	try{
+		return runIntegrityCheck(version, paths, threads, all, statsPath);
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--export' command line arguments
+int exportMain(int argc, char *argv[]){
+	if(argc < 5){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	string formatName = argv[2];
+	int format = (formatName == "csv") ? exportCsv : (formatName == "jsonl") ? exportJsonLines : (formatName == "columns") ? exportColumns : -1;
+	if(format == -1){
+		cerr << "Error: unknown export format '" << formatName << "'" << endl;
+		return EXIT_FAILURE;
+	}
+	int version = parseVersionOrAuto(argv[3]);
+	if(version == -1){
+		cerr << "Error: version not found" << endl;
+		return EXIT_FAILURE;
+	}
+
+	unsigned threads = thread::hardware_concurrency();
+	bool ordered = true;
+	string outPath;
+	vector<string> paths;
+	for(int i = 4; i < argc; i++){
+		string arg = argv[i];
+		if(arg == "--jobs" || arg == "-j"){
+			if(i + 1 >= argc || atoi(argv[i+1]) <= 0){
+				cerr << "Error: --jobs needs a positive number" << endl;
+				return EXIT_FAILURE;
+			}
+			threads = atoi(argv[++i]);
+		}
+		else if(arg == "--out" && i + 1 < argc){ outPath = argv[++i]; }
+		else if(arg == "--unordered"){ ordered = false; }
+		else{ paths.push_back(arg); }
+	}
+
+	try{
+		return runExport(format, version, paths, outPath, threads, ordered);
+	}
+	catch(const exception& e){
+		cerr << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--pkm-export' and '--pkm-import' command line arguments
+int pkmMain(int argc, char *argv[]){
+	string mode = argv[1];
+	if(argc < 5){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+	int version = parseVersionOrAuto(argv[3]);
+	if(version == -1){
+		cout << "Error: version not found" << endl;
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	try{
+		if(mode == "--pkm-export"){
+			bool encrypted = argc > 5 && string(argv[5]) == "--encrypted";
+			return runPkmExport(argv[2], version, argv[4], encrypted);
+		}
+		bool toParty = false;
+		vector<string> paths;
+		for(int i = 4; i < argc; i++){
+			string arg = argv[i];
+			if(arg == "--party"){ toParty = true; }
+			else{ paths.push_back(arg); }
+		}
+		return runPkmImport(argv[2], version, paths, toParty);
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--detect' command line arguments
+int detectMain(int argc, char *argv[]){
+	if(argc < 3){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	unsigned threads = thread::hardware_concurrency();
+	vector<string> paths;
+	for(int i = 2; i < argc; i++){
+		string arg = argv[i];
+		if(arg == "--jobs" || arg == "-j"){
+			if(i + 1 >= argc || atoi(argv[i+1]) <= 0){
+				cout << "Error: --jobs needs a positive number" << endl;
+				return EXIT_FAILURE;
+			}
+			threads = atoi(argv[++i]);
+		}
+		else{ paths.push_back(arg); }
+	}
+
+	try{
+		return runDetect(paths, threads);
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--serve' and '--send' command line arguments
+int serveMain(int argc, char *argv[]){
+	string mode = argv[1];
+	if(argc < 4 && !(mode == "--serve" && argc == 3)){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if(mode == "--send"){
+		return runDaemonRequest(argv[2], vector<string>(argv + 3, argv + argc));
+	}
+
+	unsigned threads = thread::hardware_concurrency();
+	size_t cacheMegabytes = 256;
+	for(int i = 3; i < argc; i++){
+		string arg = argv[i];
+		if((arg == "--jobs" || arg == "-j" || arg == "--cache-mb") && i + 1 < argc && atoi(argv[i+1]) > 0){
+			if(arg == "--cache-mb"){ cacheMegabytes = atoi(argv[++i]); }
+			else{ threads = atoi(argv[++i]); }
+		}
+		else{
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	try{
+		return runDaemon(argv[2], cacheMegabytes << 20, max(threads, 1u));
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--index' and '--query' command line arguments
+int indexMain(int argc, char *argv[]){
+	string mode = argv[1];
+	if(argc < 3 || (mode == "--index" && argc < 5)){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	try{
+		if(mode == "--query"){
+			return runQuery(argv[2], vector<string>(argv + 3, argv + argc));
+		}
+
+		int version = parseVersion(argv[3]);
+		if(version == -1){
+			cout << "Error: version not found" << endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+
+		unsigned threads = thread::hardware_concurrency();
+		vector<string> paths;
+		for(int i = 4; i < argc; i++){
+			string arg = argv[i];
+			if(arg == "--jobs" || arg == "-j"){
+				if(i + 1 >= argc || atoi(argv[i+1]) <= 0){
+					cout << "Error: --jobs needs a positive number" << endl;
+					return EXIT_FAILURE;
+				}
+				threads = atoi(argv[++i]);
+			}
+			else{
+				paths.push_back(arg);
+			}
+		}
+		return runIndex(argv[2], version, paths, threads);
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--find-pv', prints personality values meeting the constraints given on the command line
+int findPvMain(int argc, char *argv[]){
+	PvConstraints constraints;
+	unsigned threads = thread::hardware_concurrency();
+	bool all = false;
+	unsigned long long limit = ULLONG_MAX;
+
+	for(int i = 2; i < argc; i++){
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(arg == "--shiny" && i + 2 < argc){
+			constraints.shiny = true;
+			constraints.tid = atoi(argv[++i]);
+			constraints.sid = atoi(argv[++i]);
+		}
+		else if(arg == "--nature" && hasValue){
+			string name = argv[++i];
+			constraints.nature = isdigit((unsigned char)name[0]) ? atoi(name.c_str()) : getNatureID(name);
+			if(constraints.nature < 0 || constraints.nature > 24){
+				cout << "Error: unknown nature '" << name << "'" << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if(arg == "--low-byte" && hasValue){
+			if(sscanf(argv[++i], "%d-%d", &constraints.lowByteMin, &constraints.lowByteMax) != 2){
+				cout << "Error: --low-byte needs a range like 0-126" << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if(arg == "--ability" && hasValue){ constraints.abilityBit = atoi(argv[++i]) & 1; }
+		else if(arg == "--shuffle" && hasValue){ constraints.shuffle = atoi(argv[++i]) % 24; }
+		else if(arg == "--all"){ all = true; }
+		else if(arg == "--limit" && hasValue){ all = true; limit = strtoull(argv[++i], NULL, 10); }
+		else if((arg == "--jobs" || arg == "-j") && hasValue && atoi(argv[i+1]) > 0){ threads = atoi(argv[++i]); }
+		else{
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	auto print = [](uint32_t pv){
+		cout << "0x" << hex << setw(8) << setfill('0') << pv << dec << setfill(' ') << "  " << natureNames[pv % 25];
+		cout << "  low byte " << (pv & 0xff) << "  ability " << (pv & 1) << "  shuffle " << getShuffleIndex(pv) << "\n";
+	};
 
-	cout << block << endl;
+	try{
+		auto start = chrono::steady_clock::now();
+		unsigned long long hits = 0;
+		if(all){
+			searchPersonalityValues(constraints, threads, [&](uint32_t pv){
+				print(pv);
+				return ++hits < limit;
+			});
+		}
+		else if(optional<uint32_t> pv = findPersonalityValue(constraints, threads)){
+			print(*pv);
+			hits = 1;
+		}
+		double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		cout << hits << " personality values found in " << fixed << setprecision(3) << millis << " ms" << endl;
+		return hits ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--find-seed' and '--scan-seeds' command line arguments
+int seedMain(int argc, char *argv[]){
+	string mode = argv[1];
+	int first = (mode == "--find-seed") ? 5 : 3;
+	if(argc < first){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	int version = parseVersion(argv[first - 1]);
+	if(version == -1){
+		cout << "Error: version not found" << endl;
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	unsigned threads = thread::hardware_concurrency();
+	int maxFrames = 10000;
+	bool all = false;
+	vector<string> paths;
+	for(int i = first; i < argc; i++){
+		string arg = argv[i];
+		if((arg == "--jobs" || arg == "-j") && i + 1 < argc && atoi(argv[i+1]) > 0){ threads = atoi(argv[++i]); }
+		else if(arg == "--max-frames" && i + 1 < argc){ maxFrames = atoi(argv[++i]); }
+		else if(arg == "--all"){ all = true; }
+		else{ paths.push_back(arg); }
+	}
+
+	try{
+		if(mode == "--scan-seeds"){
+			return runSeedScan(version, paths, threads, maxFrames, all);
+		}
+
+		uint32_t pv = strtoul(argv[2], NULL, 0);
+		int iv[6];
+		if(sscanf(argv[3], "%d/%d/%d/%d/%d/%d", &iv[0], &iv[1], &iv[2], &iv[3], &iv[4], &iv[5]) != 6 || !paths.empty()){
+			printUsage();
+			return EXIT_FAILURE;
+		}
+
+		// Displayed as HP/Atk/Def/SpA/SpD/Spe, stored as HP/Atk/Def/Spe/SpA/SpD
+		const int storedOrder[] = {0, 1, 2, 4, 5, 3};
+		uint32_t ivs = 0;
+		for(int i = 0; i < 6; i++){ ivs |= (uint32_t)(iv[i] & 0x1f) << (5 * storedOrder[i]); }
+
+		vector<SeedHit> hits = findGenerationSeeds(pv, ivs, version, maxFrames);
+		for(const SeedHit& hit : hits){
+			cout << methodNames[hit.method] << ": seed 0x" << hex << setw(8) << setfill('0') << hit.originSeed;
+			if(hit.frame >= 0){ cout << ", frame " << dec << hit.frame << " from initial seed 0x" << hex << setw(8) << hit.initialSeed; }
+			cout << dec << setfill(' ') << "\n";
+		}
+		cout << hits.size() << " seeds found" << endl;
+		return hits.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--gen-save' and '--bench' command line arguments
+int benchMain(int argc, char *argv[]){
+	string mode = argv[1];
+	try{
+		if(mode == "--gen-save"){
+			if(argc < 4 || argc > 5){
+				printUsage();
+				return EXIT_FAILURE;
+			}
+			int version = parseVersion(argv[3]);
+			if(version == -1){
+				cout << "Error: version not found" << endl;
+				printUsage();
+				return EXIT_FAILURE;
+			}
+			SaveBuffer data;
+			data.assign(generateSave(version, (argc == 5) ? strtoul(argv[4], NULL, 0) : 1));
+			data.saveAs(argv[2]);
+			return EXIT_SUCCESS;
+		}
+
+		string filter, jsonPath;
+		for(int i = 2; i < argc; i++){
+			string arg = argv[i];
+			if(arg == "--filter" && i + 1 < argc){ filter = argv[++i]; }
+			else if(arg == "--json" && i + 1 < argc){ jsonPath = argv[++i]; }
+			else{
+				printUsage();
+				return EXIT_FAILURE;
+			}
+		}
+
+		vector<BenchResult> results = runBenchmarks(filter);
+		if(!jsonPath.empty()){
+			ofstream json(jsonPath);
+			writeBenchJson(results, json);
+			if(!json){
+				cout << "Error: could not write '" << jsonPath << "'" << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
+
+// Handles '--boxes', lists every pokemon stored in the PC
+int boxesMain(int argc, char *argv[]){
+	if(argc != 4){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	int version = parseVersion(argv[3]);
+	if(version == -1){
+		cout << "Error: version not found" << endl;
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	try{
+		SaveBuffer data;
+		readFile(argv[2], data, true);
 
-	int pv = getPersonalityValue(data, block, version);
-	vector<int> blockOffsets = getBlockOffsets(pv);
+		auto start = chrono::steady_clock::now();
+		BoxStorage boxes(data, version, thread::hardware_concurrency());
+		double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+		for(int box = 0; box < boxCount; box++){
+			for(int slot = 0; slot < boxSlotCount; slot++){
+				if(boxes.isEmpty(box, slot)){ continue; }
+				cout << "Box " << setw(2) << box + 1 << " Slot " << setw(2) << slot + 1 << ": " << describePokemon(boxes.at(box, slot)) << "\n";
+			}
+		}
+		cout << boxes.occupied() << " pokemon in " << boxCount << " boxes (big block " << boxes.getBlock() << "), decoded in " << fixed << setprecision(1) << micros << " us" << endl;
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// Handles '--history' command line arguments
+int historyMain(int argc, char *argv[]){
+	if(argc != 3){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	string journalPath = string(argv[2]) + ".journal";
+	if(access(journalPath.c_str(), F_OK) != 0){
+		cout << "No edit journal for " << argv[2] << endl;
+		return EXIT_SUCCESS;
+	}
+
+	try{
+		SaveBuffer data;
+		readFile(argv[2], data);
+		EditJournal journal(data, journalPath);
+		if(journal.discardedEdits()){
+			cout << "Warning: " << argv[2] << " changed since it was last edited here, " << journal.discardedEdits()
+				 << " unsaved edits were moved to " << journalPath << ".old" << endl;
+		}
+
+		const vector<JournalEntry>& entries = journal.entries();
+		for(size_t i = 0; i < entries.size(); i++){
+			char stamp[32];
+			time_t t = entries[i].time;
+			struct tm local;
+			strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime_r(&t, &local));
+			cout << setw(4) << i + 1 << "  " << stamp << "  " << setw(5) << entries[i].changedBytes << " bytes  " << entries[i].label;
+			if(i >= journal.applied()){ cout << " (undone)"; }
+			cout << "\n";
+		}
+		cout << entries.size() << " edits, " << journal.applied() << " in effect, " << (journal.hasPendingEdits() ? "some not saved yet" : "all saved") << endl;
+	}
+	catch(const exception& e){
+		cout << "Error: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// Interactive editing session for a single save file
+int runInteractive(const char* filename, int version){
+
+	// Attempt to map the save file into data
+	SaveBuffer data;
+	readFile(filename, data);
+
+	// Edits are journaled right away and written to the save when they are saved (or on exit)
+	// A failed edit is reported and the menu stays open, the edits before it are still waiting in the journal
+	EditJournal journal(data, string(filename) + ".journal");
+	if(journal.discardedEdits()){
+		cout << "Warning: " << filename << " changed since it was last edited here, " << journal.discardedEdits()
+			 << " unsaved edits were moved to " << filename << ".journal.old" << endl;
+	}
+	if(journal.hasPendingEdits()){
+		cout << "Restored unsaved edits from " << filename << ".journal" << endl;
+	}
+
+	// Find which block should be edited
+	int block = getCurBlock(data, version);
 
 	string title = "Pokemon Savefile Editor";
-	vector<string> optionsMain = {"Edit player", "Edit Pokemon", "Exit"};
+	vector<string> optionsMain = {"Edit player", "Edit Pokemon", "Edit Party", "Undo last edit", "Redo edit", "Save changes", "Exit"};
 	vector<string> optionsPlayer = {"Edit player Name", "Back"};
-	vector<string> optionsPokemon = {"Edit Pokemon Species", "Edit Pokemon Ability", "Edit Pokemon Moves", "Make Pokemon Shiny", "Back"};
+	vector<string> optionsPokemon = {"Edit Pokemon Species", "Edit Pokemon Ability", "Edit Pokemon Moves", "Make Pokemon Shiny", "Restore Pokemon PP", "Back"};
+	vector<string> optionsParty = {"Set Move of every Pokemon", "Make every Pokemon Shiny", "Restore PP of every Pokemon", "Back"};
 
 
 
@@ -822,91 +2966,244 @@ int main(int argc, char *argv[]){
 			exit(EXIT_FAILURE);
 		}
 
-		switch(n){
-			case 1:
-
-				while(true){
-
-					string newName;;
-					bool flag = false;
-
-					// Edit Player Menu
-					printMenu(title, optionsPlayer);
-					if(!readInt(&n)){
-						cout << "Error: invalid input" << endl;
-						exit(EXIT_FAILURE);
+		try{
+			switch(n){
+				case 1:
+
+					while(true){
+
+						string newName;;
+						bool flag = false;
+
+						// Edit Player Menu
+						printMenu(title, optionsPlayer);
+						if(!readInt(&n)){
+							cout << "Error: invalid input" << endl;
+							exit(EXIT_FAILURE);
+						}
+						try{
+							switch(n){
+								case 1:
+									cout << "Enter new name > ";
+									getline(cin, newName);
+									changePlayerName(data, newName, block, version);
+									journal.record("name " + newName);
+									break;
+								case 2:
+									flag = true;
+									break;
+								default:
+									cout << "Invalid Option!" << endl;
+							}
+						}
+						catch(const SaveError& e){
+							// Nothing reached the save, the session goes on
+							cout << "Error: " << e.what() << endl;
+						}
+						if(flag) { break; };
 					}
-					switch(n){
-						case 1:
-							cout << "Enter new name > ";
-							getline(cin, newName);
-							changePlayerName(data, newName, block, version);
-							writeFile(argv[1], data);
-							break;
-						case 2:
-							flag = true;
-							break;
-						default:
-							cout << "Invalid Option!" << endl;
+					break;
+				case 2:
+
+					while(true){
+
+						string change;
+						int moveSlot;
+						bool flag = false;
+
+						// Edit Pokemon Menu
+						printMenu(title, optionsPokemon);
+						if(!readInt(&n)){
+							cout << "Error: invalid input" << endl;
+							exit(EXIT_FAILURE);
+						}
+						try{
+							switch(n){
+								case 1:
+									cout << "Enter species name (Example: Pikachu) > ";
+									getline(cin, change);
+									editPokemon(data, change, "", "", 0, block, version, 1);
+									journal.record("species " + change);
+									break;
+								case 2:
+									cout << "Enter ability name (Example: Static) > ";
+									getline(cin, change);
+									editPokemon(data, "", change, "", 0, block, version, 2);
+									journal.record("ability " + change);
+									break;
+								case 3:
+									cout << "Enter move name (Example: Volt Tackle) > ";
+									getline(cin, change);
+									cout << "Enter move slot [1-4] > ";
+									readInt(&moveSlot);
+									editPokemon(data, "", "", change, moveSlot, block, version, 3);
+									journal.record("move " + to_string(moveSlot) + " " + change);
+									break;
+								case 4:
+									editPokemon(data, "", "", "", 0, block, version, 4);
+									journal.record("shiny");
+									break;
+								case 5:
+									editPokemon(data, "", "", "", 0, block, version, 5);
+									journal.record("maxpp");
+									break;
+								case 6:
+									flag = true;
+									break;
+								default:
+									cout << "Invalid Option!" << endl;
+
+							}
+						}
+						catch(const SaveError& e){
+							cout << "Error: " << e.what() << endl;
+						}
+						if(flag){break;}
 					}
-					if(flag) { break; };
-				}
-				break;
-			case 2:
+					break;
+				case 3:
+
+					while(true){
+
+						string change;
+						int moveSlot;
+						bool flag = false;
+
+						// Edit Party Menu
+						printMenu(title, optionsParty);
+						if(!readInt(&n)){
+							cout << "Error: invalid input" << endl;
+							exit(EXIT_FAILURE);
+						}
+						try{
+							switch(n){
+								case 1:
+									cout << "Enter move name (Example: Surf) > ";
+									getline(cin, change);
+									cout << "Enter move slot [1-4] > ";
+									readInt(&moveSlot);
+									editParty(data, "", "", change, moveSlot, block, version, 3);
+									journal.record("party move " + to_string(moveSlot) + " " + change);
+									break;
+								case 2:
+									editParty(data, "", "", "", 0, block, version, 4);
+									journal.record("party shiny");
+									break;
+								case 3:
+									editParty(data, "", "", "", 0, block, version, 5);
+									journal.record("party maxpp");
+									break;
+								case 4:
+									flag = true;
+									break;
+								default:
+									cout << "Invalid Option!" << endl;
+
+							}
+						}
+						catch(const SaveError& e){
+							cout << "Error: " << e.what() << endl;
+						}
+						if(flag){break;}
+					}
+					break;
+				case 4:
+					if(journal.undo()){ cout << "Undid '" << journal.entries()[journal.applied()].label << "'" << endl; }
+					else{ cout << "Nothing to undo" << endl; }
+					break;
+				case 5:
+					if(journal.redo()){ cout << "Redid '" << journal.entries()[journal.applied() - 1].label << "'" << endl; }
+					else{ cout << "Nothing to redo" << endl; }
+					break;
+				case 6:
+					cout << "Saved (" << journal.commit() << " bytes written)" << endl;
+					break;
+				case 7:
+					// Exit, unsaved edits are saved first
+					journal.commit();
+					exit(EXIT_SUCCESS);
+				default:
+					cout << "Invalid Option!" << endl;
+			}
+		}
+		catch(const SaveError& e){
+			cout << "Error: " << e.what() << endl;
+		}
+	}
+	return EXIT_SUCCESS;
+}
 
-				while(true){
+// Main function parses command line arguments and lets the user select what they want to edit
 
-					string change;
-					int moveSlot;
-					bool flag = false;
+int main(int argc, char *argv[]){
 
-					// Edit Pokemon Menu
-					printMenu(title, optionsPokemon);
-					if(!readInt(&n)){
-						cout << "Error: invalid input" << endl;
-						exit(EXIT_FAILURE);
-					}
-					switch(n){
-						case 1:
-							cout << "Enter species name (Example: Pikachu) > ";
-							getline(cin, change);
-							editPokemon(data, change, "", "", 0, blockOffsets, block, version, 1);
-							writeFile(argv[1], data);
-							break;
-						case 2:
-							cout << "Enter ability name (Example: Static) > ";
-							getline(cin, change);
-							editPokemon(data, "", change, "", 0, blockOffsets, block, version, 2);
-							writeFile(argv[1], data);
-							break;
-						case 3:
-							cout << "Enter move name (Example: Volt Tackle) > ";
-							getline(cin, change);
-							cout << "Enter move slot [1-4] > ";
-							readInt(&moveSlot);
-							editPokemon(data, "", "", change, moveSlot, blockOffsets, block, version, 3);
-							writeFile(argv[1], data);
-							break;
-						case 4:
-							editPokemon(data, "", "", "", 0, blockOffsets, block, version, 4);
-							writeFile(argv[1], data);
-							break;
-						case 5:
-							flag = true;
-							break;
-						default:
-							cout << "Invalid Option!" << endl;
+	if(argc >= 2 && string(argv[1]) == "--batch"){
+		return batchMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--pipe"){
+		return pipeMain(argc, argv);
+	}
+	if(argc >= 2 && (string(argv[1]) == "--diff" || string(argv[1]) == "--patch")){
+		return patchMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--check"){
+		return checkMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--detect"){
+		return detectMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--export"){
+		return exportMain(argc, argv);
+	}
+	if(argc >= 2 && (string(argv[1]) == "--pkm-export" || string(argv[1]) == "--pkm-import")){
+		return pkmMain(argc, argv);
+	}
+	if(argc >= 2 && (string(argv[1]) == "--serve" || string(argv[1]) == "--send")){
+		return serveMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--history"){
+		return historyMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--boxes"){
+		return boxesMain(argc, argv);
+	}
+	if(argc >= 2 && (string(argv[1]) == "--index" || string(argv[1]) == "--query")){
+		return indexMain(argc, argv);
+	}
+	if(argc >= 2 && (string(argv[1]) == "--bench" || string(argv[1]) == "--gen-save")){
+		return benchMain(argc, argv);
+	}
+	if(argc >= 2 && string(argv[1]) == "--find-pv"){
+		return findPvMain(argc, argv);
+	}
+	if(argc >= 2 && (string(argv[1]) == "--find-seed" || string(argv[1]) == "--scan-seeds")){
+		return seedMain(argc, argv);
+	}
 
-					}
-					if(flag){break;}
-				}
-				break;
-			case 3:
-				// Exit
-				exit(EXIT_SUCCESS);
-			default:
-				cout << "Invalid Option!" << endl;
+	if(argc != 3){
+		printUsage();
+		exit(EXIT_FAILURE);
+	}
+
+	// Make sure the provided version is valid
+	int version = parseVersionOrAuto(argv[2]);
+	if(version == -1){
+		cout << "Error: version not found" << endl;
+		cout << "Versions available: 'diamond', 'pearl', 'platinum', 'heartgold', 'soulsilver', 'auto'" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	try{
+		if(version == autoVersion){
+			SaveBuffer data;
+			readFile(argv[1], data, true);
+			version = resolveVersion(data, version);
+			cout << "Detected version: " << versionProfileNames[version] << endl;
 		}
+		return runInteractive(argv[1], version);
+	}
+	catch(const SaveError& e){
+		cout << "Error: " << e.what() << endl;
+		exit(EXIT_FAILURE);
 	}
-	return 0;
 }
@@ -0,0 +1,1027 @@
+/*
+	Notes:
+		 -> libsaveditor: reading, editing and writing 4th gen NDS pokemon save files
+		 -> Edits work on a SaveBuffer (a mapped file, an owned copy or a caller owned buffer), failures throw SaveError
+		    with an error code. Editing the party of an opened or borrowed save does not allocate
+		 -> C programs use saveditor_c.h instead
+*/
+
+#ifndef SAVEDITOR_H
+#define SAVEDITOR_H
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <stdint.h>
+
+// - - - Versions - - - //
+
+// Version arguments of the functions below, versions that share a save layout share a value
+inline constexpr int diamond = 0;
+inline constexpr int pearl = 0;
+inline constexpr int platinum = 1;
+inline constexpr int heartgold = 2;
+inline constexpr int soulsilver = 2;
+
+
+// - - - Game Data Tables - - - //
+
+// Name -> ID lookups, 0 if the name is unknown
+int getSpeciesID(std::string_view name);
+int getAbilityID(std::string_view name);
+int getMoveID(std::string_view name);
+
+// ID -> name lookups, empty if the ID is out of range
+std::string_view getSpeciesName(int id);
+std::string_view getAbilityName(int id);
+std::string_view getMoveName(int id);
+
+// Number of species, abilities and moves, IDs run from 1 to the count
+int getSpeciesCount();
+int getAbilityCount();
+int getMoveCount();
+
+// Base PP of move 'id', 0 if the ID is out of range
+int getMovePP(int id);
+
+// Nature names, a pokemon's nature is its personality value % 25
+inline constexpr std::string_view natureNames[] = {
+	"Hardy", "Lonely", "Brave", "Adamant", "Naughty", "Bold", "Docile", "Relaxed", "Impish", "Lax", "Timid", "Hasty", "Serious",
+	"Jolly", "Naive", "Modest", "Mild", "Quiet", "Bashful", "Rash", "Calm", "Gentle", "Sassy", "Careful", "Quirky"
+};
+
+// Nature name -> nature (0 - 24), -1 if the name is unknown
+int getNatureID(std::string_view name);
+
+
+// - - - Error Handling - - - //
+
+// What went wrong, lets callers (and the C interface) react without parsing messages
+enum class SaveErrorCode {
+	none = 0,
+	fileError, // The file could not be read, written or rolled back
+	invalidSave, // The data is not a (usable) save file of the given version
+	invalidArgument, // Unknown name, slot out of range, text the game can't display, ...
+	notFound // A search had no result
+};
+
+// Thrown by the editing functions instead of terminating the program, so that a failure
+// while editing one save (e.g. in batch mode) does not take down the whole process
+class SaveError : public std::runtime_error {
+public:
+	SaveError(SaveErrorCode errorCode, const std::string& message) : std::runtime_error(message), errorCode(errorCode) {}
+	SaveErrorCode code() const { return errorCode; }
+
+private:
+	SaveErrorCode errorCode;
+};
+
+
+// - - - Instrumentation - - - //
+
+/* Notes:
+	-> The hot paths time themselves into the SaveStats attached to the calling thread (StatsScope); with no stats
+	   attached a probe costs a thread local load and a branch
+	-> The probes are a template policy: building with -DSAVEDITOR_NO_STATS (make STATS=0) selects NoStats and
+	   they compile to nothing
+	-> Phase times don't add up to the total: time between the probes (editing the decoded records, ...) is not
+	   part of any phase
+*/
+
+inline constexpr int statRead = 0; // Opening and mapping a save
+inline constexpr int statCurBlock = 1; // getCurBlock
+inline constexpr int statPrng = 2; // Pokemon encryption and decryption
+inline constexpr int statPokemonChecksum = 3; // calcPokemonChecksum
+inline constexpr int statCrc = 4; // Block checksums, bytes are the bytes hashed
+inline constexpr int statNameLookup = 5; // Species, ability and move name lookups
+inline constexpr int statWrite = 6; // Committing or writing a save, bytes are the bytes written
+inline constexpr int statPhaseCount = 7;
+
+inline constexpr std::string_view statPhaseNames[] = { "read", "current_block", "prng", "pokemon_checksum", "crc16", "name_lookup", "write" };
+
+struct PhaseStats {
+	uint64_t calls = 0;
+	uint64_t nanoseconds = 0;
+	uint64_t bytes = 0;
+};
+
+struct SaveStats {
+	PhaseStats phases[statPhaseCount];
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+	uint64_t nanoseconds = 0; // Wall time of the whole job, measured by the caller
+
+	void add(const SaveStats& other){
+		for(int i = 0; i < statPhaseCount; i++){
+			phases[i].calls += other.phases[i].calls;
+			phases[i].nanoseconds += other.phases[i].nanoseconds;
+			phases[i].bytes += other.phases[i].bytes;
+		}
+		allocations += other.allocations;
+		allocatedBytes += other.allocatedBytes;
+		nanoseconds += other.nanoseconds;
+	}
+};
+
+// Stats the calling thread reports into, null if none are attached
+inline thread_local SaveStats* activeStats = nullptr;
+
+// Attach 'stats' to the calling thread until the scope ends
+class StatsScope {
+public:
+	StatsScope(SaveStats& stats) : previous(activeStats) { activeStats = &stats; }
+	StatsScope(const StatsScope&) = delete;
+	StatsScope& operator=(const StatsScope&) = delete;
+	~StatsScope(){ activeStats = previous; }
+
+private:
+	SaveStats* previous;
+};
+
+struct NoStats {
+	static constexpr bool enabled = false;
+
+	struct Timer {
+		Timer(int, size_t = 0){}
+		void addBytes(size_t){}
+	};
+};
+
+struct ThreadStats {
+	static constexpr bool enabled = true;
+
+	// Times its scope as one call of 'phase'
+	class Timer {
+	public:
+		Timer(int phase, size_t bytes = 0) : stats(activeStats), phase(phase), bytes(bytes) {
+			if(stats){ start = std::chrono::steady_clock::now(); }
+		}
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+		~Timer(){
+			if(!stats){ return; }
+			PhaseStats& p = stats->phases[phase];
+			p.calls++;
+			p.bytes += bytes;
+			p.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+		void addBytes(size_t count){ bytes += count; }
+
+	private:
+		SaveStats* stats;
+		int phase;
+		size_t bytes;
+		std::chrono::steady_clock::time_point start;
+	};
+};
+
+#ifdef SAVEDITOR_NO_STATS
+using StatsPolicy = NoStats;
+#else
+using StatsPolicy = ThreadStats;
+#endif
+
+template <typename Policy = StatsPolicy>
+using PhaseTimer = typename Policy::Timer;
+
+
+// - - - Handle data from savefile - - - //
+
+/* Notes:
+	-> Save files are memory mapped privately, edits stay in memory until they are committed
+	-> A save can also be an owned in-memory copy (assign) or a buffer owned by the caller that is edited in place (borrow)
+	-> Every byte handed out for writing is recorded as dirty together with its value before the edit,
+	   so a commit only writes the modified ranges back instead of the whole 512 KB file
+	-> Commits are crash safe: the original bytes of every dirty range are written to '<save>.rollback' and
+	   synced before the save is touched, the sidecar is removed once the save itself has been synced.
+	   If the process dies in between, the next open rolls the save back to its last committed state
+	-> The dirty range tracking reserves its memory when a save is opened and keeps it across close(),
+	   so a SaveBuffer that is reused for many saves stops allocating after the first one
+*/
+
+// Range of save bytes modified since the last commit, the pre-edit bytes live at 'original' in the undo store
+struct DirtyRange {
+	size_t offset;
+	size_t length;
+	size_t original;
+};
+
+class SaveBuffer {
+public:
+	SaveBuffer(){}
+	SaveBuffer(const SaveBuffer&) = delete;
+	SaveBuffer& operator=(const SaveBuffer&) = delete;
+	SaveBuffer(SaveBuffer&& other) noexcept { *this = std::move(other); }
+	SaveBuffer& operator=(SaveBuffer&& other) noexcept;
+	~SaveBuffer(){ close(); }
+
+	// Map 'path' into memory, rolling back an interrupted commit first
+	void open(const char* path, bool readOnly = false);
+
+	// Use an in-memory copy of a save that is not backed by a file
+	void assign(std::vector<unsigned char> contents);
+
+	// Edit 'contents' in place, the caller keeps ownership and has to keep it alive until close()
+	void borrow(std::span<unsigned char> contents);
+
+	void close();
+
+	// Writing through operator[] records the byte as dirty, reading should go through a const reference
+	unsigned char& operator[](size_t i){
+		markDirty(i, 1);
+		return bytes[i];
+	}
+	const unsigned char& operator[](size_t i) const { return bytes[i]; }
+
+	size_t size() const { return length; }
+	const unsigned char* data() const { return bytes; }
+	const std::string& path() const { return filename; }
+
+	// Read-only view of [offset, offset + count)
+	std::span<const unsigned char> view(size_t offset, size_t count) const {
+		if(offset + count > length){ throw SaveError(SaveErrorCode::invalidSave, "read outside of save file"); }
+		return std::span<const unsigned char>(bytes + offset, count);
+	}
+
+	// Pointer for bulk writes to [offset, offset + count), the whole range is recorded as dirty
+	unsigned char* writable(size_t offset, size_t count){
+		markDirty(offset, count);
+		return bytes + offset;
+	}
+
+	// Record [offset, offset + count) as modified, must be called before the bytes change
+	void markDirty(size_t offset, size_t count){
+		if(count == 0){ return; }
+		if(offset + count > length){ throw SaveError(SaveErrorCode::invalidArgument, "edit outside of save file"); }
+
+		// Fast path: the byte belongs to, or directly extends, the range that was touched last
+		if(lastHit < dirty.size()){
+			DirtyRange& r = dirty[lastHit];
+			if(offset >= r.offset && offset + count <= r.offset + r.length){ return; }
+			if(offset == r.offset + r.length && r.original + r.length == undo.size()
+			   && (lastHit + 1 == dirty.size() || dirty[lastHit + 1].offset >= offset + count)){
+				undo.insert(undo.end(), bytes + offset, bytes + offset + count);
+				r.length += count;
+				return;
+			}
+		}
+		markDirtySlow(offset, count);
+	}
+
+	bool isDirty() const { return !dirty.empty(); }
+	const std::vector<DirtyRange>& dirtyRanges() const { return dirty; }
+	const unsigned char* originalBytes(const DirtyRange& r) const { return undo.data() + r.original; }
+
+	// Value of byte i when the save was opened or last committed
+	unsigned char original(size_t i) const;
+
+	size_t dirtyBytes() const;
+
+	// Forget the recorded edits without writing them, e.g. once the owner of a borrowed buffer stored it
+	void markClean(){
+		dirty.clear();
+		undo.clear();
+		lastHit = 0;
+	}
+
+	// Recompute block checksums from scratch instead of updating them from the dirty ranges, the setting is kept
+	// when another save is opened in the same buffer
+	void setVerifyChecksums(bool verify){ verifyAll = verify; }
+	bool verifiesChecksums() const { return verifyAll; }
+
+	// Write the dirty ranges back to the mapped file, returns the number of bytes written to the save
+	size_t commit();
+
+	// Write the complete buffer to 'path' through a temporary file and an atomic rename
+	void saveAs(const char* path);
+
+	// Undo an interrupted commit of 'path' if its rollback file is still around
+	static void recover(const char* path);
+
+private:
+	unsigned char* bytes = nullptr;
+	size_t length = 0;
+	bool mapped = false;
+	int fd = -1;
+	std::string filename;
+	std::vector<unsigned char> owned;
+	std::vector<DirtyRange> dirty;
+	std::vector<unsigned char> undo;
+	size_t lastHit = 0;
+	bool verifyAll = false;
+
+	void reserveTracking();
+	void markDirtySlow(size_t offset, size_t count);
+	void writeRollback(const std::string& rollbackPath);
+};
+
+// Map the save file into 'data'
+void readFile(const char* filename, SaveBuffer& data, bool readOnly = false);
+
+// Write changes to savefile, only the modified ranges are written if 'filename' is the file 'data' was read from
+size_t writeFile(const char* filename, SaveBuffer& data);
+
+
+// - - - Small Block Functions - - - //
+
+// Checksum (CRC-16-CCITT) of 'dataChunk'
+int crc16ccitt(std::span<const unsigned char> dataChunk);
+
+// The implementations crc16ccitt() picks from, continuing 'crc' over 'chunk', only called directly by 'make check'
+uint16_t crc16Table(std::span<const unsigned char> chunk, uint16_t crc);
+#if defined(__x86_64__) || defined(__i386__)
+uint16_t crc16Clmul(std::span<const unsigned char> chunk, uint16_t crc);
+#endif
+
+// Update checksum bytes of small block 'block' with 'newValue'
+void updateChecksum(SaveBuffer& data, int newValue, int block, int version);
+
+// New checksum of [start, start + count) given 'oldCrc', the checksum of the same range before the dirty ranges of 'data' changed
+int crc16ccittIncremental(int oldCrc, const SaveBuffer& data, size_t start, size_t count);
+
+// Checksum of the 'count' bytes at 'blockOffset' after editing, 'checksumPos' holds the checksum stored before the edits
+int calcBlockChecksum(const SaveBuffer& data, size_t blockOffset, size_t count, size_t checksumPos);
+
+// Checksum of the small block 'block' after editing
+int calcSmallBlockChecksum(const SaveBuffer& data, int block, int version);
+
+// Find out which small block (1 or 2) was saved last
+int getCurBlock(const SaveBuffer& data, int version);
+
+
+// - - - Handle Pokemon Data Functions - - - //
+
+inline constexpr int pokemonRecordSize = 136;
+inline constexpr int pokemonPartyRecordSize = 236;
+inline constexpr int pokemonDataBlockSize = 32;
+
+// Offset of the lead pokemon's record in the save file
+size_t getLeadPokemonOffset(int block, int version);
+
+// Get the Pokemon's 'Personality Value' from the record at 'recordOffset'
+uint32_t getPersonalityValue(const SaveBuffer& data, size_t recordOffset);
+
+
+// - - - Character Encoding/Decoding Functions - - - //
+
+inline constexpr int gameTextTerminator = 0xffff;
+inline constexpr int gameTextNewline = 0xe000;
+inline constexpr int gameCharacterCount = 0x200;
+inline constexpr int replacementCharacter = 0xfffd;
+
+// Size of the text fields in characters, including the terminator
+inline constexpr int trainerNameChars = 8;
+inline constexpr int nicknameChars = 11;
+
+// Read one code point from UTF-8 'text' at 'pos', returns replacementCharacter for malformed input
+char32_t nextCodePoint(std::string_view text, size_t& pos);
+
+// Append code point 'cp' as UTF-8 to 'out', returns false if it doesn't fit
+bool appendCodePoint(char32_t cp, char* out, size_t outSize, size_t& len);
+
+// Game character for a single unicode code point, throws if the game can't display it
+int toGameEncoding(char32_t c);
+
+// Unicode code point for a single game character, throws if the character is not mapped
+char32_t fromGameEncoding(int n);
+
+// Encode UTF-8 'text' into a game text field of 'fieldChars' characters: text, terminator, zero padding
+// Returns the number of characters written, or -1 if the text doesn't fit or has characters the game can't display
+int encodeGameText(std::string_view text, unsigned char* field, size_t fieldChars);
+
+// Decode a game text field of at most 'fieldChars' characters into UTF-8 at 'out', stops at the terminator
+// Unmapped characters become U+FFFD, returns the length written ('out' is always NUL terminated)
+size_t decodeGameText(const unsigned char* field, size_t fieldChars, char* out, size_t outSize);
+
+// Decode 'count' text fields that are 'stride' bytes apart into fixed size slots of 'outStride' bytes
+void decodeGameTextBulk(const unsigned char* fields, size_t count, size_t stride, size_t fieldChars, char* out, size_t outStride, size_t* lengths);
+
+
+// - - - Handle Pokemon Encryption Functions - - - //
+
+inline constexpr uint32_t lcgMultiplier = 0x41C64E6Du;
+inline constexpr uint32_t lcgIncrement = 0x00006073u;
+
+// Offsets of the data blocks A, B, C and D inside the shuffled data of a record with personality value 'pv'
+const std::array<int, 4>& getBlockOffsets(uint32_t pv);
+
+// Encrypt/Decrypt 'count' bytes of pokemon data (linear congruential generator)
+void prng(unsigned char* data, uint32_t seed, size_t count);
+
+// Encrypt/Decrypt 'records' blocks of 'count' bytes, 'stride' bytes apart, block i uses 'seeds[i]'
+void prngBatch(unsigned char* data, size_t stride, const uint32_t* seeds, size_t records, size_t count);
+
+// The kernels prng() picks from, only called directly by 'make check' (the SIMD ones need a CPU that supports them)
+void prngScalar(unsigned char* data, uint32_t seed, size_t count);
+#if defined(__x86_64__) || defined(__i386__)
+void prngSse41(unsigned char* data, uint32_t seed, size_t count);
+void prngAvx2(unsigned char* data, uint32_t seed, size_t count);
+#endif
+
+// Calculate the checksum of the (decrypted) 128 bytes of pokemon data blocks
+int calcPokemonChecksum(std::span<const unsigned char> dataChunk);
+
+// Decrypt and unshuffle the encrypted record at 'src' into 'out'
+void decodePokemon(const unsigned char* src, unsigned char* out);
+
+// Recompute the checksum of the decoded record 'record' (stored back into it), then shuffle and encrypt it into 'out'
+void encodePokemon(unsigned char* record, unsigned char* out);
+
+
+// - - - Pokemon View - - - //
+
+/* Notes:
+	-> A PokemonRecord gives typed access to the fields of an already decoded record, it does not own the bytes
+	-> A PokemonView decrypts one record when it is created and keeps the decoded copy (the 136 byte part only,
+	   use Party for party pokemon whose personality value changes, their battle stats are keyed by it)
+	-> Any number of edits only change the decoded copy, commit() recomputes the pokemon checksum and
+	   encrypts the record back into the save exactly once
+	-> The small block checksum is not touched, call updateSmallBlockChecksum() once all views are committed
+*/
+
+class PokemonRecord {
+public:
+	// Positions of the fields in a decoded record (blocks A, B, C and D in order, each pokemonDataBlockSize bytes from 0x08)
+	static constexpr size_t flagsPos = 0x04; // Bit 2: bad egg
+	static constexpr size_t speciesPos = 0x08;
+	static constexpr size_t itemPos = 0x0a;
+	static constexpr size_t otIdPos = 0x0c;
+	static constexpr size_t otSecretIdPos = 0x0e;
+	static constexpr size_t abilityPos = 0x15;
+	static constexpr size_t movesPos = 0x28;
+	static constexpr size_t ppPos = 0x30;
+	static constexpr size_t ppUpsPos = 0x34;
+	static constexpr size_t ivsPos = 0x38;
+	static constexpr size_t nicknamePos = 0x48;
+
+	// 'modifiedFlag' is set whenever a field is written
+	PokemonRecord(unsigned char* decodedRecord, bool* modifiedFlag) : record(decodedRecord), changed(modifiedFlag) {}
+
+	// Changing the personality value changes the shuffle order, the record is shuffled and encrypted accordingly on commit
+	uint32_t getPersonalityValue() const { return read32(0); }
+	void setPersonalityValue(uint32_t pv){ write32(0, pv); }
+	bool isBadEgg() const { return record[flagsPos] & 0x04; }
+
+	int getSpecies() const { return read16(speciesPos); }
+	void setSpecies(int id){ write16(speciesPos, id); }
+
+	int getItem() const { return read16(itemPos); }
+	void setItem(int id){ write16(itemPos, id); }
+
+	int getOtId() const { return read16(otIdPos); }
+	void setOtId(int id){ write16(otIdPos, id); }
+
+	int getOtSecretId() const { return read16(otSecretIdPos); }
+	void setOtSecretId(int id){ write16(otSecretIdPos, id); }
+
+	int getAbility() const { return record[abilityPos]; }
+	void setAbility(int id){ write8(abilityPos, id); }
+
+	// Move slots are numbered 1 - 4 like in the menus
+	int getMove(int slot) const { return read16(movesPos + 2 * checkSlot(slot)); }
+	void setMove(int slot, int id){ write16(movesPos + 2 * checkSlot(slot), id); }
+
+	int getPP(int slot) const { return record[ppPos + checkSlot(slot)]; }
+	void setPP(int slot, int value){ write8(ppPos + checkSlot(slot), value); }
+
+	int getPPUps(int slot) const { return record[ppUpsPos + checkSlot(slot)]; }
+	void setPPUps(int slot, int value){ write8(ppUpsPos + checkSlot(slot), value); }
+
+	// IVs are packed 5 bits each (HP, Attack, Defense, Speed, Sp. Attack, Sp. Defense), bit 30 is the egg flag, bit 31 the nickname flag
+	uint32_t getIVs() const { return read32(ivsPos); }
+	void setIVs(uint32_t value){ write32(ivsPos, value); }
+	int getIV(int stat) const { return (getIVs() >> (5 * stat)) & 0x1f; }
+	void setIV(int stat, int value){ setIVs((getIVs() & ~(0x1fu << (5 * stat))) | ((uint32_t)(value & 0x1f) << (5 * stat))); }
+
+	// Nickname as UTF-8, returns the decoded length
+	size_t getNickname(char* out, size_t outSize) const {
+		return decodeGameText(record + nicknamePos, nicknameChars, out, outSize);
+	}
+	void setNickname(std::string_view name){
+		unsigned char encoded[nicknameChars * 2];
+		if(encodeGameText(name, encoded, nicknameChars) < 0){
+			throw SaveError(SaveErrorCode::invalidArgument, "invalid nickname");
+		}
+		std::memcpy(record + nicknamePos, encoded, sizeof(encoded));
+		*changed = true;
+	}
+
+	bool isShiny() const {
+		uint32_t pv = getPersonalityValue();
+		return ((getOtId() ^ getOtSecretId() ^ (pv >> 16) ^ (pv & 0xffff)) & 0xffff) < 8;
+	}
+
+	bool isModified() const { return *changed; }
+	const unsigned char* decoded() const { return record; }
+
+protected:
+	unsigned char* record;
+	bool* changed;
+
+	static int checkSlot(int slot){
+		if(slot < 1 || slot > 4){
+			throw SaveError(SaveErrorCode::invalidArgument, "invalid move slot");
+		}
+		return slot - 1;
+	}
+
+	int read16(size_t pos) const { return record[pos] | (record[pos+1] << 8); }
+	uint32_t read32(size_t pos) const { return record[pos] | (record[pos+1] << 8) | (record[pos+2] << 16) | ((uint32_t)record[pos+3] << 24); }
+	void write8(size_t pos, int value){ record[pos] = value; *changed = true; }
+	void write16(size_t pos, int value){ record[pos] = value & 0xff; record[pos+1] = (value >> 8) & 0xff; *changed = true; }
+	void write32(size_t pos, uint32_t value){ for(int i = 0; i < 4; i++){ record[pos+i] = (value >> (8*i)) & 0xff; } *changed = true; }
+};
+
+class PokemonView : public PokemonRecord {
+public:
+	PokemonView(SaveBuffer& save, size_t recordOffset) : PokemonRecord(storage, &modified), data(save), offset(recordOffset) {
+		decodePokemon(data.view(offset, pokemonRecordSize).data(), storage);
+	}
+
+	// The base class points into this object
+	PokemonView(const PokemonView&) = delete;
+	PokemonView& operator=(const PokemonView&) = delete;
+
+	// Re-checksum and encrypt the record back into the save, does nothing if nothing was edited
+	void commit(){
+		if(!modified){ return; }
+		unsigned char encrypted[pokemonRecordSize];
+		encodePokemon(storage, encrypted);
+
+		// Personality value and flags usually stay the same, skip them then
+		size_t skip = std::memcmp(data.view(offset, 6).data(), encrypted, 6) == 0 ? 6 : 0;
+		std::memcpy(data.writable(offset + skip, pokemonRecordSize - skip), encrypted + skip, pokemonRecordSize - skip);
+		modified = false;
+	}
+
+private:
+	SaveBuffer& data;
+	size_t offset;
+	unsigned char storage[pokemonRecordSize];
+	bool modified = false;
+};
+
+// Update the small block checksum after edits, once per batch of edits
+void updateSmallBlockChecksum(SaveBuffer& data, int block, int version);
+
+
+// - - - Personality Value Search Functions - - - //
+
+struct PvConstraints {
+	bool shiny = false;
+	uint16_t tid = 0; // Trainer the PV has to be shiny for
+	uint16_t sid = 0;
+	int nature = -1; // 0 - 24, -1 for any
+	int lowByteMin = 0; // Gender: female if the low byte is below the species' gender threshold
+	int lowByteMax = 255;
+	int abilityBit = -1; // 0 or 1, -1 for any
+	int shuffle = -1; // Index into the getBlockOffsets table, -1 for any
+};
+
+// Shuffle order index of 'pv', see getBlockOffsets
+constexpr int getShuffleIndex(uint32_t pv){
+	return ((pv & 0x3e000) >> 0xd) % 24;
+}
+
+// Call 'onHit' for every PV meeting 'constraints' until it returns false, chunks are spread over 'threads' workers
+// With one thread hits come in enumeration order, otherwise in order within a chunk but chunks may interleave
+void searchPersonalityValues(const PvConstraints& constraints, unsigned threads, const std::function<bool(uint32_t)>& onHit);
+
+// First PV (in enumeration order) meeting 'constraints', the result does not depend on 'threads'
+std::optional<uint32_t> findPersonalityValue(const PvConstraints& constraints, unsigned threads = 1);
+
+
+// - - - Seed Search Functions - - - //
+
+inline constexpr uint32_t lcgInverseMultiplier = 0xEEB9EB65u;
+inline constexpr uint32_t lcgInverseIncrement = 0x0A3561A1u;
+
+inline constexpr int methodOne = 0;
+inline constexpr int methodJ = 1;
+inline constexpr int methodK = 2;
+inline constexpr std::string_view methodNames[] = {"Method 1", "Method J", "Method K"};
+
+// Rejected PV pairs followed back for Method J/K, every pair ends the walk with probability 1/25
+inline constexpr int seedMaxRejects = 500;
+// Largest delay (low 16 bits) accepted for an initial seed
+inline constexpr int seedMaxDelay = 0x2000;
+
+constexpr uint32_t lcgNext(uint32_t seed){ return seed * lcgMultiplier + lcgIncrement; }
+constexpr uint32_t lcgPrev(uint32_t seed){ return seed * lcgInverseMultiplier + lcgInverseIncrement; }
+
+// Every seed whose call returns 'first' and whose next call returns 'second', returns how many were written to 'out' (at most 4)
+size_t findConsecutiveSeeds(uint16_t first, uint16_t second, uint32_t* out);
+
+struct SeedHit {
+	int method;
+	uint32_t originSeed; // Seed before the first call of the method (nature call for J/K, PV low call for Method 1)
+	uint32_t initialSeed; // Closest earlier seed that looks like a DS initial seed
+	int frame; // Calls from 'initialSeed' to 'originSeed', -1 if none was found within the frame limit
+};
+
+// Nature picked by the nature call of Method J/K
+constexpr int getMethodNature(uint16_t call, int method){
+	return (method == methodJ) ? call / 0xa3e : call % 25;
+}
+
+// Walk back from 'seed' to the closest initial seed, fills in the frame of 'hit'
+void findInitialSeed(SeedHit& hit, int maxFrames);
+
+// Every way Method 1 and Method J (DPPt) or K (HGSS) can produce 'pv' together with 'ivs' (as stored in a record)
+std::vector<SeedHit> findGenerationSeeds(uint32_t pv, uint32_t ivs, int version, int maxFrames);
+
+
+// - - - PC Box Storage Functions - - - //
+
+inline constexpr int boxCount = 18;
+inline constexpr int boxSlotCount = 30;
+inline constexpr int pcSlotCount = boxCount * boxSlotCount;
+
+// Offset of big block 'block' in the save file
+size_t getBigBlockOffset(int block, int version);
+
+// Find out in which big block the boxes were last saved, 'smallBlock' (the current small block) is used if the counters don't tell
+int getCurBigBlock(const SaveBuffer& data, int version, int smallBlock);
+
+// Offset of the record in 'slot' of 'box' (both counted from 0) in big block 'block'
+size_t getBoxSlotOffset(int block, int version, int box, int slot);
+
+// Checksum of the big block 'block' after editing
+int calcBigBlockChecksum(const SaveBuffer& data, int block, int version);
+
+// Update the big block checksum after box edits, once per batch of edits
+void updateBigBlockChecksum(SaveBuffer& data, int block, int version);
+
+// An empty box slot (or a released pokemon) is all zero bytes
+bool isEmptyRecord(const unsigned char* record);
+
+// Decode 'count' encrypted records at 'src', 'srcStride' bytes apart, into 'out' (packed), empty records stay all zero
+void decodePokemonBatch(const unsigned char* src, size_t count, unsigned char* out, size_t srcStride = pokemonRecordSize);
+
+class BoxStorage {
+public:
+	// Decode all boxes of the current big block, 'threads' workers split the boxes between them
+	BoxStorage(SaveBuffer& save, int version, unsigned threads = 1);
+
+	int getBlock() const { return block; }
+
+	// Boxes and slots are counted from 0
+	bool isEmpty(int box, int slot) const { return isEmptyRecord(decoded(box, slot)); }
+	const unsigned char* decoded(int box, int slot) const { return &records[index(box, slot) * pokemonRecordSize]; }
+	bool isModified(int box, int slot) const { return modified[index(box, slot)]; }
+
+	// Field access to the decoded copy of a slot, edits are written back by commit()
+	PokemonRecord at(int box, int slot){
+		size_t i = index(box, slot);
+		return PokemonRecord(&records[i * pokemonRecordSize], &modified[i]);
+	}
+
+	// Replace a slot with a decoded record (an all zero record empties it)
+	void set(int box, int slot, const unsigned char* decodedRecord){
+		size_t i = index(box, slot);
+		std::memcpy(&records[i * pokemonRecordSize], decodedRecord, pokemonRecordSize);
+		modified[i] = true;
+	}
+
+	// Number of slots holding a pokemon
+	size_t occupied() const;
+
+	// Encrypt every edited slot back into the save and update the big block checksum, returns the number of slots written
+	size_t commit();
+
+private:
+	SaveBuffer& data;
+	int saveVersion;
+	int block;
+	std::vector<unsigned char> records;
+	std::array<bool, pcSlotCount> modified = {};
+
+	size_t index(int box, int slot) const {
+		if(box < 0 || box >= boxCount || slot < 0 || slot >= boxSlotCount){
+			throw SaveError(SaveErrorCode::invalidArgument, "invalid box slot");
+		}
+		return box * boxSlotCount + slot;
+	}
+
+	void load(unsigned threads);
+};
+
+
+// - - - Party Functions - - - //
+
+inline constexpr int partySize = 6;
+inline constexpr int pokemonBattleStatsSize = pokemonPartyRecordSize - pokemonRecordSize;
+
+// Offset of party 'slot' (counted from 0) in small block 'block'
+size_t getPartySlotOffset(int block, int version, int slot);
+
+// Number of pokemon in the party
+int getPartyCount(const SaveBuffer& data, int block, int version);
+
+class Party {
+public:
+	Party(SaveBuffer& save, int block, int version);
+
+	// The address of the decoded records is handed out, so a Party can't be copied
+	Party(const Party&) = delete;
+	Party& operator=(const Party&) = delete;
+
+	int count() const { return partyCount; }
+
+	// Slots are counted from 0, slots past count() may hold leftovers of pokemon that were deposited
+	PokemonRecord at(int slot){
+		checkSlot(slot);
+		return PokemonRecord(records[slot], &modified[slot]);
+	}
+	const unsigned char* decoded(int slot) const { return records[checkSlot(slot)]; }
+	const unsigned char* getBattleStats(int slot) const { return battleStats[checkSlot(slot)]; }
+	bool isModified(int slot) const { return modified[checkSlot(slot)]; }
+
+	// Replace a slot with a decoded record and its decrypted battle stats, the slot right after the last one adds
+	// a pokemon to the party (the party count is written right away)
+	void set(int slot, const unsigned char* decodedRecord, const unsigned char* stats);
+
+	// Encrypt every edited slot back into the save, returns the number of slots written
+	size_t commit();
+
+private:
+	SaveBuffer& data;
+	int saveBlock;
+	int saveVersion;
+	int partyCount;
+	size_t partyOffset; // Slot 0, the slots follow pokemonPartyRecordSize apart
+	unsigned char records[partySize][pokemonRecordSize];
+	unsigned char battleStats[partySize][pokemonBattleStatsSize];
+	bool modified[partySize] = {};
+	bool statsModified[partySize] = {};
+
+	static int checkSlot(int slot){
+		if(slot < 0 || slot >= partySize){
+			throw SaveError(SaveErrorCode::invalidArgument, "invalid party slot");
+		}
+		return slot;
+	}
+};
+
+
+// - - - PKM File Functions - - - //
+
+/* Notes:
+	-> A .pkm file holds one pokemon record: 136 bytes for a boxed pokemon, 236 bytes for a party pokemon (with battle stats)
+	-> Decrypted files hold the record the way PokemonRecord reads it (blocks A, B, C, D in order, battle stats in clear),
+	   encrypted files hold the bytes as they are stored in the save. parsePkm takes both, a decrypted record passes the
+	   pokemon checksum as it is, an encrypted one only after decoding
+*/
+
+struct PkmRecord {
+	unsigned char record[pokemonRecordSize]; // Decoded
+	unsigned char battleStats[pokemonBattleStatsSize]; // Decrypted, only set if hasBattleStats
+	bool hasBattleStats;
+	bool encrypted; // How the file stored the record
+};
+
+// Decode the contents of a .pkm file, throws if the size is wrong or the record fails the pokemon checksum
+PkmRecord parsePkm(std::span<const unsigned char> bytes);
+
+// Write a decoded record (and its decrypted battle stats, unless null) as .pkm file contents into 'out', returns the size
+size_t writePkm(const unsigned char* decodedRecord, const unsigned char* stats, bool encrypted, unsigned char* out);
+
+
+// - - - Player Editing Functions - - - //
+
+// Write a new player name, the small block checksum is updated by the caller
+void setPlayerName(SaveBuffer& data, std::string_view newName, int block, int version);
+
+// Write a new player name and update the small block checksum
+void changePlayerName(SaveBuffer& data, std::string_view newName, int block, int version);
+
+
+// - - - Pokemon Editing Functions - - - //
+
+// Single edits of a decoded pokemon, names are matched exactly (see the Game Data Tables)
+void editPokemonSpecies(PokemonRecord& view, std::string_view pokemonName);
+void editPokemonAbility(PokemonRecord& view, std::string_view abilityName);
+void editPokemonMove(PokemonRecord& view, std::string_view moveName, int moveSlot);
+void makePokemonShiny(PokemonRecord& view);
+void restorePokemonPP(PokemonRecord& view);
+
+// Apply one edit to a decoded pokemon, 'option' selects the edit like in the menus
+// (1 species, 2 ability, 3 move, 4 shiny, 5 restore PP)
+void editPokemon(PokemonRecord& view, std::string_view pokemonName, std::string_view abilityName, std::string_view moveName, int moveSlot, int option);
+
+// Apply one edit to every pokemon in the party
+void editParty(Party& party, std::string_view pokemonName, std::string_view abilityName, std::string_view moveName, int moveSlot, int option);
+
+// Edit the lead pokemon, re-encrypt it and update the small block checksum
+void editPokemon(SaveBuffer& data, std::string_view pokemonName, std::string_view abilityName, std::string_view moveName, int moveSlot, int block, int version, int option);
+
+// Edit the whole party with one decrypt/encrypt pass and one checksum update
+void editParty(SaveBuffer& data, std::string_view pokemonName, std::string_view abilityName, std::string_view moveName, int moveSlot, int block, int version, int option);
+
+
+// - - - Save Diff Functions - - - //
+
+/* Notes:
+	-> A patch turns one snapshot of a save into another, pokemon records are diffed decrypted (field level)
+	   and re-encrypted when the patch is applied, block checksums are recomputed and verified
+*/
+
+// Structure-aware patch that turns 'base' into 'target' (both saves of 'version')
+std::vector<unsigned char> diffSaves(std::span<const unsigned char> base, std::span<const unsigned char> target, int version);
+
+// Version of the saves 'patch' was made for, throws if 'patch' is not a patch
+int getPatchVersion(std::span<const unsigned char> patch);
+
+// Apply 'patch' to 'data', returns the number of ops applied
+// Throws if the patch doesn't match the save, 'data' may be partly patched then (see SaveBuffer::dirtyRanges)
+size_t applySavePatch(SaveBuffer& data, std::span<const unsigned char> patch);
+
+
+// - - - Integrity Check Functions - - - //
+
+/* Notes:
+	-> Checks a save the way the game does when loading it: both small and both big blocks against their checksums,
+	   every party slot and every box slot of both save slots against the pokemon checksum
+	-> Works on the mapped save without allocating per record, one box is decoded at a time
+*/
+
+// Block states
+inline constexpr int blockValid = 0;
+inline constexpr int blockUnused = 1; // Never written (all 0xff), a new game only has one save slot
+inline constexpr int blockCorrupt = 2; // Checksum doesn't match
+
+// Record problems
+inline constexpr int recordBadEgg = 1; // The game flagged it as a bad egg
+inline constexpr int recordBadChecksum = 2; // Will turn into a bad egg when the game loads it
+inline constexpr int recordBadData = 3; // Checksum is right but species or level are impossible
+
+struct BlockIntegrity {
+	int status;
+	uint16_t storedChecksum;
+	uint16_t checksum;
+	uint32_t saveCounter;
+};
+
+struct RecordIssue {
+	int block; // Save slot (1 or 2)
+	int box; // -1 for the party
+	int slot; // Counted from 0
+	int problem;
+};
+
+struct SaveIntegrity {
+	BlockIntegrity smallBlocks[2];
+	BlockIntegrity bigBlocks[2];
+	int newestBlock; // Small block with the most recent save, valid or not
+	int currentBlock; // Small block the game loads (newest valid one), 0 if none is valid
+	int currentBigBlock; // Same for the big blocks
+	int partyCount[2]; // As stored, more than partySize is corrupt
+	size_t records; // Pokemon checked
+	std::vector<RecordIssue> issues;
+
+	bool ok() const { return currentBlock && currentBigBlock && issues.empty() && partyCount[currentBlock - 1] <= partySize; }
+};
+
+// Validate every checksum and pokemon of a save of 'version', throws only if 'data' is too small to be one
+SaveIntegrity checkSaveIntegrity(const SaveBuffer& data, int version);
+
+
+// - - - Version Detection Functions - - - //
+
+/* Notes:
+	-> detectVersion scores how well the offsets of every version fit a save, so that saves of an unknown version
+	   can be edited without guessing: a wrong version writes the checksums to the wrong offsets
+	-> Diamond and Pearl share their offsets, so do Heartgold and Soulsilver, the verdict is one of the three profiles
+*/
+
+inline constexpr int versionProfileCount = 3; // Diamond/Pearl, Platinum, Heartgold/Soulsilver
+
+// Signals a profile can match, with their weight in the score (the weights add up to 100)
+inline constexpr int signalSmallChecksum = 0x01; // 40: the small block of either save slot has a valid checksum
+inline constexpr int signalBigChecksum = 0x02; // 20: the big block of that save slot has a valid checksum
+inline constexpr int signalFooter = 0x04; // 15: the small block footer stores the size of the block
+inline constexpr int signalTrainer = 0x08; // 10: trainer name is terminated and the play time is in range
+inline constexpr int signalParty = 0x10; // 15: party count is 1-6 and the lead pokemon checksum is valid
+
+inline constexpr int detectMinScore = 60; // Lowest score accepted as the version of a save
+inline constexpr int detectMinMargin = 20; // Required lead of the best profile over the second one
+
+struct VersionScore {
+	int version;
+	int score; // 0-100
+	unsigned signals;
+};
+
+struct VersionDetection {
+	VersionScore ranked[versionProfileCount]; // Best first
+	int version; // Best profile, -1 if its score is too low or the second one is too close
+};
+
+// Score every version profile against a save, never throws (a file too small for a profile scores 0)
+VersionDetection detectVersion(const SaveBuffer& data);
+
+
+// - - - Edit Journal Functions - - - //
+
+/* Notes:
+	-> An EditJournal keeps the edit history of a save in an append-only sidecar file: every edit appends the bytes
+	   it changed (old and new, checksum fields included), undo and redo append a marker and replay the history in memory
+	-> The save file itself is only written by commit(), edits that were journaled but not committed are applied
+	   again when the journal is opened in the next session, undo works across sessions
+*/
+
+struct JournalEntry {
+	std::string label; // What was edited, e.g. "species Pikachu"
+	int64_t time; // Unix time of the edit
+	size_t firstRun;
+	size_t runCount;
+	size_t changedBytes;
+};
+
+class EditJournal {
+public:
+	// Journal the edits of 'save' (freshly opened for writing) in 'path', uncommitted edits found there are applied to 'save'
+	// A journal that belongs to a different version of the save is moved to 'path'.old and a new one is started
+	EditJournal(SaveBuffer& save, const std::string& path);
+	EditJournal(const EditJournal&) = delete;
+	EditJournal& operator=(const EditJournal&) = delete;
+	~EditJournal();
+
+	// Append everything changed in the save since the last record as one edit, false if nothing changed
+	// Edits that were undone can't be redone anymore after a new edit
+	bool record(std::string_view label);
+
+	// Revert the last edit that is in effect / apply the last reverted edit again, false if there is none
+	bool undo();
+	bool redo();
+
+	// Write the save (only the modified bytes, see SaveBuffer::commit) and mark the journal, returns the bytes written
+	size_t commit();
+
+	// Every edit of the save, the first applied() ones are in effect
+	const std::vector<JournalEntry>& entries() const { return history; }
+	size_t applied() const { return appliedCount; }
+
+	// Edits that are journaled but not written to the save file yet
+	bool hasPendingEdits() const { return data.isDirty(); }
+
+	// Edits, undos and redos that were never saved in a journal that was moved to 'path'.old because the save changed
+	// behind its back (0 if the journal was used or had everything saved)
+	size_t discardedEdits() const { return discarded; }
+
+private:
+	struct Run {
+		uint32_t offset;
+		uint16_t length;
+		size_t bytes; // Old bytes, followed by the new bytes, in runBytes
+	};
+
+	SaveBuffer& data;
+	std::string journalPath;
+	int fd = -1;
+	std::vector<JournalEntry> history;
+	std::vector<Run> runs;
+	std::vector<unsigned char> runBytes;
+	size_t appliedCount = 0;
+	size_t discarded = 0;
+	std::vector<unsigned char> journaled; // Save contents as of the last record
+
+	void load();
+	void dropUndone();
+	void applyRecord(std::span<const unsigned char> payload, unsigned char* state);
+	void applyEntry(const JournalEntry& entry, bool redoing);
+	void append(const std::vector<unsigned char>& payload);
+};
+
+
+// - - - Synthetic Save Generator - - - //
+
+inline constexpr int generatedSaveSize = 0x80000;
+
+// Random numbers for the generator, two LCG calls per 32 bit value
+struct SaveGeneratorRandom {
+	uint32_t seed;
+	uint32_t next(){
+		seed = lcgNext(seed);
+		uint32_t high = seed >> 16;
+		seed = lcgNext(seed);
+		return (high << 16) | (seed >> 16);
+	}
+	uint32_t below(uint32_t limit){ return next() % limit; }
+};
+
+// Fill 'record' (decoded, 136 bytes) with a random pokemon owned by 'tid'/'sid'
+void generatePokemon(SaveGeneratorRandom& rng, unsigned char* record, uint16_t tid, uint16_t sid);
+
+// Generate a complete save image for 'version', the same version and seed always give the same image
+std::vector<unsigned char> generateSave(int version, uint32_t seed, int boxFillPercent = 50);
+
+#endif
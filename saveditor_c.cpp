@@ -0,0 +1,220 @@
+/*
+	Notes:
+		 -> C interface of libsaveditor (saveditor_c.h), a thin layer over the C++ functions
+		 -> Exceptions never cross the interface, they are turned into a status code and the message is kept in the handle
+*/
+
+#include <new>
+
+#include "saveditor.h"
+#include "saveditor_c.h"
+
+using namespace std;
+
+// - - - Handle - - - //
+
+#define pseErrorSize 256
+
+struct pse_save {
+	SaveBuffer data;
+	int version = -1;
+	int block = 0;
+	mutable char error[pseErrorSize] = "";
+};
+
+static pse_status toStatus(SaveErrorCode code){
+	switch(code){
+		case SaveErrorCode::none: return PSE_OK;
+		case SaveErrorCode::fileError: return PSE_FILE_ERROR;
+		case SaveErrorCode::invalidSave: return PSE_INVALID_SAVE;
+		case SaveErrorCode::invalidArgument: return PSE_INVALID_ARGUMENT;
+		case SaveErrorCode::notFound: return PSE_NOT_FOUND;
+	}
+	return PSE_INTERNAL_ERROR;
+}
+
+static void setError(const pse_save* save, const char* message){
+	size_t length = min(strlen(message), (size_t)pseErrorSize - 1);
+	memcpy(save->error, message, length);
+	save->error[length] = 0;
+}
+
+// Run 'f' for 'save' and turn whatever it throws into a status
+template <typename F>
+static pse_status guard(const pse_save* save, F&& f){
+	if(!save){ return PSE_INVALID_ARGUMENT; }
+	save->error[0] = 0;
+	try{
+		f();
+		return PSE_OK;
+	}
+	catch(const SaveError& e){
+		setError(save, e.what());
+		return toStatus(e.code());
+	}
+	catch(const bad_alloc&){
+		setError(save, "out of memory");
+		return PSE_OUT_OF_MEMORY;
+	}
+	catch(const exception& e){
+		setError(save, e.what());
+		return PSE_INTERNAL_ERROR;
+	}
+}
+
+static void requireSave(const pse_save* save){
+	if(save->version < 0){
+		throw SaveError(SaveErrorCode::invalidArgument, "no save attached");
+	}
+}
+
+static string_view requireText(const char* text){
+	if(!text){
+		throw SaveError(SaveErrorCode::invalidArgument, "missing name");
+	}
+	return string_view(text);
+}
+
+// Check the version and find the current block of a freshly attached or opened save
+static void loadSave(pse_save* save, int version){
+	if(version < diamond || version > heartgold){
+		save->data.close();
+		throw SaveError(SaveErrorCode::invalidArgument, "unknown version");
+	}
+	try{
+		save->block = getCurBlock(save->data, version);
+		save->version = version;
+	}
+	catch(...){
+		save->data.close();
+		throw;
+	}
+}
+
+// Decode the party once, apply the edit to one slot (or all of them) and write it back with one checksum update
+static void editPartySlot(pse_save* save, int partySlot, string_view pokemonName, string_view abilityName, string_view moveName, int moveSlot, int option){
+	requireSave(save);
+	Party party(save->data, save->block, save->version);
+	if(partySlot == PSE_WHOLE_PARTY){
+		editParty(party, pokemonName, abilityName, moveName, moveSlot, option);
+	}
+	else{
+		if(partySlot < 0 || partySlot >= party.count()){
+			throw SaveError(SaveErrorCode::invalidArgument, "invalid party slot");
+		}
+		PokemonRecord view = party.at(partySlot);
+		editPokemon(view, pokemonName, abilityName, moveName, moveSlot, option);
+	}
+	party.commit();
+	updateSmallBlockChecksum(save->data, save->block, save->version);
+}
+
+
+// - - - C Interface - - - //
+
+extern "C" {
+
+pse_status pse_save_create(pse_save** out){
+	if(!out){ return PSE_INVALID_ARGUMENT; }
+	*out = new(nothrow) pse_save;
+	return *out ? PSE_OK : PSE_OUT_OF_MEMORY;
+}
+
+void pse_save_destroy(pse_save* save){
+	delete save;
+}
+
+pse_status pse_save_attach(pse_save* save, uint8_t* data, size_t size, int version){
+	return guard(save, [&](){
+		save->version = -1;
+		if(!data){ throw SaveError(SaveErrorCode::invalidArgument, "missing save data"); }
+		save->data.borrow(span<unsigned char>(data, size));
+		loadSave(save, version);
+	});
+}
+
+pse_status pse_save_open(pse_save* save, const char* path, int version){
+	return guard(save, [&](){
+		save->version = -1;
+		if(!path){ throw SaveError(SaveErrorCode::invalidArgument, "missing path"); }
+		readFile(path, save->data);
+		loadSave(save, version);
+	});
+}
+
+pse_status pse_save_commit(pse_save* save){
+	return guard(save, [&](){
+		requireSave(save);
+		if(save->data.path().empty()){
+			save->data.markClean();
+			return;
+		}
+		save->data.commit();
+	});
+}
+
+const char* pse_save_error(const pse_save* save){
+	return save ? save->error : "";
+}
+
+const char* pse_status_string(pse_status status){
+	switch(status){
+		case PSE_OK: return "ok";
+		case PSE_FILE_ERROR: return "file error";
+		case PSE_INVALID_SAVE: return "invalid save file";
+		case PSE_INVALID_ARGUMENT: return "invalid argument";
+		case PSE_NOT_FOUND: return "not found";
+		case PSE_OUT_OF_MEMORY: return "out of memory";
+		case PSE_INTERNAL_ERROR: return "internal error";
+	}
+	return "unknown status";
+}
+
+pse_status pse_current_block(const pse_save* save, int* block){
+	return guard(save, [&](){
+		requireSave(save);
+		if(!block){ throw SaveError(SaveErrorCode::invalidArgument, "missing output"); }
+		*block = save->block;
+	});
+}
+
+pse_status pse_party_count(const pse_save* save, int* count){
+	return guard(save, [&](){
+		requireSave(save);
+		if(!count){ throw SaveError(SaveErrorCode::invalidArgument, "missing output"); }
+		*count = getPartyCount(save->data, save->block, save->version);
+	});
+}
+
+pse_status pse_set_player_name(pse_save* save, const char* trainerName){
+	return guard(save, [&](){
+		requireSave(save);
+		changePlayerName(save->data, requireText(trainerName), save->block, save->version);
+	});
+}
+
+pse_status pse_set_species(pse_save* save, int partySlot, const char* speciesName){
+	return guard(save, [&](){ editPartySlot(save, partySlot, requireText(speciesName), "", "", 0, 1); });
+}
+
+pse_status pse_set_ability(pse_save* save, int partySlot, const char* abilityName){
+	return guard(save, [&](){ editPartySlot(save, partySlot, "", requireText(abilityName), "", 0, 2); });
+}
+
+pse_status pse_set_move(pse_save* save, int partySlot, int moveSlot, const char* moveName){
+	return guard(save, [&](){ editPartySlot(save, partySlot, "", "", requireText(moveName), moveSlot, 3); });
+}
+
+pse_status pse_make_shiny(pse_save* save, int partySlot){
+	return guard(save, [&](){ editPartySlot(save, partySlot, "", "", "", 0, 4); });
+}
+
+pse_status pse_restore_pp(pse_save* save, int partySlot){
+	return guard(save, [&](){ editPartySlot(save, partySlot, "", "", "", 0, 5); });
+}
+
+int pse_species_id(const char* name){ return name ? getSpeciesID(name) : 0; }
+int pse_ability_id(const char* name){ return name ? getAbilityID(name) : 0; }
+int pse_move_id(const char* name){ return name ? getMoveID(name) : 0; }
+
+}
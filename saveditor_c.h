@@ -0,0 +1,76 @@
+/*
+	Notes:
+		 -> C interface of libsaveditor, for programs that embed the editor instead of running it
+		 -> A pse_save edits a save buffer owned by the caller in place (nothing is copied), or a file it maps itself
+		 -> Functions return PSE_OK or an error code, pse_save_error() describes the last error of a handle
+		 -> Creating a handle allocates once, editing the party of an attached buffer does not allocate
+*/
+
+#ifndef SAVEDITOR_C_H
+#define SAVEDITOR_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	PSE_OK = 0,
+	PSE_FILE_ERROR = 1, /* The file could not be read, written or rolled back */
+	PSE_INVALID_SAVE = 2, /* The data is not a (usable) save file of the given version */
+	PSE_INVALID_ARGUMENT = 3, /* Unknown name, slot out of range, text the game can't display, ... */
+	PSE_NOT_FOUND = 4, /* A search had no result (e.g. no shiny PV keeps the nature) */
+	PSE_OUT_OF_MEMORY = 5,
+	PSE_INTERNAL_ERROR = 6
+} pse_status;
+
+/* Same values as the version labels of saveditor.h */
+#define PSE_DIAMOND_PEARL 0
+#define PSE_PLATINUM 1
+#define PSE_HEARTGOLD_SOULSILVER 2
+
+/* Party slots are counted from 0, PSE_WHOLE_PARTY applies an edit to every pokemon in the party */
+#define PSE_WHOLE_PARTY -1
+
+typedef struct pse_save pse_save;
+
+pse_status pse_save_create(pse_save** out);
+void pse_save_destroy(pse_save* save);
+
+/* Edit 'size' bytes at 'data' in place, 'data' has to stay valid until the next attach/open or destroy */
+pse_status pse_save_attach(pse_save* save, uint8_t* data, size_t size, int version);
+
+/* Map the save file at 'path', edits are written back by pse_save_commit() */
+pse_status pse_save_open(pse_save* save, const char* path, int version);
+
+/* Write the edits of an opened file back (only the modified bytes), nothing to do for attached buffers */
+pse_status pse_save_commit(pse_save* save);
+
+/* Message of the last error of 'save', empty if the last call succeeded */
+const char* pse_save_error(const pse_save* save);
+const char* pse_status_string(pse_status status);
+
+/* Current small block (1 or 2) and party size */
+pse_status pse_current_block(const pse_save* save, int* block);
+pse_status pse_party_count(const pse_save* save, int* count);
+
+/* Edits of the current small block, every call re-encrypts the edited pokemon and updates the block checksum */
+pse_status pse_set_player_name(pse_save* save, const char* trainerName);
+pse_status pse_set_species(pse_save* save, int partySlot, const char* speciesName);
+pse_status pse_set_ability(pse_save* save, int partySlot, const char* abilityName);
+pse_status pse_set_move(pse_save* save, int partySlot, int moveSlot, const char* moveName);
+pse_status pse_make_shiny(pse_save* save, int partySlot);
+pse_status pse_restore_pp(pse_save* save, int partySlot);
+
+/* Look ups of the game data tables, 0 if the name is unknown */
+int pse_species_id(const char* name);
+int pse_ability_id(const char* name);
+int pse_move_id(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,236 @@
+/*
+	Notes:
+		 -> Built and run by 'make check'
+		 -> Every kernel the library picks at runtime is compared against its portable reference on random input,
+		    kernels the CPU doesn't support are skipped
+		 -> The random seed is printed and can be passed as the first argument to repeat a run
+*/
+
+#include <iostream>
+#include <random>
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "saveditor.h"
+#include "saveditor_internal.h"
+
+using namespace std;
+
+// Mismatches printed per check, the rest are only counted
+#define maxReports 10
+
+struct CheckResult {
+	string name;
+	size_t cases = 0;
+	size_t failures = 0;
+
+	void fail(const string& what){
+		if(failures++ < maxReports){ cout << "FAIL " << name << ": " << what << endl; }
+	}
+};
+
+
+// - - - Encryption Kernel Checks - - - //
+
+using PrngKernel = void (*)(unsigned char*, uint32_t, size_t);
+
+// Lengths every kernel is run on: everything up to a few vector widths (odd lengths and lengths shorter than one
+// vector included), the record sizes the library encrypts, and random lengths
+vector<size_t> prngLengths(mt19937& rng){
+	vector<size_t> lengths;
+	for(size_t n = 0; n <= 100; n++){ lengths.push_back(n); }
+	for(size_t n : {128, 129, 200, 255, 256, 257}){ lengths.push_back(n); }
+	uniform_int_distribution<size_t> length(0, 4096);
+	for(int i = 0; i < 200; i++){ lengths.push_back(length(rng)); }
+	return lengths;
+}
+
+// Run 'kernel' and prngScalar on the same random bytes with random seeds, the kernel writes at 'offset' so unaligned
+// buffers are covered, the bytes around it must not change
+void checkPrngKernel(CheckResult& result, PrngKernel kernel, mt19937& rng){
+	uniform_int_distribution<int> byte(0, 255);
+	uniform_int_distribution<size_t> offset(0, 31);
+	for(size_t n : prngLengths(rng)){
+		for(int round = 0; round < 8; round++){
+			uint32_t seed = rng();
+			size_t start = offset(rng);
+			vector<unsigned char> expected(start + n + 32);
+			for(unsigned char& b : expected){ b = byte(rng); }
+			vector<unsigned char> actual = expected;
+
+			prngScalar(expected.data() + start, seed, n);
+			kernel(actual.data() + start, seed, n);
+			result.cases++;
+			if(actual != expected){
+				result.fail("length " + to_string(n) + ", offset " + to_string(start) + ", seed " + to_string(seed));
+			}
+		}
+	}
+}
+
+// prngBatch against one prngScalar call per record, for batch sizes 0 - 16 and strides at and past the record length
+void checkPrngBatch(CheckResult& result, mt19937& rng){
+	uniform_int_distribution<int> byte(0, 255);
+	uniform_int_distribution<size_t> gap(0, 40);
+	for(size_t n : prngLengths(rng)){
+		if(n > 512){ continue; }
+		for(size_t records = 0; records <= 16; records++){
+			size_t stride = n + gap(rng);
+			vector<uint32_t> seeds(records);
+			for(uint32_t& seed : seeds){ seed = rng(); }
+			vector<unsigned char> expected(records * stride + n + 1);
+			for(unsigned char& b : expected){ b = byte(rng); }
+			vector<unsigned char> actual = expected;
+
+			for(size_t r = 0; r < records; r++){ prngScalar(expected.data() + r * stride, seeds[r], n); }
+			prngBatch(actual.data(), stride, seeds.data(), records, n);
+			result.cases++;
+			if(actual != expected){
+				result.fail("length " + to_string(n) + ", " + to_string(records) + " records, stride " + to_string(stride));
+			}
+		}
+	}
+}
+
+vector<CheckResult> checkPrng(mt19937& rng){
+	vector<CheckResult> results;
+	vector<pair<string, PrngKernel>> kernels;
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("sse4.1")){ kernels.push_back({"prngSse41", prngSse41}); }
+	if(__builtin_cpu_supports("avx2")){ kernels.push_back({"prngAvx2", prngAvx2}); }
+#endif
+	kernels.push_back({"prng", prng});
+	for(const auto& [name, kernel] : kernels){
+		results.push_back({name});
+		checkPrngKernel(results.back(), kernel, rng);
+	}
+	results.push_back({"prngBatch"});
+	checkPrngBatch(results.back(), rng);
+	return results;
+}
+
+
+// - - - Checksum Kernel Checks - - - //
+
+using CrcKernel = uint16_t (*)(span<const unsigned char>, uint16_t);
+
+// Bit at a time CRC-16-CCITT, the reference the table and folding kernels are checked against
+uint16_t crc16Bytewise(span<const unsigned char> chunk, uint16_t crc){
+	for(unsigned char b : chunk){
+		crc ^= b << 8;
+		for(int bit = 0; bit < 8; bit++){
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+// Every length up to 300 (0 - 15, below the 128 byte folding threshold, and every remainder of the 16 and 64 byte
+// fold widths), the small and big block sizes, and random lengths, each at 16 different buffer alignments
+// 'randomInit' continues from random checksums half of the time instead of always starting at 0xffff
+void checkCrcKernel(CheckResult& result, CrcKernel kernel, bool randomInit, mt19937& rng){
+	vector<size_t> lengths;
+	for(size_t n = 0; n <= 300; n++){ lengths.push_back(n); }
+	for(size_t n : {DpLayout::smallLength, DpLayout::bigLength, PtLayout::smallLength, PtLayout::bigLength, HgssLayout::smallLength, HgssLayout::bigLength}){
+		lengths.push_back(n);
+	}
+	uniform_int_distribution<size_t> length(0, 0x20000);
+	for(int i = 0; i < 20; i++){ lengths.push_back(length(rng)); }
+
+	uniform_int_distribution<int> byte(0, 255);
+	vector<unsigned char> buffer(0x20000 + 16);
+	for(unsigned char& b : buffer){ b = byte(rng); }
+	for(size_t n : lengths){
+		for(size_t offset = 0; offset < 16; offset++){
+			span<const unsigned char> chunk(buffer.data() + offset, n);
+			uint16_t init = (randomInit && (offset & 1)) ? rng() & 0xffff : 0xffff;
+			result.cases++;
+			if(kernel(chunk, init) != crc16Bytewise(chunk, init)){
+				result.fail("length " + to_string(n) + ", offset " + to_string(offset) + ", initial value " + to_string(init));
+			}
+		}
+	}
+}
+
+vector<CheckResult> checkCrc(mt19937& rng){
+	vector<CheckResult> results;
+	vector<pair<string, CrcKernel>> kernels = {{"crc16Table", crc16Table}};
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")){ kernels.push_back({"crc16Clmul", crc16Clmul}); }
+#endif
+	for(const auto& [name, kernel] : kernels){
+		results.push_back({name});
+		checkCrcKernel(results.back(), kernel, true, rng);
+	}
+
+	// The dispatched entry point always starts at 0xffff
+	results.push_back({"crc16ccitt"});
+	checkCrcKernel(results.back(), [](span<const unsigned char> chunk, uint16_t){ return (uint16_t)crc16ccitt(chunk); }, false, rng);
+	return results;
+}
+
+
+// - - - Name Table Checks - - - //
+
+// Every name of a table has no surrounding whitespace and looks up its own ID, 'getID' may be null (natures)
+void checkNameTable(CheckResult& result, int count, string_view (*getName)(int), int (*getID)(string_view)){
+	for(int id = 1; id <= count; id++){
+		string_view name = getName(id);
+		result.cases++;
+		if(name.empty() || isspace((unsigned char)name.front()) || isspace((unsigned char)name.back())){
+			result.fail("ID " + to_string(id) + " is '" + string(name) + "'");
+		}
+		else if(getID && getID(name) != id){
+			result.fail("'" + string(name) + "' looks up ID " + to_string(getID(name)) + " instead of " + to_string(id));
+		}
+	}
+}
+
+// Names with spaces and punctuation against their IDs in the games, a name cut short still looks up its own ID
+void checkKnownNames(CheckResult& result){
+	struct KnownName { string_view name; int id; int (*getID)(string_view); };
+	const KnownName known[] = {
+		{"Vine Whip", 22, getMoveID}, {"Double Kick", 24, getMoveID}, {"Volt Tackle", 344, getMoveID}, {"U-turn", 369, getMoveID},
+		{"Mr. Mime", 122, getSpeciesID}, {"Farfetch'd", 83, getSpeciesID}, {"Mime Jr.", 439, getSpeciesID}, {"Snorunt", 361, getSpeciesID},
+		{"Speed Boost", 3, getAbilityID}, {"Bad Dreams", 123, getAbilityID}
+	};
+	for(const KnownName& k : known){
+		result.cases++;
+		if(k.getID(k.name) != k.id){
+			result.fail("'" + string(k.name) + "' looks up ID " + to_string(k.getID(k.name)) + " instead of " + to_string(k.id));
+		}
+	}
+}
+
+vector<CheckResult> checkNames(){
+	vector<CheckResult> results = {{"species names"}, {"ability names"}, {"move names"}, {"nature names"}, {"known names"}};
+	checkNameTable(results[0], getSpeciesCount(), getSpeciesName, getSpeciesID);
+	checkNameTable(results[1], getAbilityCount(), getAbilityName, getAbilityID);
+	checkNameTable(results[2], getMoveCount(), getMoveName, getMoveID);
+	checkNameTable(results[3], size(natureNames), [](int id){ return natureNames[id - 1]; }, nullptr);
+	checkKnownNames(results[4]);
+	return results;
+}
+
+
+int main(int argc, char *argv[]){
+	uint32_t seed = (argc > 1) ? strtoul(argv[1], nullptr, 0) : random_device()();
+	cout << "Seed: " << seed << endl;
+	mt19937 rng(seed);
+
+	vector<CheckResult> results = checkPrng(rng);
+	for(CheckResult& r : checkCrc(rng)){ results.push_back(move(r)); }
+	for(CheckResult& r : checkNames()){ results.push_back(move(r)); }
+
+	size_t failures = 0;
+	for(const CheckResult& r : results){
+		cout << (r.failures ? "FAIL " : "ok   ") << r.name << ": " << r.cases << " cases";
+		if(r.failures){ cout << ", " << r.failures << " failed"; }
+		cout << endl;
+		failures += r.failures;
+	}
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
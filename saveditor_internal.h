@@ -0,0 +1,205 @@
+/*
+	Notes:
+		 -> Offset tables and labels of the save format, shared by libsaveditor and the saveditor front end
+		 -> Not part of the library interface (saveditor.h): the labels are plain macros with common names
+*/
+
+#ifndef SAVEDITOR_INTERNAL_H
+#define SAVEDITOR_INTERNAL_H
+
+#include "saveditor.h"
+
+// - - - Lables for ease of use - - - //
+
+// General Offset Lables
+#define trainerNameOffset 0
+#define trainerId 1
+#define secretId 2
+#define smallBlockChecksumOffset 3
+#define checksumValueOffset 4
+#define leadPokemonOffset 5
+#define totalTime 6
+#define bigBlockOffset 7
+#define bigBlockChecksumOffset 8
+#define bigChecksumValueOffset 9
+#define boxDataOffset 10
+#define boxSize 11
+
+// Pokemon Data Structure Offset Lables
+#define personalityValueOffset 0
+#define skipPokemonChecksumOffset 1
+#define pokemonChecksumOffset 2
+#define speciesID 3
+#define heldItem 4
+#define otid 5
+#define otSecretID 6
+#define ability 7
+#define moveset 8
+#define movePP 9
+#define movePPup 10
+#define IVs 11
+#define nickname 12
+
+// --- Block Addresses --- //
+
+/* Notes:
+	-> Small block contains trainer data (name, id, money etc) and party pokemon data (species, ability, EVs, etc)
+	-> Big blocks contain data of pokemon stored in the PC boxes, they start right after the small block
+	   (bigBlockOffset, relative to the small block of the same save slot)
+	-> Each block ends with a footer, the first 4 bytes of it are a save counter and the last 2 bytes the checksum
+*/
+inline constexpr int smallBlock1 = 0x00000;
+inline constexpr int smallBlock2 = 0x40000;
+
+
+// --- Small and Big Block Offsets for each version --- //
+
+// Offsets for Diamond and Pearl versions
+inline constexpr int dp[] = {
+	0x64, // trainerNameOffset
+	0x74, // trainerID
+	0x76, // secretID
+	0xc0ec, // smallBlockChecksumOffset
+	0xc0fe, // checksumValueOffset
+	0x98, // leadPokemonOffset
+	0x86, // totalTime - hours: 16bits; minutes: 8bits; seconds: 8bits
+	0xc100, // bigBlockOffset
+	0x121cc, // bigBlockChecksumOffset
+	0x121de, // bigChecksumValueOffset
+	0x04, // boxDataOffset
+	0xff0 // boxSize - 30 pokemon records
+};
+
+// Offsets for Platinum versions
+inline constexpr int p[] = {
+	0x68, // trainerNameOffset
+	0x78, // trainerID
+	0x7a, // secretID
+	0xcf18, // smallBlockChecksumOffset
+	0xcf2a, // checksumValueOffset
+	0xa0, // leadPokemonOffset
+	0x8a, // totalTime - hours: 16bits; minutes: 8bits; seconds: 8bits
+	0xcf2c, // bigBlockOffset
+	0x121d0, // bigBlockChecksumOffset
+	0x121e2, // bigChecksumValueOffset
+	0x04, // boxDataOffset
+	0xff0 // boxSize - 30 pokemon records
+};
+
+// Offsets for Heartgold and Soulsilver versions
+inline constexpr int hgss[] = {
+	0x64, // trainerNameOffset
+	0x74, // trainerID
+	0x76, // secretID
+	0xf618, // smallBlockChecksumOffset
+	0xf626, // checksumValueOffset
+	0x98, // leadPokemonOffset
+	0x86, // totalTime - hours: 16bits; minutes: 8bits; seconds: 8bits
+	0xf700, // bigBlockOffset
+	0x12300, // bigBlockChecksumOffset
+	0x1230e, // bigChecksumValueOffset
+	0x00, // boxDataOffset
+	0x1000 // boxSize - 30 pokemon records padded to 0x1000 bytes
+};
+
+// - - - Mapping version names to respective offsets - - - //
+inline constexpr const int* versionNames[] = { {dp}, {p}, {hgss} };
+static_assert(sizeof(versionNames) / sizeof(versionNames[0]) == versionProfileCount, "one offset table per version profile");
+
+
+// - - - Offsets for the Pokemon data structure - - - //
+inline constexpr int pokemon[] = {
+
+	// Unencrypted Pokemon block offsets
+	0x00, // personalityValueOffset
+	0x04, // skipPokemonChecksumOffset ( "Bit 0-1: If set, skip checksum checks" ( <- this does not seem to work); "Bit 2: Bad egg flag"; )
+	0x06, // pokemonChecksumOffset
+
+	// Encrypted Pokemon block offsets
+
+	// Block A
+	0x08, // speciesID
+	0x0a, // heldItem
+	0x0c, // otid
+	0x0e, // otSecretID
+	0x15, // ability
+
+	// Block B (untested)
+	0x08, // moveset (8 bytes)
+	0x10, // Move PP (4 bytes)
+	0x14, // Move PP ups (4 bytes)
+	0x18, // IVs (4 bytes)
+
+	// Block C
+	0x08 // nickname (0x08 - 0x1d)
+};
+
+// Offset of 'field' (see the pokemon[] offset labels) inside a decoded record, 'dataBlock' is 0 for A up to 3 for D
+constexpr size_t getFieldOffset(int dataBlock, int field){
+	return 0x08 + dataBlock * pokemonDataBlockSize + (pokemon[field] - 0x08);
+}
+
+// PokemonRecord reads the decoded record through its own copy of these offsets
+static_assert(PokemonRecord::flagsPos == pokemon[skipPokemonChecksumOffset]
+	&& PokemonRecord::speciesPos == getFieldOffset(0, speciesID) && PokemonRecord::itemPos == getFieldOffset(0, heldItem)
+	&& PokemonRecord::otIdPos == getFieldOffset(0, otid) && PokemonRecord::otSecretIdPos == getFieldOffset(0, otSecretID)
+	&& PokemonRecord::abilityPos == getFieldOffset(0, ability) && PokemonRecord::movesPos == getFieldOffset(1, moveset)
+	&& PokemonRecord::ppPos == getFieldOffset(1, movePP) && PokemonRecord::ppUpsPos == getFieldOffset(1, movePPup)
+	&& PokemonRecord::ivsPos == getFieldOffset(1, IVs) && PokemonRecord::nicknamePos == getFieldOffset(2, nickname),
+	"PokemonRecord field offsets don't match the pokemon[] table");
+
+
+// - - - Version Layouts - - - //
+
+/* Notes:
+	-> VersionLayout turns one of the offset tables into compile-time constants: code that walks many records is
+	   written once as a template over the layout and instantiated for every version, so the offsets fold into the loops
+	-> A save slot is passed as the offset of its small block (see getSmallBlockOffset), looked up once per file
+	-> withVersionLayout picks the layout of a version at runtime, call it once per file and not per record
+*/
+
+// Offset of small block 'block' (1 or 2) in the save file
+inline size_t getSmallBlockOffset(int block){
+	if(block == 1){ return smallBlock1; }
+	if(block == 2){ return smallBlock2; }
+	throw SaveError(SaveErrorCode::invalidArgument, "invalid save slot");
+}
+
+template <const int* Offsets>
+struct VersionLayout {
+	static constexpr size_t smallLength = Offsets[smallBlockChecksumOffset]; // Checksummed part, the footer starts here
+	static constexpr size_t bigLength = Offsets[bigBlockChecksumOffset];
+	static constexpr size_t saveSize = smallBlock2 + Offsets[bigBlockOffset] + Offsets[bigChecksumValueOffset] + 2; // Both save slots
+
+	// Offsets in the small block at 'small'
+	static constexpr size_t trainerName(size_t small){ return small + Offsets[trainerNameOffset]; }
+	static constexpr size_t trainerIdPos(size_t small){ return small + Offsets[trainerId]; }
+	static constexpr size_t secretIdPos(size_t small){ return small + Offsets[secretId]; }
+	static constexpr size_t playTime(size_t small){ return small + Offsets[totalTime]; }
+	static constexpr size_t partyCount(size_t small){ return small + Offsets[leadPokemonOffset] - 4; }
+	static constexpr size_t partySlot(size_t small, int slot){ return small + Offsets[leadPokemonOffset] + slot * pokemonPartyRecordSize; }
+	static constexpr size_t smallChecksum(size_t small){ return small + Offsets[checksumValueOffset]; }
+
+	// Offsets in the big block of the save slot whose small block is at 'small'
+	static constexpr size_t bigBlock(size_t small){ return small + Offsets[bigBlockOffset]; }
+	static constexpr size_t bigCounter(size_t big){ return big + Offsets[bigBlockChecksumOffset]; }
+	static constexpr size_t bigChecksum(size_t big){ return big + Offsets[bigChecksumValueOffset]; }
+	static constexpr size_t boxSlot(size_t big, int box, int slot){ return big + Offsets[boxDataOffset] + box * Offsets[boxSize] + slot * pokemonRecordSize; }
+};
+
+using DpLayout = VersionLayout<dp>;
+using PtLayout = VersionLayout<p>;
+using HgssLayout = VersionLayout<hgss>;
+
+// Call 'f' with the layout of 'version' (an empty object, its members are static)
+template <typename F>
+decltype(auto) withVersionLayout(int version, F&& f){
+	switch(version){
+		case diamond: return f(DpLayout());
+		case platinum: return f(PtLayout());
+		case heartgold: return f(HgssLayout());
+	}
+	throw SaveError(SaveErrorCode::invalidArgument, "unknown version");
+}
+
+#endif